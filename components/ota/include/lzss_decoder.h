@@ -0,0 +1,65 @@
+#include "stdbool.h"
+#include "stddef.h"
+#include "string.h"
+
+#ifndef LZSS_DECODER
+#define LZSS_DECODER
+
+#define LZSS_MAGIC                "LZS1"
+#define LZSS_FILE_HEADER_SIZE     8
+#define LZSS_BLOCK_HEADER_SIZE    2
+#define LZSS_BLOCK_SIZE           4096
+#define LZSS_STORED_BLOCK_FLAG    0x8000
+#define LZSS_MIN_MATCH_LENGTH     3
+
+typedef enum {
+   LZSS_DECODER_FILE_HEADER = 0,
+   LZSS_DECODER_BLOCK_HEADER,
+   LZSS_DECODER_STORED_DATA,
+   LZSS_DECODER_COMPRESSED_DATA,
+   LZSS_DECODER_ERROR
+} lzss_decoder_state_t;
+
+/**
+ * Streaming decoder of the compressed firmware image. Memory is bounded by one block of the decoded data.
+ *
+ * Format (numbers are little endian): "LZS1", u32 length of the original image, then blocks. Block: u16 header -
+ * payload length | LZSS_STORED_BLOCK_FLAG if the payload is the plain data, then the payload. Every block decodes
+ * independently of the others to LZSS_BLOCK_SIZE bytes (the last one to the rest of the image), so a download can be
+ * resumed from any block with the decoded data aligned to the flash sectors.
+ * LZSS payload: flags byte for the next 8 items (LSB first), 1 - literal byte, 0 - match of 2 bytes:
+ * (d & 0xFF), ((d >> 8) << 4 | l), where d = distance - 1 (1..4096 bytes back), l = length - LZSS_MIN_MATCH_LENGTH.
+ * Matches refer only to the data of the same block.
+ */
+typedef struct lzss_decoder {
+   lzss_decoder_state_t state;
+   unsigned char header[LZSS_FILE_HEADER_SIZE];
+   unsigned char header_position;
+   // 0 if the decoding has been resumed from a block
+   unsigned int image_length;
+   // Decoded bytes of the completed blocks
+   unsigned int decoded_length;
+   // Position in the compressed file after the consumed bytes
+   unsigned int input_position;
+
+   unsigned short payload_remaining;
+   unsigned short block_position;
+   unsigned char flags;
+   unsigned char flags_remaining;
+   unsigned char match_first_byte;
+   bool match_first_byte_read;
+   unsigned char *block;
+
+   void (*on_block)(struct lzss_decoder *decoder, const unsigned char *data, size_t length);
+   void *context;
+} lzss_decoder_t;
+
+void lzss_decoder_init(lzss_decoder_t *decoder, unsigned char block[LZSS_BLOCK_SIZE],
+                       void (*on_block)(lzss_decoder_t *decoder, const unsigned char *data, size_t length),
+                       void *context);
+void lzss_decoder_resume(lzss_decoder_t *decoder, unsigned int input_position, unsigned int decoded_length);
+size_t lzss_decoder_execute(lzss_decoder_t *decoder, const unsigned char *data, size_t length);
+bool lzss_decoder_is_complete(const lzss_decoder_t *decoder);
+bool lzss_decoder_is_error(const lzss_decoder_t *decoder);
+
+#endif
@@ -7,36 +7,73 @@
 #include "event_groups.h"
 
 #include "utils.h"
+#include "number_formatter.h"
+#include "http_response_parser.h"
+#include "spi_flash.h"
+#include "mbedtls/sha256.h"
+#include "lzss_decoder.h"
+#include "execution_time_monitor.h"
 
 #include "sys/socket.h"
 
-#define BUFFSIZE 1500
 #define TEXT_BUFFSIZE 1024
+// Chunk of the resumed part, which is read back from the flash to restore the digest
+#define OTA_FLASH_READ_SIZE 256
 
-typedef enum esp_ota_firm_state {
-   ESP_OTA_INIT = 0,
-   ESP_OTA_PREPARE,
-   ESP_OTA_START,
-   ESP_OTA_RECVED,
-   ESP_OTA_FINISH,
-} esp_ota_firm_state_t;
+#ifdef USE_COMPRESSED_FIRMWARE
+#define FIRMWARE_FILE_NAME "firmware.bin.lzs"
+#else
+#define FIRMWARE_FILE_NAME "firmware.bin"
+#endif
 
-typedef struct esp_ota_firm {
-   uint8_t ota_num;
-   uint8_t update_ota_num;
+#define OTA_CHECKPOINT_MAGIC  0xC4
+#define OTA_CHECKPOINT_BLOCKS 6
+// The last blocks of the RTC user memory, the rest is used by main
+#ifndef OTA_CHECKPOINT_RTC_ADDRESS
+#define OTA_CHECKPOINT_RTC_ADDRESS (192 - OTA_CHECKPOINT_BLOCKS)
+#endif
 
-   esp_ota_firm_state_t state;
+/**
+ * Progress of the interrupted download, kept in the RTC user memory, so the next update continues with a Range request.
+ * The download offset differs from the written bytes only for the compressed image.
+ *
+ * Layout (6 blocks): u8 magic, u8 checksum of the next 20 bytes, 2 unused; u32 update partition address;
+ * u32 written bytes (flash sector aligned); u32 download offset; u32 downloaded file length; u32 image id (hash of
+ * the ETag).
+ */
+typedef struct {
+   unsigned int partition_address;
+   unsigned int written_bytes;
+   unsigned int download_offset;
+   unsigned int download_length;
+   unsigned int image_id;
+} ota_checkpoint_t;
 
-   size_t content_len;
+// The image being written to the update partition
+typedef struct {
+   const esp_partition_t *partition;
+   ota_checkpoint_t *checkpoint;
+   mbedtls_sha256_context sha256_context;
+   size_t written_bytes;
+   size_t erased_bytes;
+} ota_image_writer_t;
 
-   size_t read_bytes;
-   size_t write_bytes;
+typedef struct esp_ota_firm {
+   uint8_t ota_num;
+   uint8_t update_ota_num;
 
-   size_t ota_size;
-   size_t ota_offset;
+   http_response_parser_t parser;
+   // The response is checked against the checkpoint with the first body bytes
+   bool response_checked;
+   // The resumed response doesn't match the checkpoint, the body is ignored
+   bool restart_required;
+   // Position of the received body in the downloaded file
+   size_t download_offset;
 
-   const char *buf;
-   size_t bytes;
+   ota_image_writer_t writer;
+   #ifdef USE_COMPRESSED_FIRMWARE
+   lzss_decoder_t decoder;
+   #endif
 } esp_ota_firm_t;
 
 // Send GET request to HTTP server
@@ -45,5 +82,11 @@ static const char FIRMWARE_UPDATE_GET_REQUEST[] =
       "Host: <2>\r\n"
       "User-Agent: ESP8266\r\n"
       "Connection: close\r\n\r\n";
+static const char FIRMWARE_UPDATE_RANGE_GET_REQUEST[] =
+      "GET /esp8266_fota/<1> HTTP/1.1\r\n"
+      "Host: <2>\r\n"
+      "User-Agent: ESP8266\r\n"
+      "Range: bytes=<3>-\r\n"
+      "Connection: close\r\n\r\n";
 
 void update_firmware();
@@ -0,0 +1,194 @@
+#include "lzss_decoder.h"
+
+void lzss_decoder_init(lzss_decoder_t *decoder, unsigned char block[LZSS_BLOCK_SIZE],
+                       void (*on_block)(lzss_decoder_t *decoder, const unsigned char *data, size_t length),
+                       void *context) {
+   memset(decoder, 0, sizeof(lzss_decoder_t));
+
+   decoder->state = LZSS_DECODER_FILE_HEADER;
+   decoder->block = block;
+   decoder->on_block = on_block;
+   decoder->context = context;
+}
+
+/**
+ * Continues decoding from the block which starts at input_position of the compressed file.
+ */
+void lzss_decoder_resume(lzss_decoder_t *decoder, unsigned int input_position, unsigned int decoded_length) {
+   decoder->state = LZSS_DECODER_BLOCK_HEADER;
+   decoder->header_position = 0;
+   decoder->image_length = 0;
+   decoder->input_position = input_position;
+   decoder->decoded_length = decoded_length;
+}
+
+static unsigned int read_u32(const unsigned char *data) {
+   return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+static void on_file_header_end(lzss_decoder_t *decoder) {
+   if (memcmp(decoder->header, LZSS_MAGIC, 4) != 0) {
+      decoder->state = LZSS_DECODER_ERROR;
+      return;
+   }
+
+   decoder->image_length = read_u32(decoder->header + 4);
+   decoder->header_position = 0;
+   decoder->state = LZSS_DECODER_BLOCK_HEADER;
+}
+
+static void on_block_header_end(lzss_decoder_t *decoder) {
+   unsigned short header = decoder->header[0] | (decoder->header[1] << 8);
+
+   decoder->header_position = 0;
+   decoder->payload_remaining = header & ~LZSS_STORED_BLOCK_FLAG;
+   decoder->block_position = 0;
+   decoder->flags_remaining = 0;
+   decoder->match_first_byte_read = false;
+
+   // Only the last block may be shorter than LZSS_BLOCK_SIZE, otherwise the blocks aren't aligned to flash sectors
+   if (decoder->payload_remaining == 0 || decoder->decoded_length % LZSS_BLOCK_SIZE != 0 ||
+         (decoder->image_length > 0 && decoder->decoded_length >= decoder->image_length)) {
+      decoder->state = LZSS_DECODER_ERROR;
+   } else if (header & LZSS_STORED_BLOCK_FLAG) {
+      decoder->state = decoder->payload_remaining > LZSS_BLOCK_SIZE ? LZSS_DECODER_ERROR : LZSS_DECODER_STORED_DATA;
+   } else {
+      decoder->state = LZSS_DECODER_COMPRESSED_DATA;
+   }
+}
+
+static void on_block_end(lzss_decoder_t *decoder) {
+   if (decoder->image_length > 0 && decoder->decoded_length + decoder->block_position > decoder->image_length) {
+      decoder->state = LZSS_DECODER_ERROR;
+      return;
+   }
+
+   decoder->decoded_length += decoder->block_position;
+   decoder->state = LZSS_DECODER_BLOCK_HEADER;
+
+   if (decoder->on_block != NULL) {
+      decoder->on_block(decoder, decoder->block, decoder->block_position);
+   }
+}
+
+static void parse_match(lzss_decoder_t *decoder, unsigned char second_byte) {
+   unsigned short distance = (decoder->match_first_byte | ((second_byte >> 4) << 8)) + 1;
+   unsigned char match_length = (second_byte & 0x0F) + LZSS_MIN_MATCH_LENGTH;
+
+   if (distance > decoder->block_position || decoder->block_position + match_length > LZSS_BLOCK_SIZE) {
+      decoder->state = LZSS_DECODER_ERROR;
+      return;
+   }
+
+   // Byte by byte, because the match may overlap the data it produces
+   unsigned char *destination = decoder->block + decoder->block_position;
+
+   for (unsigned char i = 0; i < match_length; i++) {
+      destination[i] = destination[i - distance];
+   }
+   decoder->block_position += match_length;
+}
+
+static void parse_item_byte(lzss_decoder_t *decoder, unsigned char character) {
+   if (decoder->flags_remaining == 0) {
+      decoder->flags = character;
+      decoder->flags_remaining = 8;
+      return;
+   }
+
+   if (decoder->flags & 1) {
+      if (decoder->block_position >= LZSS_BLOCK_SIZE) {
+         decoder->state = LZSS_DECODER_ERROR;
+         return;
+      }
+      decoder->block[decoder->block_position++] = character;
+   } else if (!decoder->match_first_byte_read) {
+      decoder->match_first_byte = character;
+      decoder->match_first_byte_read = true;
+      return;
+   } else {
+      decoder->match_first_byte_read = false;
+      parse_match(decoder, character);
+   }
+
+   decoder->flags >>= 1;
+   decoder->flags_remaining--;
+}
+
+/**
+ * Decodes the received part of the compressed file. Every decoded block is passed to on_block(). Returns the amount of
+ * consumed bytes, which is less than length only on error.
+ */
+size_t lzss_decoder_execute(lzss_decoder_t *decoder, const unsigned char *data, size_t length) {
+   unsigned int input_start_position = decoder->input_position;
+   size_t position = 0;
+
+   while (position < length) {
+      switch (decoder->state) {
+         case LZSS_DECODER_FILE_HEADER:
+            decoder->header[decoder->header_position++] = data[position++];
+
+            if (decoder->header_position == LZSS_FILE_HEADER_SIZE) {
+               on_file_header_end(decoder);
+            }
+            break;
+         case LZSS_DECODER_BLOCK_HEADER:
+            decoder->header[decoder->header_position++] = data[position++];
+
+            if (decoder->header_position == LZSS_BLOCK_HEADER_SIZE) {
+               on_block_header_end(decoder);
+            }
+            break;
+         case LZSS_DECODER_STORED_DATA: {
+            size_t stored_bytes = length - position;
+
+            if (stored_bytes > decoder->payload_remaining) {
+               stored_bytes = decoder->payload_remaining;
+            }
+
+            memcpy(decoder->block + decoder->block_position, data + position, stored_bytes);
+            decoder->block_position += stored_bytes;
+            decoder->payload_remaining -= stored_bytes;
+            position += stored_bytes;
+
+            if (decoder->payload_remaining == 0) {
+               // on_block() may save the position to resume from
+               decoder->input_position = input_start_position + position;
+               on_block_end(decoder);
+            }
+            break;
+         }
+         case LZSS_DECODER_COMPRESSED_DATA:
+            parse_item_byte(decoder, data[position++]);
+            decoder->payload_remaining--;
+
+            if (decoder->state == LZSS_DECODER_COMPRESSED_DATA && decoder->payload_remaining == 0) {
+               if (decoder->match_first_byte_read) {
+                  decoder->state = LZSS_DECODER_ERROR;
+               } else {
+                  decoder->input_position = input_start_position + position;
+                  on_block_end(decoder);
+               }
+            }
+            break;
+         default:
+            // LZSS_DECODER_ERROR
+            decoder->input_position = input_start_position + position;
+            return position;
+      }
+   }
+   decoder->input_position = input_start_position + position;
+   return position;
+}
+
+/**
+ * True if the decoder stopped between blocks and, unless resumed, the whole image has been decoded.
+ */
+bool lzss_decoder_is_complete(const lzss_decoder_t *decoder) {
+   return decoder->state == LZSS_DECODER_BLOCK_HEADER && decoder->header_position == 0 &&
+         (decoder->image_length == 0 ? decoder->decoded_length > 0 : decoder->decoded_length == decoder->image_length);
+}
+
+bool lzss_decoder_is_error(const lzss_decoder_t *decoder) {
+   return decoder->state == LZSS_DECODER_ERROR;
+}
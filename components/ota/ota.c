@@ -1,10 +1,12 @@
 #include "include/ota.h"
 
-// OTA data write buffer ready to write to the flash
-static char ota_write_data[BUFFSIZE + 1] = { 0 };
-// Packet receive buffer
-static char text[BUFFSIZE + 1] = { 0 };
-// Image total length
+// Packet receive buffer, allocated only during the update. The parsed body is written to the flash right from it
+static char *text = NULL;
+#ifdef USE_COMPRESSED_FIRMWARE
+// Decoded block of the compressed image, allocated only during the update
+static unsigned char *decoded_block = NULL;
+#endif
+// Bytes written by this update, a resumed one starts after the checkpoint
 static int binary_file_length = 0;
 // socket id
 static int socket_id = -1;
@@ -17,6 +19,16 @@ static void __attribute__((noreturn)) task_fatal_error() {
    #endif
 
    close(socket_id);
+   if (text != NULL) {
+      FREE(text);
+      text = NULL;
+   }
+   #ifdef USE_COMPRESSED_FIRMWARE
+   if (decoded_block != NULL) {
+      FREE(decoded_block);
+      decoded_block = NULL;
+   }
+   #endif
    (void) vTaskDelete(NULL);
 
    while (1) {}
@@ -25,7 +37,6 @@ static void __attribute__((noreturn)) task_fatal_error() {
 static void esp_ota_firm_init(esp_ota_firm_t *ota_firm, const esp_partition_t *update_partition) {
    memset(ota_firm, 0, sizeof(esp_ota_firm_t));
 
-   ota_firm->state = ESP_OTA_INIT;
    ota_firm->ota_num = get_ota_partition_count();
    ota_firm->update_ota_num = update_partition->subtype - ESP_PARTITION_SUBTYPE_APP_OTA_0;
 
@@ -34,198 +45,154 @@ static void esp_ota_firm_init(esp_ota_firm_t *ota_firm, const esp_partition_t *u
    #endif
 }
 
-// Read buffer by byte still delim, return read bytes counts
-static int read_until(const char *buffer, char delim, int len) {
-   // TODO: delim check,buffer check,further: do an buffer length limited
-   int i = 0;
-   while (buffer[i] != delim && i < len) {
-      ++i;
+static unsigned int calculate_hash(const unsigned char *data, size_t length) {
+   // FNV-1a
+   unsigned int hash = 2166136261U;
+
+   for (size_t i = 0; i < length; i++) {
+      hash = (hash ^ data[i]) * 16777619U;
    }
-   return i + 1;
+   return hash;
 }
 
-static bool _esp_ota_firm_parse_http(esp_ota_firm_t *ota_firm, const char *text, size_t total_len, size_t *parse_len) {
-   // i means current position
-   int i = 0, i_read_len = 0;
-   char *ptr = NULL, *ptr2 = NULL;
-   char length_str[32];
-
-   while (text[i] != 0 && i < total_len) {
-      ptr = (char *) strstr(text, "Content-Length");
-
-      if (ota_firm->content_len == 0 && ptr != NULL) {
-         ptr += 16;
-         ptr2 = (char *) strstr(ptr, "\r\n");
-
-         memset(length_str, 0, sizeof(length_str));
-         memcpy(length_str, ptr, ptr2 - ptr);
-
-         ota_firm->content_len = atoi(length_str);
-
-         ota_firm->ota_size = ota_firm->content_len;
-         ota_firm->ota_offset = 0;
-
-         #ifdef ALLOW_USE_PRINTF
-         printf("Parse Content-Length: %d, ota_size %d", ota_firm->content_len, ota_firm->ota_size);
-         #endif
-      }
-
-      i_read_len = read_until(&text[i], '\n', total_len - i);
-
-      if (i_read_len > total_len - i) {
-         #ifdef ALLOW_USE_PRINTF
-         printf("recv. malformed HTTP header");
-         #endif
-
-         task_fatal_error();
-      }
-
-      // if resolve \r\n line, HTTP header is finished
-      if (i_read_len == 2) {
-         if (ota_firm->content_len == 0) {
-            #ifdef ALLOW_USE_PRINTF
-            printf("Did not parse Content-Length item");
-            #endif
-
-            task_fatal_error();
-         }
+static unsigned char calculate_checkpoint_checksum(const unsigned char stored_checkpoint[OTA_CHECKPOINT_BLOCKS * 4]) {
+   return calculate_hash(stored_checkpoint + 4, OTA_CHECKPOINT_BLOCKS * 4 - 4) & 0xFF;
+}
 
-         *parse_len = i + 2;
+/**
+ * Returns false if there is no valid checkpoint (e.g. after power on).
+ */
+static bool load_checkpoint(ota_checkpoint_t *checkpoint) {
+   unsigned char stored_checkpoint[OTA_CHECKPOINT_BLOCKS * 4];
 
-         return true;
-      }
+   rtc_mem_read(OTA_CHECKPOINT_RTC_ADDRESS, stored_checkpoint, sizeof(stored_checkpoint));
 
-      i += i_read_len;
+   if (stored_checkpoint[0] != OTA_CHECKPOINT_MAGIC ||
+         stored_checkpoint[1] != calculate_checkpoint_checksum(stored_checkpoint)) {
+      return false;
    }
-   return false;
-}
 
-static size_t esp_ota_firm_do_parse_msg(esp_ota_firm_t *ota_firm, const char *in_buf, size_t in_len) {
-   size_t tmp;
-   size_t parsed_bytes = in_len;
+   memcpy(&checkpoint->partition_address, stored_checkpoint + 4, 4);
+   memcpy(&checkpoint->written_bytes, stored_checkpoint + 8, 4);
+   memcpy(&checkpoint->download_offset, stored_checkpoint + 12, 4);
+   memcpy(&checkpoint->download_length, stored_checkpoint + 16, 4);
+   memcpy(&checkpoint->image_id, stored_checkpoint + 20, 4);
+   return true;
+}
 
-   switch (ota_firm->state) {
-      case ESP_OTA_INIT:
-         if (_esp_ota_firm_parse_http(ota_firm, in_buf, in_len, &tmp)) {
-            ota_firm->state = ESP_OTA_PREPARE;
+static void save_checkpoint(const ota_checkpoint_t *checkpoint) {
+   unsigned char stored_checkpoint[OTA_CHECKPOINT_BLOCKS * 4];
 
-            #ifdef ALLOW_USE_PRINTF
-            //printf("HTTP parsed %d bytes", tmp);
-            #endif
+   memset(stored_checkpoint, 0, sizeof(stored_checkpoint));
+   stored_checkpoint[0] = OTA_CHECKPOINT_MAGIC;
+   memcpy(stored_checkpoint + 4, &checkpoint->partition_address, 4);
+   memcpy(stored_checkpoint + 8, &checkpoint->written_bytes, 4);
+   memcpy(stored_checkpoint + 12, &checkpoint->download_offset, 4);
+   memcpy(stored_checkpoint + 16, &checkpoint->download_length, 4);
+   memcpy(stored_checkpoint + 20, &checkpoint->image_id, 4);
+   stored_checkpoint[1] = calculate_checkpoint_checksum(stored_checkpoint);
 
-            parsed_bytes = tmp;
-         }
+   rtc_mem_write(OTA_CHECKPOINT_RTC_ADDRESS, stored_checkpoint, sizeof(stored_checkpoint));
+}
 
-         break;
-      case ESP_OTA_PREPARE:
-         ota_firm->read_bytes += in_len;
+static void clear_checkpoint() {
+   unsigned int overwrite_value = 0;
 
-         if (ota_firm->read_bytes >= ota_firm->ota_offset) {
-            ota_firm->buf = &in_buf[in_len - (ota_firm->read_bytes - ota_firm->ota_offset)];
-            ota_firm->bytes = ota_firm->read_bytes - ota_firm->ota_offset;
-            ota_firm->write_bytes += ota_firm->read_bytes - ota_firm->ota_offset;
-            ota_firm->state = ESP_OTA_START;
+   rtc_mem_write(OTA_CHECKPOINT_RTC_ADDRESS, &overwrite_value, 4);
+}
 
-            #ifdef ALLOW_USE_PRINTF
-            //printf("Received %d bytes and start to update", ota_firm->read_bytes);
-            //printf("Write %d total %d", ota_firm->bytes, ota_firm->write_bytes);
-            #endif
-         }
+/**
+ * Sectors are erased just before they are written. esp_ota_begin() would erase the whole partition including the part
+ * downloaded before the restart.
+ */
+static void write_firmware(const esp_partition_t *partition, size_t offset, const char *data, size_t length,
+                           size_t *erased_bytes) {
+   if (offset + length > partition->size) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("Image doesn't fit the partition");
+      #endif
 
-         break;
-      case ESP_OTA_START:
-         if (ota_firm->write_bytes + in_len > ota_firm->ota_size) {
-            ota_firm->bytes = ota_firm->ota_size - ota_firm->write_bytes;
-            ota_firm->state = ESP_OTA_RECVED;
-         } else {
-            ota_firm->bytes = in_len;
-         }
+      task_fatal_error();
+   }
 
-         ota_firm->buf = in_buf;
-         ota_firm->write_bytes += ota_firm->bytes;
+   while (*erased_bytes < offset + length) {
+      esp_err_t err = esp_partition_erase_range(partition, *erased_bytes, SPI_FLASH_SEC_SIZE);
 
+      if (err != ESP_OK) {
          #ifdef ALLOW_USE_PRINTF
-         //printf("Write %d total %d", ota_firm->bytes, ota_firm->write_bytes);
+         printf("Error: esp_partition_erase_range failed! err=0x%X", err);
          #endif
 
-         break;
-      case ESP_OTA_RECVED:
-         parsed_bytes = 0;
-         ota_firm->state = ESP_OTA_FINISH;
+         task_fatal_error();
+      }
+      *erased_bytes += SPI_FLASH_SEC_SIZE;
+   }
 
-         break;
-      default:
-         parsed_bytes = 0;
+   if (length == 0) {
+      return;
+   }
 
-         #ifdef ALLOW_USE_PRINTF
-         printf("State is %d", ota_firm->state);
-         #endif
+   esp_err_t err = esp_partition_write(partition, offset, data, length);
 
-         break;
-   }
+   if (err != ESP_OK) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("Error: esp_partition_write failed! err=0x%X", err);
+      #endif
 
-   return parsed_bytes;
+      task_fatal_error();
+   }
 }
 
-static void esp_ota_firm_parse_msg(esp_ota_firm_t *ota_firm, const char *in_buf, size_t in_len) {
-   size_t parse_bytes = 0;
-
+/**
+ * Returns false when the resumed download doesn't match the checkpoint (the image on the server has changed), then
+ * the checkpoint is cleared and the image has to be downloaded from the beginning.
+ */
+static bool check_response(const http_response_parser_t *parser, ota_checkpoint_t *checkpoint) {
    #ifdef ALLOW_USE_PRINTF
-   //printf("Input %d bytes", in_len);
+   printf("Status: %u, Content-Length: %u, range start: %u, file length: %u", parser->status_code,
+         parser->content_length, parser->range_start, parser->range_total);
    #endif
 
-   do {
-      size_t bytes = esp_ota_firm_do_parse_msg(ota_firm, in_buf + parse_bytes, in_len - parse_bytes);
-
+   if (!http_response_parser_has_sha256(parser)) {
       #ifdef ALLOW_USE_PRINTF
-      //printf("Parsed %d bytes", bytes);
+      printf("No X-Firmware-SHA256 header, the image can't be verified");
       #endif
 
-      if (bytes) {
-         parse_bytes += bytes;
-      }
-   } while (parse_bytes != in_len);
-}
-
-static inline int esp_ota_firm_can_write(esp_ota_firm_t *ota_firm) {
-   return (ota_firm->state == ESP_OTA_START || ota_firm->state == ESP_OTA_RECVED);
-}
+      task_fatal_error();
+   }
 
-static inline const char *esp_ota_firm_get_write_buf(esp_ota_firm_t *ota_firm) {
-   return ota_firm->buf;
-}
+   if (parser->status_code == 206) {
+      if (!parser->content_range_present || parser->range_start != checkpoint->download_offset ||
+            parser->range_total != checkpoint->download_length || parser->etag_hash != checkpoint->image_id) {
+         #ifdef ALLOW_USE_PRINTF
+         printf("Image has changed since the checkpoint");
+         #endif
 
-static inline size_t esp_ota_firm_get_write_bytes(esp_ota_firm_t *ota_firm) {
-   return ota_firm->bytes;
-}
+         return false;
+      }
+   } else if (parser->status_code == 200) {
+      // Also when the server ignores Range. A chunked response without Content-Length can't be resumed
+      checkpoint->written_bytes = 0;
+      checkpoint->download_offset = 0;
+      checkpoint->download_length = parser->content_length_present ? parser->content_length : 0;
+      checkpoint->image_id = parser->etag_hash;
+   } else {
+      #ifdef ALLOW_USE_PRINTF
+      printf("Unexpected response status: %u", parser->status_code);
+      #endif
 
-static inline int esp_ota_firm_is_finished(esp_ota_firm_t *ota_firm) {
-   return ota_firm->state == ESP_OTA_FINISH || ota_firm->state == ESP_OTA_RECVED;
+      task_fatal_error();
+   }
+   return true;
 }
 
-static void update_firmware_task(void *pvParameter) {
-   esp_err_t err;
-   // update handle : set by esp_ota_begin(), must be freed via esp_ota_end()
-   esp_ota_handle_t update_handle = 0;
-   const esp_partition_t *update_partition = NULL;
-
-   #ifdef ALLOW_USE_PRINTF
-   printf("Starting OTA... Flash: %s", CONFIG_ESPTOOLPY_FLASHSIZE);
-   #endif
-
-   /*const esp_partition_t *configured = esp_ota_get_boot_partition();
-   assert(configured != NULL);
-   const esp_partition_t *running = esp_ota_get_running_partition();
-   assert(running != NULL);
-
-   if (configured != running) {
-      ESP_LOGI(TAG, "Configured OTA boot partition at offset 0x%X, but running from offset 0x%X", configured->address, running->address);
-      ESP_LOGI(TAG, "(This can happen if either the OTA boot data or preferred boot image become corrupted somehow.)");
-   }
-   ESP_LOGI(TAG, "Running partition type 0x%X subtype 0x%X (offset 0x%X)", running->type, running->subtype, running->address);*/
+static void send_firmware_request(const ota_checkpoint_t *checkpoint) {
+   char range_start[11];
+   format_unsigned(range_start, sizeof(range_start), checkpoint->download_offset);
 
-   const char *request_parameters[] = {"firmware.bin", SERVER_IP_ADDRESS, NULL};
-   char *http_request = set_string_parameters(FIRMWARE_UPDATE_GET_REQUEST, request_parameters);
+   const char *request_parameters[] = {FIRMWARE_FILE_NAME, SERVER_IP_ADDRESS, range_start, NULL};
+   char *http_request = set_string_parameters(checkpoint->download_offset > 0 ?
+         FIRMWARE_UPDATE_RANGE_GET_REQUEST : FIRMWARE_UPDATE_GET_REQUEST, request_parameters);
 
    #ifdef ALLOW_USE_PRINTF
    printf("GET HTTP request: %s", http_request);
@@ -258,37 +225,157 @@ static void update_firmware_task(void *pvParameter) {
       printf("Send GET request to server succeeded");
       #endif
    }
+}
 
-   update_partition = esp_ota_get_next_update_partition(NULL);
-   assert(update_partition != NULL);
+/**
+ * The digest of the part downloaded before the restart is restored by reading it back from the flash, the rest of
+ * the image is hashed in the receive loop.
+ */
+static void hash_written_part(const esp_partition_t *partition, size_t length, mbedtls_sha256_context *sha256_context) {
+   unsigned char flash_data[OTA_FLASH_READ_SIZE];
 
-   #ifdef ALLOW_USE_PRINTF
-   printf("Writing to partition subtype %d at offset 0x%X", update_partition->subtype, update_partition->address);
-   #endif
+   for (size_t offset = 0; offset < length; offset += OTA_FLASH_READ_SIZE) {
+      size_t read_length = length - offset < OTA_FLASH_READ_SIZE ? length - offset : OTA_FLASH_READ_SIZE;
+      esp_err_t err = esp_partition_read(partition, offset, flash_data, read_length);
 
-   err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &update_handle);
+      if (err != ESP_OK) {
+         #ifdef ALLOW_USE_PRINTF
+         printf("Error: esp_partition_read failed! err=0x%X", err);
+         #endif
 
-   if (err != ESP_OK) {
+         task_fatal_error();
+      }
+      mbedtls_sha256_update_ret(sha256_context, flash_data, read_length);
+   }
+}
+
+static void verify_sha256(const http_response_parser_t *parser, mbedtls_sha256_context *sha256_context) {
+   unsigned char sha256[HTTP_RESPONSE_PARSER_SHA256_SIZE];
+
+   mbedtls_sha256_finish_ret(sha256_context, sha256);
+
+   if (memcmp(sha256, parser->sha256, HTTP_RESPONSE_PARSER_SHA256_SIZE) != 0) {
       #ifdef ALLOW_USE_PRINTF
-      printf("esp_ota_begin failed, error=%d", err);
+      printf("SHA-256 of the image doesn't match");
       #endif
 
+      // The written part is corrupted, so it isn't resumed
+      clear_checkpoint();
       task_fatal_error();
    }
+}
+
+static void write_image(ota_image_writer_t *writer, const char *data, size_t length) {
+   // Hashed while the data is still in the buffer
+   mbedtls_sha256_update_ret(&writer->sha256_context, (const unsigned char *) data, length);
+   write_firmware(writer->partition, writer->written_bytes, data, length, &writer->erased_bytes);
+
+   writer->written_bytes += length;
+   binary_file_length += length;
+}
+
+#ifdef USE_COMPRESSED_FIRMWARE
+/**
+ * Blocks are decoded to whole flash sectors, so the download can be resumed after any of them.
+ */
+static void on_decoded_block(lzss_decoder_t *decoder, const unsigned char *data, size_t length) {
+   ota_image_writer_t *writer = (ota_image_writer_t *) decoder->context;
+
+   write_image(writer, (const char *) data, length);
+
+   if (writer->written_bytes % SPI_FLASH_SEC_SIZE == 0) {
+      writer->checkpoint->written_bytes = writer->written_bytes;
+      writer->checkpoint->download_offset = decoder->input_position;
+      save_checkpoint(writer->checkpoint);
+   }
+}
+
+static void on_corrupted_image() {
    #ifdef ALLOW_USE_PRINTF
-   printf("esp_ota_begin succeeded");
+   printf("Compressed image is corrupted");
    #endif
 
-   bool flag = true;
+   clear_checkpoint();
+   task_fatal_error();
+}
+#endif
+
+static void start_image(esp_ota_firm_t *ota_firm) {
+   ota_image_writer_t *writer = &ota_firm->writer;
+
+   writer->written_bytes = writer->checkpoint->written_bytes;
+   writer->erased_bytes = writer->written_bytes;
+   ota_firm->download_offset = writer->checkpoint->download_offset;
+
+   mbedtls_sha256_init(&writer->sha256_context);
+   mbedtls_sha256_starts_ret(&writer->sha256_context, 0);
+   hash_written_part(writer->partition, writer->written_bytes, &writer->sha256_context);
+
+   #ifdef USE_COMPRESSED_FIRMWARE
+   lzss_decoder_init(&ota_firm->decoder, decoded_block, on_decoded_block, writer);
+
+   if (ota_firm->download_offset > 0) {
+      lzss_decoder_resume(&ota_firm->decoder, ota_firm->download_offset, writer->written_bytes);
+   }
+   #endif
+}
+
+/**
+ * Called with the de-chunked body bytes, which point into the receive buffer.
+ */
+static void on_firmware_body(http_response_parser_t *parser, const char *data, size_t length) {
+   esp_ota_firm_t *ota_firm = (esp_ota_firm_t *) parser->context;
+
+   if (!ota_firm->response_checked) {
+      ota_firm->response_checked = true;
+      ota_firm->restart_required = !check_response(parser, ota_firm->writer.checkpoint);
+
+      if (!ota_firm->restart_required) {
+         start_image(ota_firm);
+      }
+   }
+
+   if (ota_firm->restart_required) {
+      return;
+   }
+
+   ota_firm->download_offset += length;
+
+   #ifdef USE_COMPRESSED_FIRMWARE
+   lzss_decoder_execute(&ota_firm->decoder, (const unsigned char *) data, length);
+
+   if (lzss_decoder_is_error(&ota_firm->decoder)) {
+      on_corrupted_image();
+   }
+   #else
+   ota_image_writer_t *writer = &ota_firm->writer;
+
+   write_image(writer, data, length);
+
+   if (writer->written_bytes / SPI_FLASH_SEC_SIZE > writer->checkpoint->written_bytes / SPI_FLASH_SEC_SIZE) {
+      writer->checkpoint->written_bytes = writer->written_bytes / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+      writer->checkpoint->download_offset = writer->checkpoint->written_bytes;
+      save_checkpoint(writer->checkpoint);
+   }
+   #endif
+}
+
+/**
+ * Downloads the file from checkpoint->download_offset. The checkpoint is saved into the RTC memory each time the next
+ * flash sector is completed. Returns false if the download has to be started over.
+ */
+static bool download_firmware(const esp_partition_t *update_partition, ota_checkpoint_t *checkpoint) {
    esp_ota_firm_t ota_firm;
 
-   esp_ota_firm_init(&ota_firm, update_partition);
+   send_firmware_request(checkpoint);
 
-   // deal with all receive packet
-   while (flag) {
-      memset(text, 0, TEXT_BUFFSIZE);
-      memset(ota_write_data, 0, BUFFSIZE);
+   esp_ota_firm_init(&ota_firm, update_partition);
+   http_response_parser_init(&ota_firm.parser, on_firmware_body, &ota_firm);
+   ota_firm.writer.partition = update_partition;
+   ota_firm.writer.checkpoint = checkpoint;
 
+   // Headers may be split at any byte, the parser keeps its state between the received packets
+   while (!http_response_parser_is_done(&ota_firm.parser) && !ota_firm.restart_required) {
       int buff_len = recv(socket_id, text, TEXT_BUFFSIZE, 0);
 
       if (buff_len < 0) { // receive error
@@ -297,61 +384,143 @@ static void update_firmware_task(void *pvParameter) {
          #endif
 
          task_fatal_error();
-      } else if (buff_len > 0) { // deal with response body
-         esp_ota_firm_parse_msg(&ota_firm, text, buff_len);
-
-         if (!esp_ota_firm_can_write(&ota_firm)) {
-            continue;
-         }
-
-         memcpy(ota_write_data, esp_ota_firm_get_write_buf(&ota_firm), esp_ota_firm_get_write_bytes(&ota_firm));
-         buff_len = esp_ota_firm_get_write_bytes(&ota_firm);
-
-         err = esp_ota_write(update_handle, (const void *) ota_write_data, buff_len);
-
-         if (err != ESP_OK) {
-            #ifdef ALLOW_USE_PRINTF
-            printf("Error: esp_ota_write failed! err=0x%X", err);
-            #endif
-
-            task_fatal_error();
-         }
-
-         binary_file_length += buff_len;
-         //ESP_LOGI(TAG, "Have written image length %d", binary_file_length);
       } else if (buff_len == 0) { // packet over
-         flag = false;
-
          #ifdef ALLOW_USE_PRINTF
          printf("Connection closed, all packets received");
          #endif
 
-         close(socket_id);
-      } else {
+         http_response_parser_finish(&ota_firm.parser);
+         break;
+      }
+
+      http_response_parser_execute(&ota_firm.parser, text, buff_len);
+
+      if (http_response_parser_is_error(&ota_firm.parser)) {
          #ifdef ALLOW_USE_PRINTF
-         printf("Unexpected recv. result");
+         printf("recv. malformed HTTP response");
          #endif
+
+         task_fatal_error();
       }
+   }
 
-      if (esp_ota_firm_is_finished(&ota_firm)) {
-         break;
+   close(socket_id);
+
+   if (ota_firm.restart_required) {
+      return false;
+   }
+
+   if (!ota_firm.response_checked && http_response_parser_is_done(&ota_firm.parser)) {
+      // Empty body
+      ota_firm.response_checked = true;
+
+      if (!check_response(&ota_firm.parser, checkpoint)) {
+         return false;
       }
+      start_image(&ota_firm);
+   }
+
+   if (!ota_firm.response_checked || !http_response_parser_is_done(&ota_firm.parser) ||
+         (checkpoint->download_length > 0 && ota_firm.download_offset != checkpoint->download_length)) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("Incomplete download: %u of %u bytes", ota_firm.download_offset, checkpoint->download_length);
+      #endif
+
+      // The checkpoint is kept, the next update continues from it
+      task_fatal_error();
    }
 
+   #ifdef USE_COMPRESSED_FIRMWARE
+   if (!lzss_decoder_is_complete(&ota_firm.decoder)) {
+      on_corrupted_image();
+   }
+   #endif
+
+   verify_sha256(&ota_firm.parser, &ota_firm.writer.sha256_context);
+   mbedtls_sha256_free(&ota_firm.writer.sha256_context);
+   return true;
+}
+
+static void update_firmware_task(void *pvParameter) {
+   esp_err_t err;
+   const esp_partition_t *update_partition = NULL;
+
    #ifdef ALLOW_USE_PRINTF
-   printf("Total write binary data length : %d", binary_file_length);
+   printf("Starting OTA... Flash: %s", CONFIG_ESPTOOLPY_FLASHSIZE);
    #endif
 
-   if (esp_ota_end(update_handle) != ESP_OK) {
+   update_partition = esp_ota_get_next_update_partition(NULL);
+   assert(update_partition != NULL);
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("Writing to partition subtype %d at offset 0x%X", update_partition->subtype, update_partition->address);
+   #endif
+
+   ota_checkpoint_t checkpoint;
+
+   if (!load_checkpoint(&checkpoint) || checkpoint.partition_address != update_partition->address) {
+      memset(&checkpoint, 0, sizeof(ota_checkpoint_t));
+      checkpoint.partition_address = update_partition->address;
+   }
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("Download starts from %u of %u bytes", checkpoint.download_offset, checkpoint.download_length);
+   #endif
+
+   text = (char *) MALLOC(TEXT_BUFFSIZE, 0);
+
+   if (text == NULL) {
       #ifdef ALLOW_USE_PRINTF
-      printf("esp_ota_end failed!");
+      printf("Not enough memory for the receive buffer");
       #endif
 
       task_fatal_error();
    }
 
+   #ifdef USE_COMPRESSED_FIRMWARE
+   decoded_block = (unsigned char *) MALLOC(LZSS_BLOCK_SIZE, 0);
+
+   if (decoded_block == NULL) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("Not enough memory for the decoded block");
+      #endif
+
+      task_fatal_error();
+   }
+   #endif
+
+   EXECUTION_TIME_START(firmware_download);
+
+   if (!download_firmware(update_partition, &checkpoint)) {
+      clear_checkpoint();
+      memset(&checkpoint, 0, sizeof(ota_checkpoint_t));
+      checkpoint.partition_address = update_partition->address;
+      binary_file_length = 0;
+
+      if (!download_firmware(update_partition, &checkpoint)) {
+         task_fatal_error();
+      }
+   }
+
+   EXECUTION_TIME_END(firmware_download, binary_file_length);
+
+   FREE(text);
+   text = NULL;
+   #ifdef USE_COMPRESSED_FIRMWARE
+   FREE(decoded_block);
+   decoded_block = NULL;
+   #endif
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("Total write binary data length : %d", binary_file_length);
+   #endif
+
+   // SHA-256 has been verified, the image format is verified before the boot partition is switched
    err = esp_ota_set_boot_partition(update_partition);
 
+   // A corrupted image can't be resumed either
+   clear_checkpoint();
+
    if (err != ESP_OK) {
       #ifdef ALLOW_USE_PRINTF
       printf("esp_ota_set_boot_partition failed! err=0x%X", err);
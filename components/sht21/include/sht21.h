@@ -4,6 +4,9 @@
 #include "esp_err.h"
 #include "global_definitions.h"
 
+#ifndef SHT21_HEADER
+#define SHT21_HEADER
+
 #define ACK_CHECK_EN    0x1       // I2C master will check ACK from slave
 #define ACK_VAL         0x0 // I2C ACK value
 #define NACK_VAL        0x1 // I2C NACK value
@@ -13,16 +16,66 @@
 #define SHT21_ADDRESS_READ (unsigned char) ((SHT21_ADDRESS << 1) | 0x1)
 
 #define SHT21_CRC8_POLYNOMIAL 0x13100   //CRC-8 polynomial for 16bit value -> x^8 + x^5 + x^4 + 1
+#define SHT21_CRC8_POLYNOMIAL_BYTE ((SHT21_CRC8_POLYNOMIAL >> 8) & 0xFF)
+
+// CRC-8 lookup table entries are calculated by the preprocessor from the polynomial
+#define SHT21_CRC8_SHIFT(crc) ((((crc) << 1) ^ (((crc) >> 7) * SHT21_CRC8_POLYNOMIAL_BYTE)) & 0xFF)
+#define SHT21_CRC8_TABLE_ENTRY(byte) \
+   SHT21_CRC8_SHIFT(SHT21_CRC8_SHIFT(SHT21_CRC8_SHIFT(SHT21_CRC8_SHIFT( \
+   SHT21_CRC8_SHIFT(SHT21_CRC8_SHIFT(SHT21_CRC8_SHIFT(SHT21_CRC8_SHIFT(byte))))))))
+#define SHT21_CRC8_TABLE_ROW(row) \
+   SHT21_CRC8_TABLE_ENTRY((row) + 0x0), SHT21_CRC8_TABLE_ENTRY((row) + 0x1), SHT21_CRC8_TABLE_ENTRY((row) + 0x2), \
+   SHT21_CRC8_TABLE_ENTRY((row) + 0x3), SHT21_CRC8_TABLE_ENTRY((row) + 0x4), SHT21_CRC8_TABLE_ENTRY((row) + 0x5), \
+   SHT21_CRC8_TABLE_ENTRY((row) + 0x6), SHT21_CRC8_TABLE_ENTRY((row) + 0x7), SHT21_CRC8_TABLE_ENTRY((row) + 0x8), \
+   SHT21_CRC8_TABLE_ENTRY((row) + 0x9), SHT21_CRC8_TABLE_ENTRY((row) + 0xA), SHT21_CRC8_TABLE_ENTRY((row) + 0xB), \
+   SHT21_CRC8_TABLE_ENTRY((row) + 0xC), SHT21_CRC8_TABLE_ENTRY((row) + 0xD), SHT21_CRC8_TABLE_ENTRY((row) + 0xE), \
+   SHT21_CRC8_TABLE_ENTRY((row) + 0xF)
+
+#define SHT21_POLLING_INTERVAL                  1 // ticks, the first one after the typical conversion time
+#define SHT21_MAX_POLLING_INTERVAL              4 // ticks
+#define SHT21_CONVERSION_TIME_HISTOGRAM_SIZE    16
 
 #define SHT21_CRC_ERROR                         -100.0F
 #define SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR -200.0F
 #define SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR    -300.0F
 
+// The same errors in hundredths
+#define SHT21_CRC_ERROR_CENTI                         -10000
+#define SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR_CENTI -20000
+#define SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR_CENTI    -30000
+
+#define SHT21_USER_REGISTER_RESOLUTION_MASK     0x81
+
 typedef enum {
    TRIGGER_T_MEASUREMENT = 0xF3,
-   TRIGGER_RH_MEASUREMENT = 0xF5
+   TRIGGER_RH_MEASUREMENT = 0xF5,
+   WRITE_USER_REGISTER = 0xE6,
+   READ_USER_REGISTER = 0xE7
 } SHT21_Commands;
 
-static float sht21_calculate_humidity(unsigned short data, unsigned char checksum);
+// User register resolution bits (7 and 0)
+typedef enum {
+   SHT21_RESOLUTION_RH12_T14 = 0x00,
+   SHT21_RESOLUTION_RH8_T12 = 0x01,
+   SHT21_RESOLUTION_RH10_T13 = 0x80,
+   SHT21_RESOLUTION_RH11_T11 = 0x81
+} SHT21_Resolution;
+
+typedef struct {
+   unsigned short temperature[SHT21_CONVERSION_TIME_HISTOGRAM_SIZE];
+   unsigned short humidity[SHT21_CONVERSION_TIME_HISTOGRAM_SIZE];
+   unsigned short timeouts;
+} sht21_conversion_time_histogram_t;
+
 esp_err_t sht21_get_temperature(float *temperature, unsigned short *temperature_raw);
 esp_err_t sht21_get_humidity(float *humidity);
+esp_err_t sht21_get_temperature_centi(int *temperature, unsigned short *temperature_raw);
+esp_err_t sht21_get_humidity_centi(int *humidity);
+const sht21_conversion_time_histogram_t *sht21_get_conversion_time_histogram();
+unsigned char sht21_calculate_crc8(const unsigned char *data, size_t data_len);
+esp_err_t sht21_read_user_register(unsigned char *user_register);
+esp_err_t sht21_write_user_register(unsigned char user_register);
+esp_err_t sht21_set_resolution(SHT21_Resolution resolution);
+SHT21_Resolution sht21_get_resolution();
+
+#endif
@@ -1,5 +1,21 @@
 #include "include/sht21.h"
 
+static sht21_conversion_time_histogram_t conversion_time_histogram_g;
+static SHT21_Resolution resolution_g = SHT21_RESOLUTION_RH12_T14;
+
+// Indexed by resolution_index(). Timeouts are datasheet maximum conversion times with margin
+static const unsigned char TEMPERATURE_TYPICAL_CONVERSION_TIMES_MS[] = {66, 17, 33, 9};
+static const unsigned char HUMIDITY_TYPICAL_CONVERSION_TIMES_MS[] = {22, 3, 7, 12};
+static const unsigned char TEMPERATURE_MEASUREMENT_TIMEOUTS_MS[] = {100, 30, 55, 20};
+static const unsigned char HUMIDITY_MEASUREMENT_TIMEOUTS_MS[] = {50, 10, 20, 25};
+// Bits below the resolution and 2 status bits are cleared
+static const unsigned short TEMPERATURE_DATA_MASKS[] = {0xFFFC, 0xFFF0, 0xFFF8, 0xFFE0};
+static const unsigned short HUMIDITY_DATA_MASKS[] = {0xFFFC, 0xFF00, 0xFFC0, 0xFFE0};
+
+static unsigned char resolution_index(SHT21_Resolution resolution) {
+   return ((resolution & 0x80) >> 6) | (resolution & 0x1);
+}
+
 static esp_err_t i2c_master_sht21_write(unsigned char command) {
    int ret;
    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
@@ -28,7 +44,9 @@ static esp_err_t i2c_master_sht21_read(unsigned char *data, size_t data_len) {
 static esp_err_t i2c_master_sht21_write_and_read(unsigned char command,
                                                  unsigned char *read_data,
                                                  size_t data_len,
-                                                 TickType_t measurement_time) {
+                                                 TickType_t typical_measurement_time,
+                                                 TickType_t max_measurement_time,
+                                                 unsigned short *conversion_time_histogram) {
    if (data_len <= 0) {
       return ESP_ERR_INVALID_STATE;
    }
@@ -56,29 +74,122 @@ static esp_err_t i2c_master_sht21_write_and_read(unsigned char command,
    }
    i2c_cmd_link_delete(cmd);
 
-   vTaskDelay(measurement_time);
-   cmd = i2c_cmd_link_create();
-   i2c_master_start(cmd);
-   i2c_master_write_byte(cmd, SHT21_ADDRESS << 1 | I2C_MASTER_READ, ACK_CHECK_EN); //0x81
+   // No hold master mode: the sensor doesn't acknowledge its read address until the measurement is finished.
+   // The first read is after the typical conversion time, then the polling interval is doubled, so a slow
+   // measurement doesn't occupy the bus with many unacknowledged reads
+   TickType_t trigger_time = xTaskGetTickCount();
+   TickType_t conversion_time = 0;
+   TickType_t delay = typical_measurement_time > 0 ? typical_measurement_time : SHT21_POLLING_INTERVAL;
+   TickType_t polling_interval = SHT21_POLLING_INTERVAL;
 
-   i2c_master_read(cmd, read_data, data_len, LAST_NACK_VAL);
+   do {
+      if (conversion_time + delay > max_measurement_time) {
+         delay = max_measurement_time > conversion_time ? max_measurement_time - conversion_time : 1;
+      }
+      vTaskDelay(delay);
+      ret = i2c_master_sht21_read(read_data, data_len);
+      conversion_time = xTaskGetTickCount() - trigger_time;
 
-   i2c_master_stop(cmd);
-   i2c_master_cmd_begin(I2C_NUM_0, cmd, 500 / portTICK_RATE_MS);
+      delay = polling_interval;
+      if (polling_interval < SHT21_MAX_POLLING_INTERVAL) {
+         polling_interval *= 2;
+      }
+   } while (ret != ESP_OK && conversion_time < max_measurement_time);
+
+   if (ret == ESP_OK) {
+      unsigned char histogram_index = conversion_time < SHT21_CONVERSION_TIME_HISTOGRAM_SIZE ?
+            conversion_time : SHT21_CONVERSION_TIME_HISTOGRAM_SIZE - 1;
+      conversion_time_histogram[histogram_index]++;
+   } else {
+      conversion_time_histogram_g.timeouts++;
+
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nI2C ERROR. SHT21 measurement timeout, result status: 0x%X\n", ret);
+      #endif
+   }
+   return ret;
+}
+
+/**
+ * Histograms of measured conversion times. Index is the time in ticks (portTICK_RATE_MS ms), the last element
+ * accumulates all the longer conversions.
+ */
+const sht21_conversion_time_histogram_t *sht21_get_conversion_time_histogram() {
+   return &conversion_time_histogram_g;
+}
+
+esp_err_t sht21_read_user_register(unsigned char *user_register) {
+   esp_err_t ret = i2c_master_sht21_write(READ_USER_REGISTER);
 
+   if (ret != ESP_OK) {
+      return ret;
+   }
+   return i2c_master_sht21_read(user_register, 1);
+}
+
+esp_err_t sht21_write_user_register(unsigned char user_register) {
+   i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+   i2c_master_start(cmd);
+   i2c_master_write_byte(cmd, SHT21_ADDRESS << 1 | I2C_MASTER_WRITE, ACK_CHECK_EN);
+   i2c_master_write_byte(cmd, WRITE_USER_REGISTER, ACK_CHECK_EN);
+   i2c_master_write_byte(cmd, user_register, ACK_CHECK_EN);
+   i2c_master_stop(cmd);
+   esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, cmd, 100 / portTICK_RATE_MS);
    i2c_cmd_link_delete(cmd);
    return ret;
 }
 
+/**
+ * Read-modify-write of the user register, reserved bits are kept as they are.
+ * Lower resolution shortens the measurement (e.g. 11 bit T is ~8 times faster than 14 bit).
+ */
+esp_err_t sht21_set_resolution(SHT21_Resolution resolution) {
+   unsigned char user_register;
+   esp_err_t ret = sht21_read_user_register(&user_register);
+
+   if (ret != ESP_OK) {
+      return ret;
+   }
+
+   user_register = (user_register & ~SHT21_USER_REGISTER_RESOLUTION_MASK) | resolution;
+   ret = sht21_write_user_register(user_register);
+
+   if (ret == ESP_OK) {
+      resolution_g = resolution;
+   }
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nSHT21 user register: 0x%X, result status: 0x%X\n", user_register, ret);
+   #endif
+
+   return ret;
+}
+
+SHT21_Resolution sht21_get_resolution() {
+   return resolution_g;
+}
+
+static const unsigned char SHT21_CRC8_TABLE[256] = {
+   SHT21_CRC8_TABLE_ROW(0x00), SHT21_CRC8_TABLE_ROW(0x10), SHT21_CRC8_TABLE_ROW(0x20), SHT21_CRC8_TABLE_ROW(0x30),
+   SHT21_CRC8_TABLE_ROW(0x40), SHT21_CRC8_TABLE_ROW(0x50), SHT21_CRC8_TABLE_ROW(0x60), SHT21_CRC8_TABLE_ROW(0x70),
+   SHT21_CRC8_TABLE_ROW(0x80), SHT21_CRC8_TABLE_ROW(0x90), SHT21_CRC8_TABLE_ROW(0xA0), SHT21_CRC8_TABLE_ROW(0xB0),
+   SHT21_CRC8_TABLE_ROW(0xC0), SHT21_CRC8_TABLE_ROW(0xD0), SHT21_CRC8_TABLE_ROW(0xE0), SHT21_CRC8_TABLE_ROW(0xF0)
+};
+
+/**
+ * CRC-8 of the byte stream as the sensor calculates it (e.g. for measurement data or serial number blocks).
+ */
+unsigned char sht21_calculate_crc8(const unsigned char *data, size_t data_len) {
+   unsigned char crc = 0;
+
+   for (size_t i = 0; i < data_len; i++) {
+      crc = SHT21_CRC8_TABLE[crc ^ data[i]];
+   }
+   return crc;
+}
+
 static unsigned char sht21_calculate_crc(unsigned short data) {
-  for (unsigned char bit = 0; bit < 16; bit++) {
-    if (data & 0x8000) {
-       data = (data << 1) ^ SHT21_CRC8_POLYNOMIAL;
-    } else {
-       data <<= 1;
-    }
-  }
-  return (unsigned char) (data >>= 8);
+   return SHT21_CRC8_TABLE[SHT21_CRC8_TABLE[data >> 8] ^ (data & 0xFF)];
 }
 
 static float sht21_calculate_temperature(unsigned short data, unsigned char checksum) {
@@ -96,7 +207,7 @@ static float sht21_calculate_temperature(unsigned short data, unsigned char chec
       return SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR;
    }
 
-   float temperature = (float) (data & ((unsigned short) 0x3FFFC));
+   float temperature = (float) (data & TEMPERATURE_DATA_MASKS[resolution_index(resolution_g)]);
    return 175.72 * temperature / 0xFFFF - 46.85;
 }
 
@@ -115,23 +226,77 @@ static float sht21_calculate_humidity(unsigned short data, unsigned char checksu
       return SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR;
    }
 
-   float humidity = (float) (data & ((unsigned short) 0x3FFFC));
+   float humidity = (float) (data & HUMIDITY_DATA_MASKS[resolution_index(resolution_g)]);
    return 125 * humidity / 0xFFFF - 6;
 }
 
-esp_err_t sht21_get_temperature(float *temperature, unsigned short *temperature_raw) {
+/**
+ * T = -46.85 + 175.72 * S / 2^16, so T * 100 = -4685 + 17572 * S / 2^16 (rounded). 17572 * 0xFFFF fits into 32 bits.
+ */
+static int sht21_calculate_temperature_centi(unsigned short data, unsigned char checksum) {
+   if (checksum != sht21_calculate_crc(data)) {
+      return SHT21_CRC_ERROR_CENTI;
+   }
+
+   if (data == 0) {
+      return 0;
+   } else if (data & 0x2) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nI2C ERROR. Humidity measurement instead of Temperature\n");
+      #endif
+
+      return SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR_CENTI;
+   }
+
+   unsigned int temperature = data & TEMPERATURE_DATA_MASKS[resolution_index(resolution_g)];
+   return (int) ((17572 * temperature + 0x8000) >> 16) - 4685;
+}
+
+/**
+ * RH = -6 + 125 * S / 2^16, so RH * 100 = -600 + 12500 * S / 2^16 (rounded)
+ */
+static int sht21_calculate_humidity_centi(unsigned short data, unsigned char checksum) {
+   if (checksum != sht21_calculate_crc(data)) {
+      return SHT21_CRC_ERROR_CENTI;
+   }
+
+   if (data == 0) {
+      return 0;
+   } else if (!(data & 0x2)) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nI2C ERROR. Temperature measurement instead of Humidity\n");
+      #endif
+
+      return SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR_CENTI;
+   }
+
+   unsigned int humidity = data & HUMIDITY_DATA_MASKS[resolution_index(resolution_g)];
+   return (int) ((12500 * humidity + 0x8000) >> 16) - 600;
+}
+
+static esp_err_t sht21_measure(SHT21_Commands command, unsigned short *raw_data, unsigned char *checksum) {
    unsigned char data[3];
-   esp_err_t i2c_result_status = i2c_master_sht21_write_and_read(TRIGGER_T_MEASUREMENT, data, 3, 100 / portTICK_RATE_MS);
+   esp_err_t i2c_result_status;
+
+   if (command == TRIGGER_T_MEASUREMENT) {
+      i2c_result_status = i2c_master_sht21_write_and_read(command, data, 3,
+            TEMPERATURE_TYPICAL_CONVERSION_TIMES_MS[resolution_index(resolution_g)] / portTICK_RATE_MS,
+            TEMPERATURE_MEASUREMENT_TIMEOUTS_MS[resolution_index(resolution_g)] / portTICK_RATE_MS,
+            conversion_time_histogram_g.temperature);
+   } else {
+      i2c_result_status = i2c_master_sht21_write_and_read(command, data, 3,
+            HUMIDITY_TYPICAL_CONVERSION_TIMES_MS[resolution_index(resolution_g)] / portTICK_RATE_MS,
+            HUMIDITY_MEASUREMENT_TIMEOUTS_MS[resolution_index(resolution_g)] / portTICK_RATE_MS,
+            conversion_time_histogram_g.humidity);
+   }
 
    if (i2c_result_status == ESP_OK) {
-      unsigned short raw_data = (data[0] << 8) | data[1];
+      *raw_data = (data[0] << 8) | data[1];
+      *checksum = data[2];
 
       #ifdef ALLOW_USE_PRINTF
-      printf("\nTemperature raw: 0x%X\n", raw_data);
+      printf("\n%s raw: 0x%X\n", command == TRIGGER_T_MEASUREMENT ? "Temperature" : "Humidity", *raw_data);
       #endif
-
-      *temperature = sht21_calculate_temperature(raw_data, data[2]);
-      *temperature_raw = raw_data;
    } else {
       #ifdef ALLOW_USE_PRINTF
       printf("\nI2C ERROR. Result status: 0x%X\n", i2c_result_status);
@@ -140,22 +305,54 @@ esp_err_t sht21_get_temperature(float *temperature, unsigned short *temperature_
    return i2c_result_status;
 }
 
+esp_err_t sht21_get_temperature(float *temperature, unsigned short *temperature_raw) {
+   unsigned short raw_data;
+   unsigned char checksum;
+   esp_err_t i2c_result_status = sht21_measure(TRIGGER_T_MEASUREMENT, &raw_data, &checksum);
+
+   if (i2c_result_status == ESP_OK) {
+      *temperature = sht21_calculate_temperature(raw_data, checksum);
+      *temperature_raw = raw_data;
+   }
+   return i2c_result_status;
+}
+
 esp_err_t sht21_get_humidity(float *humidity) {
-   unsigned char data[3];
-   esp_err_t i2c_result_status = i2c_master_sht21_write_and_read(TRIGGER_RH_MEASUREMENT, data, 3, 50 / portTICK_RATE_MS);
+   unsigned short raw_data;
+   unsigned char checksum;
+   esp_err_t i2c_result_status = sht21_measure(TRIGGER_RH_MEASUREMENT, &raw_data, &checksum);
 
    if (i2c_result_status == ESP_OK) {
-      unsigned short raw_data = (data[0] << 8) | data[1];
+      *humidity = sht21_calculate_humidity(raw_data, checksum);
+   }
+   return i2c_result_status;
+}
 
-      #ifdef ALLOW_USE_PRINTF
-      printf("\nHumidity raw: 0x%X\n", raw_data);
-      #endif
+/**
+ * Temperature in hundredths of a degree, calculated without floating point
+ */
+esp_err_t sht21_get_temperature_centi(int *temperature, unsigned short *temperature_raw) {
+   unsigned short raw_data;
+   unsigned char checksum;
+   esp_err_t i2c_result_status = sht21_measure(TRIGGER_T_MEASUREMENT, &raw_data, &checksum);
 
-      *humidity = sht21_calculate_humidity(raw_data, data[2]);
-   } else {
-      #ifdef ALLOW_USE_PRINTF
-      printf("\nI2C ERROR. Result status: 0x%x\n", i2c_result_status);
-      #endif
+   if (i2c_result_status == ESP_OK) {
+      *temperature = sht21_calculate_temperature_centi(raw_data, checksum);
+      *temperature_raw = raw_data;
+   }
+   return i2c_result_status;
+}
+
+/**
+ * Relative humidity in hundredths of a percent, calculated without floating point
+ */
+esp_err_t sht21_get_humidity_centi(int *humidity) {
+   unsigned short raw_data;
+   unsigned char checksum;
+   esp_err_t i2c_result_status = sht21_measure(TRIGGER_RH_MEASUREMENT, &raw_data, &checksum);
+
+   if (i2c_result_status == ESP_OK) {
+      *humidity = sht21_calculate_humidity_centi(raw_data, checksum);
    }
    return i2c_result_status;
 }
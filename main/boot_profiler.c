@@ -0,0 +1,75 @@
+#include "boot_profiler.h"
+
+static const char *const BOOT_PHASE_NAMES[BOOT_PHASES_AMOUNT] =
+      {"start", "pins", "uart", "tcpip", "wifi", "ip", "sensor", "ok"};
+
+// 0 - the phase hasn't been reached
+static volatile unsigned int boot_phase_times_g[BOOT_PHASES_AMOUNT];
+
+/**
+ * Only the first mark of the phase is kept, so it can be called on every sensor reading or response.
+ */
+void boot_profiler_mark(boot_phase_t phase) {
+   if (boot_phase_times_g[phase] != 0) {
+      return;
+   }
+
+   unsigned int time_ms = (unsigned int) (esp_timer_get_time() / 1000);
+
+   boot_phase_times_g[phase] = time_ms == 0 ? 1 : time_ms;
+}
+
+unsigned int boot_profiler_get_time(boot_phase_t phase) {
+   return boot_phase_times_g[phase];
+}
+
+/**
+ * Returns the timeline length. The buffer is always \0 terminated, phases which don't fit are skipped.
+ */
+unsigned short boot_profiler_format_timeline(char *buffer, unsigned short buffer_size) {
+   unsigned short length = 0;
+
+   buffer[0] = '\0';
+
+   for (unsigned char i = 0; i < BOOT_PHASES_AMOUNT; i++) {
+      unsigned int time_ms = boot_phase_times_g[i];
+
+      if (time_ms == 0) {
+         continue;
+      }
+
+      char time[11];
+      unsigned char time_length = format_unsigned(time, sizeof(time), time_ms);
+      unsigned char name_length = strlen(BOOT_PHASE_NAMES[i]);
+      unsigned char separator_length = length > 0 ? 1 : 0;
+
+      if (length + separator_length + name_length + 1 + time_length + 1 > buffer_size) {
+         break;
+      }
+
+      if (separator_length > 0) {
+         buffer[length++] = ',';
+      }
+      memcpy(buffer + length, BOOT_PHASE_NAMES[i], name_length);
+      length += name_length;
+      buffer[length++] = ':';
+      memcpy(buffer + length, time, time_length);
+      length += time_length;
+      buffer[length] = '\0';
+   }
+   return length;
+}
+
+/**
+ * One line per reached phase, so it can be collected from UART output into CSV.
+ */
+void boot_profiler_print() {
+   #ifdef ALLOW_USE_PRINTF
+   for (unsigned char i = 0; i < BOOT_PHASES_AMOUNT; i++) {
+      if (boot_phase_times_g[i] != 0) {
+         printf("\nBOOT_PHASE,%s,%u", BOOT_PHASE_NAMES[i], boot_phase_times_g[i]);
+      }
+   }
+   printf("\n");
+   #endif
+}
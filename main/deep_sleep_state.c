@@ -0,0 +1,67 @@
+#include "deep_sleep_state.h"
+
+#define AWAKE_TIME_UNIT_MS 10
+
+static unsigned char calculate_crc(const unsigned char stored_state[DEEP_SLEEP_STATE_BLOCKS * 4]) {
+   unsigned char crc_data[DEEP_SLEEP_STATE_BLOCKS * 4 - 1];
+
+   crc_data[0] = stored_state[0];
+   memcpy(crc_data + 1, stored_state + 2, sizeof(crc_data) - 1);
+   return sht21_calculate_crc8(crc_data, sizeof(crc_data));
+}
+
+static unsigned short to_awake_time_units(unsigned int time_ms) {
+   unsigned int units = time_ms / AWAKE_TIME_UNIT_MS;
+
+   return units > 0xFFFF ? 0xFFFF : units;
+}
+
+/**
+ * Returns false if there was no valid state (e.g. after power on), then the state is cleared.
+ */
+bool deep_sleep_state_load(deep_sleep_state_t *state, unsigned int rtc_address) {
+   unsigned char stored_state[DEEP_SLEEP_STATE_BLOCKS * 4];
+
+   rtc_mem_read(rtc_address, stored_state, sizeof(stored_state));
+
+   memset(state, 0, sizeof(deep_sleep_state_t));
+
+   if (stored_state[0] != DEEP_SLEEP_STATE_MAGIC || stored_state[1] != calculate_crc(stored_state)) {
+      return false;
+   }
+
+   unsigned short awake_time;
+   unsigned short previous_cycle_awake_time;
+
+   state->access_point_channel = stored_state[2];
+   state->first_report_confirmed = (stored_state[3] & DEEP_SLEEP_STATE_FIRST_REPORT_CONFIRMED_FLAG) != 0;
+   memcpy(state->access_point_bssid, stored_state + 4, 6);
+   state->reset_reason = stored_state[10];
+   memcpy(&state->wakes_amount, stored_state + 12, 4);
+   memcpy(&state->device_time, stored_state + 16, 4);
+   memcpy(&awake_time, stored_state + 20, 2);
+   memcpy(&previous_cycle_awake_time, stored_state + 22, 2);
+   state->awake_time_ms = awake_time * AWAKE_TIME_UNIT_MS;
+   state->previous_cycle_awake_time_ms = previous_cycle_awake_time * AWAKE_TIME_UNIT_MS;
+   return true;
+}
+
+void deep_sleep_state_save(const deep_sleep_state_t *state, unsigned int rtc_address) {
+   unsigned char stored_state[DEEP_SLEEP_STATE_BLOCKS * 4];
+   unsigned short awake_time = to_awake_time_units(state->awake_time_ms);
+   unsigned short previous_cycle_awake_time = to_awake_time_units(state->previous_cycle_awake_time_ms);
+
+   memset(stored_state, 0, sizeof(stored_state));
+   stored_state[0] = DEEP_SLEEP_STATE_MAGIC;
+   stored_state[2] = state->access_point_channel;
+   stored_state[3] = state->first_report_confirmed ? DEEP_SLEEP_STATE_FIRST_REPORT_CONFIRMED_FLAG : 0;
+   memcpy(stored_state + 4, state->access_point_bssid, 6);
+   stored_state[10] = state->reset_reason;
+   memcpy(stored_state + 12, &state->wakes_amount, 4);
+   memcpy(stored_state + 16, &state->device_time, 4);
+   memcpy(stored_state + 20, &awake_time, 2);
+   memcpy(stored_state + 22, &previous_cycle_awake_time, 2);
+   stored_state[1] = calculate_crc(stored_state);
+
+   rtc_mem_write(rtc_address, stored_state, sizeof(stored_state));
+}
@@ -0,0 +1,448 @@
+#include "http_response_parser.h"
+
+static const char *const KNOWN_HEADERS[] =
+      {"content-length", "transfer-encoding", "connection", "content-range", "etag", "x-firmware-sha256"};
+static const char HTTP_VERSION_PREFIX[] = "HTTP/";
+static const char CHUNKED_VALUE[] = "chunked";
+static const char CLOSE_VALUE[] = "close";
+
+#define KNOWN_HEADERS_AMOUNT     (sizeof(KNOWN_HEADERS) / sizeof(KNOWN_HEADERS[0]))
+#define ALL_HEADERS_CANDIDATES   ((1 << KNOWN_HEADERS_AMOUNT) - 1)
+
+#define ETAG_HASH_OFFSET_BASIS   2166136261U
+#define ETAG_HASH_PRIME          16777619U
+#define SHA256_DIGITS_INVALID    0xFF
+#define VALUE_TOKEN_MISMATCH     0xFF
+
+// Fields of the Content-Range value, value_match_position is used as the current field
+#define CONTENT_RANGE_UNIT       0
+#define CONTENT_RANGE_START      1
+#define CONTENT_RANGE_END        2
+#define CONTENT_RANGE_TOTAL      3
+
+static char to_lower_case(char character) {
+   return (character >= 'A' && character <= 'Z') ? character + ('a' - 'A') : character;
+}
+
+static signed char hex_digit_value(char character) {
+   if (character >= '0' && character <= '9') {
+      return character - '0';
+   } else if (character >= 'a' && character <= 'f') {
+      return character - 'a' + 10;
+   } else if (character >= 'A' && character <= 'F') {
+      return character - 'A' + 10;
+   }
+   return -1;
+}
+
+/**
+ * Case insensitive comparison of the current element of the list value (e.g. "gzip, chunked") with the token.
+ * Whitespace is allowed only around the element. Returns true at the end of the element (',' or the end of the line)
+ * if the whole element equals the token.
+ */
+static bool match_value_token(http_response_parser_t *parser, const char *token, char character) {
+   unsigned char position = parser->value_match_position;
+
+   if (character == ',' || character == '\n') {
+      parser->value_match_position = 0;
+      return position != VALUE_TOKEN_MISMATCH && position > 0 && token[position] == '\0';
+   } else if (position == VALUE_TOKEN_MISMATCH || (character == ' ' && (position == 0 || token[position] == '\0'))) {
+      return false;
+   }
+
+   parser->value_match_position =
+         token[position] != '\0' && to_lower_case(character) == token[position] ? position + 1 : VALUE_TOKEN_MISMATCH;
+   return false;
+}
+
+void http_response_parser_init(http_response_parser_t *parser,
+                               void (*on_body)(http_response_parser_t *parser, const char *data, size_t length),
+                               void *context) {
+   memset(parser, 0, sizeof(http_response_parser_t));
+
+   parser->state = HTTP_PARSER_STATUS_LINE;
+   parser->on_body = on_body;
+   parser->context = context;
+}
+
+static void on_headers_end(http_response_parser_t *parser) {
+   if (parser->status_code >= 100 && parser->status_code < 200) {
+      // Interim response (e.g. 100 Continue), the final one follows
+      parser->state = HTTP_PARSER_STATUS_LINE;
+      parser->line_position = 0;
+      parser->value_match_position = 0;
+      parser->status_code = 0;
+      parser->content_length_present = false;
+      parser->chunked = false;
+      parser->content_length = 0;
+      parser->content_range_present = false;
+      parser->etag_hash = 0;
+      parser->sha256_digits = 0;
+   } else if (parser->status_code == 204 || parser->status_code == 304) {
+      parser->state = HTTP_PARSER_DONE;
+   } else if (parser->chunked) {
+      parser->state = HTTP_PARSER_CHUNK_SIZE;
+      parser->remaining_bytes = 0;
+      parser->line_position = 0;
+   } else if (parser->content_length_present) {
+      parser->remaining_bytes = parser->content_length;
+      parser->state = parser->content_length == 0 ? HTTP_PARSER_DONE : HTTP_PARSER_BODY;
+   } else {
+      parser->state = HTTP_PARSER_BODY_UNTIL_CLOSE;
+   }
+}
+
+static void on_header_name_end(http_response_parser_t *parser) {
+   parser->header = HTTP_HEADER_UNKNOWN;
+
+   for (unsigned char i = 0; i < KNOWN_HEADERS_AMOUNT; i++) {
+      if ((parser->header_candidates & (1 << i)) && KNOWN_HEADERS[i][parser->line_position] == '\0') {
+         parser->header = (http_header_t) i;
+         break;
+      }
+   }
+
+   if (parser->header == HTTP_HEADER_CONTENT_LENGTH) {
+      parser->content_length_present = true;
+      parser->content_length = 0;
+   } else if (parser->header == HTTP_HEADER_CONTENT_RANGE) {
+      parser->content_range_present = false;
+      parser->range_start = 0;
+      parser->range_total = 0;
+   } else if (parser->header == HTTP_HEADER_ETAG) {
+      parser->etag_hash = ETAG_HASH_OFFSET_BASIS;
+   } else if (parser->header == HTTP_HEADER_FIRMWARE_SHA256) {
+      parser->sha256_digits = 0;
+   }
+   parser->value_match_position = 0;
+   parser->value_started = false;
+   parser->value_space_pending = false;
+   parser->state = HTTP_PARSER_HEADER_VALUE;
+}
+
+static void parse_header_name_character(http_response_parser_t *parser, char character) {
+   if (character == ':') {
+      on_header_name_end(parser);
+      return;
+   } else if (character == '\n') {
+      parser->state = HTTP_PARSER_ERROR;
+      return;
+   }
+
+   character = to_lower_case(character);
+
+   for (unsigned char i = 0; i < KNOWN_HEADERS_AMOUNT; i++) {
+      // A NUL character in the name must not match the end of a known name and step past it
+      if ((parser->header_candidates & (1 << i)) &&
+            (KNOWN_HEADERS[i][parser->line_position] == '\0' || KNOWN_HEADERS[i][parser->line_position] != character)) {
+         parser->header_candidates &= ~(1 << i);
+      }
+   }
+
+   if (parser->header_candidates) {
+      parser->line_position++;
+   }
+}
+
+static bool append_decimal_digit(http_response_parser_t *parser, unsigned int *value, char character) {
+   if (character < '0' || character > '9' || *value > (HTTP_RESPONSE_PARSER_MAX_CONTENT_LENGTH - 9) / 10) {
+      parser->state = HTTP_PARSER_ERROR;
+      return false;
+   }
+   *value = *value * 10 + character - '0';
+   return true;
+}
+
+/**
+ * "bytes 4096-190463/190464", the space after the unit is skipped with it. Unknown total length ("*") leaves the range absent.
+ */
+static void parse_content_range_character(http_response_parser_t *parser, char character) {
+   switch (parser->value_match_position) {
+      case CONTENT_RANGE_UNIT:
+         if (character >= '0' && character <= '9') {
+            parser->value_match_position = CONTENT_RANGE_START;
+            append_decimal_digit(parser, &parser->range_start, character);
+         }
+         break;
+      case CONTENT_RANGE_START:
+         if (character == '-') {
+            parser->value_match_position = CONTENT_RANGE_END;
+         } else {
+            append_decimal_digit(parser, &parser->range_start, character);
+         }
+         break;
+      case CONTENT_RANGE_END:
+         if (character == '/') {
+            parser->value_match_position = CONTENT_RANGE_TOTAL;
+         }
+         break;
+      default:
+         if (character != '*' && append_decimal_digit(parser, &parser->range_total, character)) {
+            parser->content_range_present = true;
+         }
+         break;
+   }
+}
+
+static void parse_sha256_character(http_response_parser_t *parser, char character) {
+   signed char digit = hex_digit_value(character);
+
+   if (parser->sha256_digits == SHA256_DIGITS_INVALID) {
+      return;
+   } else if (digit < 0 || parser->sha256_digits >= HTTP_RESPONSE_PARSER_SHA256_SIZE * 2) {
+      parser->sha256_digits = SHA256_DIGITS_INVALID;
+      return;
+   }
+
+   if (parser->sha256_digits % 2 == 0) {
+      parser->sha256[parser->sha256_digits / 2] = digit << 4;
+   } else {
+      parser->sha256[parser->sha256_digits / 2] |= digit;
+   }
+   parser->sha256_digits++;
+}
+
+static void parse_header_value_token(http_response_parser_t *parser, char character) {
+   switch (parser->header) {
+      case HTTP_HEADER_CONTENT_LENGTH:
+         append_decimal_digit(parser, &parser->content_length, character);
+         break;
+      case HTTP_HEADER_TRANSFER_ENCODING:
+         // Only the final transfer coding tells that the body is chunked
+         if (character == ',' || character == '\n') {
+            parser->chunked = match_value_token(parser, CHUNKED_VALUE, character);
+         } else {
+            match_value_token(parser, CHUNKED_VALUE, character);
+         }
+         break;
+      case HTTP_HEADER_CONNECTION:
+         if (match_value_token(parser, CLOSE_VALUE, character)) {
+            parser->connection_close = true;
+         }
+         break;
+      case HTTP_HEADER_CONTENT_RANGE:
+         parse_content_range_character(parser, character);
+         break;
+      case HTTP_HEADER_ETAG:
+         parser->etag_hash = (parser->etag_hash ^ (unsigned char) character) * ETAG_HASH_PRIME;
+         break;
+      case HTTP_HEADER_FIRMWARE_SHA256:
+         parse_sha256_character(parser, character);
+         break;
+      default:
+         break;
+   }
+}
+
+static void parse_header_value_character(http_response_parser_t *parser, char character) {
+   if (character == '\n') {
+      parser->state = HTTP_PARSER_HEADER_LINE_START;
+
+      // The end of the list value
+      if (parser->header == HTTP_HEADER_TRANSFER_ENCODING || parser->header == HTTP_HEADER_CONNECTION) {
+         parse_header_value_token(parser, character);
+      }
+      return;
+   } else if (character == '\r') {
+      return;
+   } else if (character == ' ' || character == '\t') {
+      parser->value_space_pending = parser->value_started;
+      return;
+   }
+
+   if (parser->value_space_pending) {
+      parser->value_space_pending = false;
+      parse_header_value_token(parser, ' ');
+
+      if (parser->state == HTTP_PARSER_ERROR) {
+         return;
+      }
+   }
+   parser->value_started = true;
+   parse_header_value_token(parser, character);
+}
+
+static void parse_status_line_character(http_response_parser_t *parser, char character) {
+   // "HTTP/1.1 200 OK\r\n". line_position: 0 - version, 1..3 - status code digits, 4 - reason phrase
+   if (character == '\n') {
+      if (parser->line_position < 4) {
+         parser->state = HTTP_PARSER_ERROR;
+      } else {
+         parser->state = HTTP_PARSER_HEADER_LINE_START;
+      }
+      return;
+   }
+
+   if (parser->line_position == 0) {
+      // value_match_position counts the checked characters of the version prefix
+      if (parser->value_match_position < sizeof(HTTP_VERSION_PREFIX) - 1) {
+         if (character != HTTP_VERSION_PREFIX[parser->value_match_position]) {
+            parser->state = HTTP_PARSER_ERROR;
+            return;
+         }
+         parser->value_match_position++;
+      } else if (character == ' ') {
+         parser->line_position = 1;
+      }
+   } else if (parser->line_position <= 3) {
+      if (character < '0' || character > '9') {
+         parser->state = HTTP_PARSER_ERROR;
+         return;
+      }
+      parser->status_code = parser->status_code * 10 + character - '0';
+      parser->line_position++;
+   }
+}
+
+static void parse_chunk_size_character(http_response_parser_t *parser, char character) {
+   if (character == '\n') {
+      if (parser->line_position == 0) {
+         parser->state = HTTP_PARSER_ERROR;
+      } else if (parser->remaining_bytes == 0) {
+         parser->line_position = 0;
+         parser->state = HTTP_PARSER_TRAILER;
+      } else {
+         parser->state = HTTP_PARSER_CHUNK_DATA;
+      }
+      return;
+   } else if (character == '\r') {
+      return;
+   } else if (character == ';') {
+      parser->state = HTTP_PARSER_CHUNK_EXTENSION;
+      return;
+   }
+
+   signed char digit = hex_digit_value(character);
+
+   if (digit < 0 || parser->remaining_bytes > (HTTP_RESPONSE_PARSER_MAX_CONTENT_LENGTH >> 4)) {
+      parser->state = HTTP_PARSER_ERROR;
+      return;
+   }
+   parser->remaining_bytes = (parser->remaining_bytes << 4) | digit;
+   parser->line_position = 1;
+}
+
+/**
+ * Parses the received chunk. Returns the amount of consumed bytes, which is less than length only when the response
+ * has been finished (the rest belongs to the next response) or on error.
+ */
+size_t http_response_parser_execute(http_response_parser_t *parser, const char *data, size_t length) {
+   size_t position = 0;
+
+   while (position < length) {
+      char character = data[position];
+
+      switch (parser->state) {
+         case HTTP_PARSER_STATUS_LINE:
+            parse_status_line_character(parser, character);
+            position++;
+            break;
+         case HTTP_PARSER_HEADER_LINE_START:
+            if (character == '\n') {
+               on_headers_end(parser);
+            } else if (character != '\r') {
+               parser->line_position = 0;
+               parser->header_candidates = ALL_HEADERS_CANDIDATES;
+               parser->state = HTTP_PARSER_HEADER_NAME;
+               parse_header_name_character(parser, character);
+            }
+            position++;
+            break;
+         case HTTP_PARSER_HEADER_NAME:
+            parse_header_name_character(parser, character);
+            position++;
+            break;
+         case HTTP_PARSER_HEADER_VALUE:
+            parse_header_value_character(parser, character);
+            position++;
+            break;
+         case HTTP_PARSER_BODY:
+         case HTTP_PARSER_CHUNK_DATA:
+         case HTTP_PARSER_BODY_UNTIL_CLOSE: {
+            size_t body_bytes = length - position;
+
+            if (parser->state != HTTP_PARSER_BODY_UNTIL_CLOSE && body_bytes > parser->remaining_bytes) {
+               body_bytes = parser->remaining_bytes;
+            }
+
+            if (parser->on_body != NULL) {
+               parser->on_body(parser, data + position, body_bytes);
+            }
+            position += body_bytes;
+
+            if (parser->state != HTTP_PARSER_BODY_UNTIL_CLOSE) {
+               parser->remaining_bytes -= body_bytes;
+
+               if (parser->remaining_bytes == 0) {
+                  parser->state = parser->state == HTTP_PARSER_BODY ? HTTP_PARSER_DONE : HTTP_PARSER_CHUNK_DATA_END;
+               }
+            }
+            break;
+         }
+         case HTTP_PARSER_CHUNK_SIZE:
+            parse_chunk_size_character(parser, character);
+            position++;
+            break;
+         case HTTP_PARSER_CHUNK_EXTENSION:
+            if (character == '\n') {
+               parser->state = HTTP_PARSER_CHUNK_SIZE;
+               parse_chunk_size_character(parser, character);
+            }
+            position++;
+            break;
+         case HTTP_PARSER_CHUNK_DATA_END:
+            if (character == '\n') {
+               parser->line_position = 0;
+               parser->state = HTTP_PARSER_CHUNK_SIZE;
+            } else if (character != '\r') {
+               parser->state = HTTP_PARSER_ERROR;
+            }
+            position++;
+            break;
+         case HTTP_PARSER_TRAILER:
+            if (character == '\n') {
+               if (parser->line_position == 0) {
+                  parser->state = HTTP_PARSER_DONE;
+               }
+               parser->line_position = 0;
+            } else if (character != '\r') {
+               parser->line_position = 1;
+            }
+            position++;
+            break;
+         default:
+            // HTTP_PARSER_DONE and HTTP_PARSER_ERROR
+            return position;
+      }
+   }
+   return position;
+}
+
+/**
+ * Has to be called when the connection has been closed by the server. Returns true if the response is complete.
+ */
+bool http_response_parser_finish(http_response_parser_t *parser) {
+   if (parser->state == HTTP_PARSER_BODY_UNTIL_CLOSE) {
+      parser->state = HTTP_PARSER_DONE;
+   }
+   return parser->state == HTTP_PARSER_DONE;
+}
+
+bool http_response_parser_is_done(const http_response_parser_t *parser) {
+   return parser->state == HTTP_PARSER_DONE;
+}
+
+bool http_response_parser_is_error(const http_response_parser_t *parser) {
+   return parser->state == HTTP_PARSER_ERROR;
+}
+
+/**
+ * True when the headers of the final response have been parsed (the body may follow).
+ */
+bool http_response_parser_has_headers(const http_response_parser_t *parser) {
+   return parser->state >= HTTP_PARSER_BODY && parser->state != HTTP_PARSER_ERROR;
+}
+
+bool http_response_parser_has_sha256(const http_response_parser_t *parser) {
+   return parser->sha256_digits == HTTP_RESPONSE_PARSER_SHA256_SIZE * 2;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include "stdbool.h"
+#include "string.h"
+#include "global_definitions.h"
+#include "number_formatter.h"
+#include "esp_timer.h"
+
+#ifndef BOOT_PROFILER
+#define BOOT_PROFILER
+
+// Enough for all the phases with 6 digit times
+#define BOOT_PROFILER_TIMELINE_MAX_LENGTH 128
+
+typedef enum {
+   BOOT_PHASE_START = 0,
+   BOOT_PHASE_PINS,
+   BOOT_PHASE_UART,
+   BOOT_PHASE_TCPIP_ADAPTER,
+   BOOT_PHASE_WIFI_START,
+   BOOT_PHASE_GOT_IP,
+   BOOT_PHASE_FIRST_SENSOR_READ,
+   BOOT_PHASE_FIRST_RESPONSE_OK,
+   BOOT_PHASES_AMOUNT
+} boot_phase_t;
+
+/**
+ * Milliseconds since the system start when each startup phase has been finished for the first time. The timeline
+ * is formatted as "name:time" pairs separated by commas, e.g. "start:92,pins:93,uart:95,...", phases not reached yet
+ * are omitted.
+ */
+void boot_profiler_mark(boot_phase_t phase);
+unsigned int boot_profiler_get_time(boot_phase_t phase);
+unsigned short boot_profiler_format_timeline(char *buffer, unsigned short buffer_size);
+void boot_profiler_print();
+
+#endif
@@ -0,0 +1,36 @@
+#include "utils.h"
+#include "sht21.h"
+
+#ifndef DEEP_SLEEP_STATE
+#define DEEP_SLEEP_STATE
+
+#define DEEP_SLEEP_STATE_MAGIC   0x5A
+#define DEEP_SLEEP_STATE_BLOCKS  6
+
+// The server has confirmed the first report after the power on, so the wakes don't repeat the reset reasons
+#define DEEP_SLEEP_STATE_FIRST_REPORT_CONFIRMED_FLAG (1 << 0)
+
+/**
+ * State of the deep sleep duty cycle, which is kept in the RTC user memory between the wakes.
+ *
+ * Layout (6 blocks): u8 magic, u8 CRC-8 of the other 23 bytes, u8 access point channel (0 - not cached), u8 flags
+ * (DEEP_SLEEP_STATE_*_FLAG);
+ * 6 bytes access point BSSID, u8 reset reason of the cycle start (esp_reset_reason_t), u8 unused; u32 wakes amount; u32 device time at the next wake, seconds;
+ * u16 awake time since the last sent report, u16 awake time of the previous report cycle, both in 10 ms units.
+ */
+typedef struct {
+   unsigned char access_point_channel;
+   unsigned char access_point_bssid[6];
+   unsigned int wakes_amount;
+   unsigned int device_time;
+   unsigned int awake_time_ms;
+   unsigned int previous_cycle_awake_time_ms;
+   bool first_report_confirmed;
+   // The wakes report it until the first report has been confirmed
+   unsigned char reset_reason;
+} deep_sleep_state_t;
+
+bool deep_sleep_state_load(deep_sleep_state_t *state, unsigned int rtc_address);
+void deep_sleep_state_save(const deep_sleep_state_t *state, unsigned int rtc_address);
+
+#endif
@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include "global_definitions.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+/**
+ * Measures time and heap usage of the code between EXECUTION_TIME_START(name) and EXECUTION_TIME_END(name, operations)
+ * in the same scope. Enabled by MONITOR_EXECUTION_TIME, otherwise the macros are empty.
+ *
+ * "operations" is the amount of processed items (bytes, iterations), used to calculate per operation values.
+ */
+#ifdef MONITOR_EXECUTION_TIME
+   #define EXECUTION_TIME_START(name) \
+      unsigned int name##_start_free_heap = esp_get_free_heap_size(); \
+      int64_t name##_start_time = esp_timer_get_time()
+   #define EXECUTION_TIME_END(name, operations) \
+      print_execution_time(#name, (unsigned int) (esp_timer_get_time() - name##_start_time), \
+            (int) name##_start_free_heap - (int) esp_get_free_heap_size(), operations)
+#else
+   #define EXECUTION_TIME_START(name)
+   #define EXECUTION_TIME_END(name, operations)
+#endif
+
+#ifndef EXECUTION_TIME_MONITOR
+#define EXECUTION_TIME_MONITOR
+
+#ifdef MONITOR_EXECUTION_TIME
+static inline void print_execution_time(const char *name, unsigned int elapsed_us, int allocated_bytes,
+                                        unsigned int operations) {
+   if (operations == 0) {
+      operations = 1;
+   }
+
+   // One line per measurement, so it can be collected from UART output into CSV
+   printf("\nEXECUTION_TIME,%s,%u,%u,%u,%d,%u\n", name, operations, elapsed_us, (unsigned int) ((unsigned long long) elapsed_us * 1000 / operations),
+         allocated_bytes, elapsed_us == 0 ? 0 : (unsigned int) ((unsigned long long) operations * 1000000 / elapsed_us));
+}
+#endif
+
+#endif
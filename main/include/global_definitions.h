@@ -1,3 +1,12 @@
 //#define ALLOW_USE_PRINTF
 //#define USE_MALLOC_LOGGER
 //#define MONITOR_STACK_SIZE
+//#define MONITOR_EXECUTION_TIME
+//#define USE_BINARY_STATUS_PAYLOAD
+//#define USE_UDP_STATUS_REPORTS
+//#define UDP_REPLY_EXPECTED
+//#define USE_MQTT
+//#define USE_CHANGE_DRIVEN_REPORTS
+//#define USE_RTC_SAMPLE_BUFFER
+//#define USE_DEEP_SLEEP
+//#define USE_COMPRESSED_FIRMWARE
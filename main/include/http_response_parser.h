@@ -0,0 +1,84 @@
+#include "stdbool.h"
+#include "stddef.h"
+#include "string.h"
+
+#ifndef HTTP_RESPONSE_PARSER
+#define HTTP_RESPONSE_PARSER
+
+#define HTTP_RESPONSE_PARSER_MAX_CONTENT_LENGTH 0x0FFFFFFF
+#define HTTP_RESPONSE_PARSER_SHA256_SIZE        32
+
+typedef enum {
+   HTTP_PARSER_STATUS_LINE = 0,
+   HTTP_PARSER_HEADER_LINE_START,
+   HTTP_PARSER_HEADER_NAME,
+   HTTP_PARSER_HEADER_VALUE,
+   HTTP_PARSER_BODY,
+   HTTP_PARSER_BODY_UNTIL_CLOSE,
+   HTTP_PARSER_CHUNK_SIZE,
+   HTTP_PARSER_CHUNK_EXTENSION,
+   HTTP_PARSER_CHUNK_DATA,
+   HTTP_PARSER_CHUNK_DATA_END,
+   HTTP_PARSER_TRAILER,
+   HTTP_PARSER_DONE,
+   HTTP_PARSER_ERROR
+} http_parser_state_t;
+
+typedef enum {
+   HTTP_HEADER_CONTENT_LENGTH = 0,
+   HTTP_HEADER_TRANSFER_ENCODING,
+   HTTP_HEADER_CONNECTION,
+   HTTP_HEADER_CONTENT_RANGE,
+   HTTP_HEADER_ETAG,
+   HTTP_HEADER_FIRMWARE_SHA256,
+   HTTP_HEADER_UNKNOWN
+} http_header_t;
+
+/**
+ * Push style HTTP/1.x response parser. It keeps its state between received chunks, so a response can be split
+ * at any byte. Body bytes (already de-chunked) are passed to on_body() pointing into the input data.
+ */
+typedef struct http_response_parser {
+   http_parser_state_t state;
+   unsigned short status_code;
+   bool content_length_present;
+   bool chunked;
+   bool connection_close;
+   unsigned int content_length;
+   // Remaining body bytes or remaining bytes of the current chunk
+   unsigned int remaining_bytes;
+
+   // "Content-Range: bytes <range_start>-<end>/<range_total>"
+   bool content_range_present;
+   unsigned int range_start;
+   unsigned int range_total;
+   // FNV-1a hash of the ETag value (without surrounding whitespace), 0 if there is no ETag
+   unsigned int etag_hash;
+   // X-Firmware-SHA256 (hexadecimal). Amount of the parsed digits, 0xFF if the value is malformed
+   unsigned char sha256_digits;
+   unsigned char sha256[HTTP_RESPONSE_PARSER_SHA256_SIZE];
+
+   // Internal state of the current line
+   unsigned char line_position;
+   unsigned char header_candidates;
+   http_header_t header;
+   unsigned char value_match_position;
+   // Leading whitespace of the value is skipped, a run of inner whitespace is passed as one space on the next character
+   bool value_started;
+   bool value_space_pending;
+
+   void (*on_body)(struct http_response_parser *parser, const char *data, size_t length);
+   void *context;
+} http_response_parser_t;
+
+void http_response_parser_init(http_response_parser_t *parser,
+                               void (*on_body)(http_response_parser_t *parser, const char *data, size_t length),
+                               void *context);
+size_t http_response_parser_execute(http_response_parser_t *parser, const char *data, size_t length);
+bool http_response_parser_finish(http_response_parser_t *parser);
+bool http_response_parser_is_done(const http_response_parser_t *parser);
+bool http_response_parser_is_error(const http_response_parser_t *parser);
+bool http_response_parser_has_headers(const http_response_parser_t *parser);
+bool http_response_parser_has_sha256(const http_response_parser_t *parser);
+
+#endif
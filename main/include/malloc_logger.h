@@ -11,8 +11,9 @@
    #define ZALLOC(element_length, allocated_time)  malloc_logger(element_length, allocated_time, __ESP_FILE__, __LINE__, true)
 #else
    #define FREE(allocated_address_element_to_free) os_free(allocated_address_element_to_free)
-   #define MALLOC(element_length, allocated_time)  os_malloc(element_length)
-   #define ZALLOC(element_length, allocated_time)  os_zalloc(element_length)
+   // allocated_time is only used by the logger
+   #define MALLOC(element_length, allocated_time)  ((void) (allocated_time), os_malloc(element_length))
+   #define ZALLOC(element_length, allocated_time)  ((void) (allocated_time), os_zalloc(element_length))
 #endif
 
 #ifndef MALLOC_LOGGER
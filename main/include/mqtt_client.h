@@ -0,0 +1,53 @@
+#include "utils.h"
+#include "freertos/semphr.h"
+
+#ifndef MQTT_CLIENT
+#define MQTT_CLIENT
+
+// Can be overridden in device_settings.h, e.g. to use a local broker
+#ifndef MQTT_BROKER_IP_ADDRESS
+#define MQTT_BROKER_IP_ADDRESS SERVER_IP_ADDRESS
+#endif
+#ifndef MQTT_BROKER_PORT
+#define MQTT_BROKER_PORT 1883
+#endif
+
+#ifndef MQTT_RESPONSE_TIMEOUT_MS
+#define MQTT_RESPONSE_TIMEOUT_MS    (5 * 1000)
+#endif
+
+#define MQTT_KEEP_ALIVE_S           60
+#define MQTT_RECEIVE_BUFFER_SIZE    128
+
+#define MQTT_QOS_AT_MOST_ONCE       0
+#define MQTT_QOS_AT_LEAST_ONCE      1
+
+#define MQTT_CONNECT_PACKET         0x10
+#define MQTT_CONNACK_PACKET         0x20
+#define MQTT_PUBLISH_PACKET         0x30
+#define MQTT_PUBACK_PACKET          0x40
+#define MQTT_SUBSCRIBE_PACKET       0x82
+#define MQTT_SUBACK_PACKET          0x90
+#define MQTT_PINGREQ_PACKET         0xC0
+#define MQTT_PINGRESP_PACKET        0xD0
+#define MQTT_DISCONNECT_PACKET      0xE0
+
+#define MQTT_PUBLISH_DUP_FLAG       (1 << 3)
+#define MQTT_PUBLISH_QOS_SHIFT      1
+#define MQTT_PUBLISH_RETAIN_FLAG    (1 << 0)
+
+/**
+ * Called with the received PUBLISH packet. Topic and payload point into the receive buffer, so they are valid only
+ * during the call. The handler mustn't call mqtt_* functions.
+ */
+typedef void (*mqtt_message_handler_t)(const char *topic, unsigned short topic_length, const unsigned char *payload,
+                                       unsigned short payload_length);
+
+bool mqtt_connect(const char *client_id, mqtt_message_handler_t message_handler);
+bool mqtt_is_connected();
+bool mqtt_subscribe(const char *topic, unsigned char qos);
+bool mqtt_publish(const char *topic, const unsigned char *payload, unsigned short payload_length, unsigned char qos);
+bool mqtt_process(unsigned int timeout_ms);
+void mqtt_disconnect();
+
+#endif
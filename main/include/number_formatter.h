@@ -0,0 +1,8 @@
+#ifndef NUMBER_FORMATTER
+#define NUMBER_FORMATTER
+
+unsigned char format_unsigned(char *buffer, unsigned char buffer_size, unsigned int value);
+unsigned char format_signed(char *buffer, unsigned char buffer_size, int value);
+unsigned char format_fixed_point(char *buffer, unsigned char buffer_size, int value, unsigned char fraction_digits);
+
+#endif
@@ -0,0 +1,65 @@
+#include "stdbool.h"
+#include "status_record.h"
+
+#ifndef REPORT_POLICY
+#define REPORT_POLICY
+
+typedef enum {
+   REPORT_REASON_NONE = 0,
+   REPORT_REASON_FIRST_REPORT,
+   REPORT_REASON_ERRORS,
+   REPORT_REASON_CHANGE,
+   REPORT_REASON_HEARTBEAT
+} report_reason_t;
+
+typedef struct {
+   // Hundredths of a degree/percent, the same units as in status_record_t
+   unsigned short temperature_deadband;
+   unsigned short humidity_deadband;
+   unsigned short light_deadband;
+   unsigned int heartbeat_interval_ms;
+} report_policy_config_t;
+
+/**
+ * The current values compared with the deadbands. The record carries the mean of the whole interval, which keeps
+ * aggregating over the suppressed reports, so a change would be diluted by the older samples there.
+ */
+typedef struct {
+   // Hundredths of a degree/percent, the same units as in status_record_t
+   short temperature;
+   short humidity;
+   unsigned short light;
+   bool light_present;
+} report_policy_values_t;
+
+typedef struct {
+   unsigned int suppressed_reports;
+   unsigned int first_reports;
+   unsigned int errors_reports;
+   unsigned int change_reports;
+   unsigned int heartbeat_reports;
+} report_policy_statistics_t;
+
+/**
+ * Decides whether the status has to be sent. Values are compared with the last sent report, so slow drifts
+ * are reported as soon as they exceed the deadband.
+ */
+typedef struct {
+   report_policy_config_t config;
+   report_policy_statistics_t statistics;
+   bool report_sent;
+   unsigned int last_report_time_ms;
+   short last_temperature;
+   short last_humidity;
+   unsigned short last_light;
+   unsigned short last_errors_counter;
+   unsigned char last_pending_connection_errors_counter;
+} report_policy_t;
+
+void report_policy_init(report_policy_t *policy, const report_policy_config_t *config);
+report_reason_t report_policy_evaluate(report_policy_t *policy, const status_record_t *record,
+                                       const report_policy_values_t *values, unsigned int current_time_ms);
+void report_policy_on_sent(report_policy_t *policy, const status_record_t *record,
+                           const report_policy_values_t *values, unsigned int current_time_ms);
+
+#endif
@@ -0,0 +1,37 @@
+#include "utils.h"
+#include "status_record.h"
+#include "sht21.h"
+
+#ifndef RTC_SAMPLE_BUFFER
+#define RTC_SAMPLE_BUFFER
+
+#define RTC_SAMPLE_BUFFER_MAGIC           0xA5
+#define RTC_SAMPLE_BUFFER_HEADER_BLOCKS   3
+#define RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS   2
+// Last block of the RTC user memory is 191
+#define RTC_SAMPLE_BUFFER_LAST_BLOCK      191
+
+/**
+ * Ring buffer of sensor samples in the RTC user memory, which survives soft resets and deep sleep.
+ *
+ * Header (3 blocks): u8 magic, u8 head slot, u8 samples amount, u8 CRC-8 of the rest of the header;
+ * u32 sequence number of the oldest sample; u32 device time of the last write.
+ * Sample (2 blocks): u24 time, u8 CRC-8 of the other 7 bytes, i16 temperature, i16 humidity.
+ * A sample with wrong CRC is skipped on reading, wrong header CRC clears the whole buffer.
+ */
+typedef struct {
+   unsigned int rtc_address;
+   unsigned char capacity;
+   unsigned char head;
+   unsigned char samples_amount;
+   unsigned int oldest_sequence;
+   unsigned int last_time;
+} rtc_sample_buffer_t;
+
+bool rtc_sample_buffer_init(rtc_sample_buffer_t *buffer, unsigned int rtc_address, unsigned char capacity);
+void rtc_sample_buffer_push(rtc_sample_buffer_t *buffer, const sample_record_t *sample);
+unsigned char rtc_sample_buffer_read(const rtc_sample_buffer_t *buffer, sample_record_t samples[],
+                                     unsigned char max_samples_amount, unsigned int *end_sequence);
+void rtc_sample_buffer_remove(rtc_sample_buffer_t *buffer, unsigned int end_sequence);
+
+#endif
@@ -0,0 +1,61 @@
+#include "stdbool.h"
+#include "string.h"
+
+#ifndef SENSOR_STATISTICS
+#define SENSOR_STATISTICS
+
+#define MEDIAN_FILTER_SIZE 3
+// Fraction bits of the running mean, so the rounding of every update stays far below one unit of the value
+#define RUNNING_STATISTICS_MEAN_SHIFT 4
+// The counts stop here. Then every new value still moves the mean and the variance by 1/count of the difference
+#define SENSOR_STATISTICS_MAX_COUNT 0xFFFF
+
+/**
+ * Small median filter which rejects out of range values (e.g. SHT21_*_ERROR_CENTI sentinels) and spikes, i.e. values
+ * too far from the median of the last accepted ones. If MEDIAN_FILTER_SIZE values in a row are rejected as spikes,
+ * the filter is restarted from the new value, so a real step change isn't rejected forever.
+ */
+typedef struct {
+   int values[MEDIAN_FILTER_SIZE];
+   unsigned char values_amount;
+   unsigned char position;
+   unsigned char consecutive_spikes;
+   int min_value;
+   int max_value;
+   int spike_threshold;
+} median_filter_t;
+
+/**
+ * Constant memory min/max/mean/variance of the values added since the last reset (Welford's algorithm in fixed point,
+ * the device has no FPU).
+ */
+typedef struct {
+   unsigned short count;
+   int min;
+   int max;
+   // Mean << RUNNING_STATISTICS_MEAN_SHIFT
+   int mean;
+   // Sum of the squared differences from the mean << (2 * RUNNING_STATISTICS_MEAN_SHIFT)
+   long long m2;
+} running_statistics_t;
+
+typedef struct {
+   median_filter_t filter;
+   running_statistics_t statistics;
+   unsigned short rejected_amount;
+} sensor_statistics_t;
+
+void median_filter_init(median_filter_t *filter, int min_value, int max_value, int spike_threshold);
+bool median_filter_add(median_filter_t *filter, int value, int *filtered_value);
+bool median_filter_get_value(const median_filter_t *filter, int *filtered_value);
+void running_statistics_reset(running_statistics_t *statistics);
+void running_statistics_add(running_statistics_t *statistics, int value);
+int running_statistics_get_mean(const running_statistics_t *statistics);
+unsigned int running_statistics_get_standard_deviation(const running_statistics_t *statistics);
+void sensor_statistics_init(sensor_statistics_t *sensor_statistics, int min_value, int max_value,
+                            int spike_threshold);
+bool sensor_statistics_add(sensor_statistics_t *sensor_statistics, int value);
+bool sensor_statistics_reject(sensor_statistics_t *sensor_statistics);
+void sensor_statistics_reset(sensor_statistics_t *sensor_statistics);
+
+#endif
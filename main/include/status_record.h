@@ -0,0 +1,94 @@
+#include "stdbool.h"
+#include "string.h"
+
+#ifndef STATUS_RECORD
+#define STATUS_RECORD
+
+#define STATUS_RECORD_VERSION          5
+#define STATUS_RECORD_FIXED_PART_SIZE  46
+#define STATUS_RECORD_MAX_STRING_SIZE  255
+
+#define STATUS_DATAGRAM_TYPE           1
+#define STATUS_DATAGRAM_REPLY_TYPE     2
+#define STATUS_DATAGRAM_HEADER_SIZE    5
+#define STATUS_DATAGRAM_REPLY_SIZE     6
+
+#define STATUS_DATAGRAM_UPDATE_FIRMWARE_COMMAND (1 << 0)
+
+#define SAMPLE_BATCH_VERSION           1
+#define SAMPLE_BATCH_FIXED_PART_SIZE   6
+#define SAMPLE_BATCH_ENTRY_SIZE        8
+#define SAMPLE_BATCH_DATAGRAM_TYPE     3
+
+#define STATUS_RECORD_LIGHT_PRESENT_FLAG  (1 << 0)
+#define STATUS_RECORD_FIRST_REPORT_FLAG   (1 << 1)
+
+/**
+ * All the fields of the status report. String fields are \0 terminated, build_timestamp, reset_reason,
+ * system_restart_reason and boot_timeline are sent only with the first report after start.
+ */
+typedef struct {
+   signed char signal_strength;
+   unsigned short errors_counter;
+   unsigned char pending_connection_errors_counter;
+   unsigned int uptime;
+   unsigned int free_heap_space;
+   // Mean of the filtered samples since the last sent report or the last sample if there are no valid ones
+   short temperature;      // hundredths of a degree
+   short temperature_min;
+   short temperature_max;
+   unsigned short temperature_deviation;
+   unsigned short temperature_raw;
+   short humidity;         // hundredths of a percent
+   short humidity_min;
+   short humidity_max;
+   unsigned short humidity_deviation;
+   // Sensor samplings in the interval and rejected temperature and humidity readings
+   unsigned short samples_amount;
+   unsigned short rejected_samples_amount;
+   bool light_present;
+   unsigned short light;
+   // Reports skipped by the change driven reporting policy since start
+   unsigned int suppressed_reports;
+   // Deep sleep mode: awake time of all the wakes of the previous report cycle, milliseconds
+   unsigned int awake_time;
+   bool first_report;
+   const char *device_name;
+   const char *build_timestamp;
+   const char *reset_reason;
+   const char *system_restart_reason;
+   // Startup phases timeline, see boot_profiler_format_timeline()
+   const char *boot_timeline;
+} status_record_t;
+
+/**
+ * Timestamped sensor sample. Time is in seconds of the device time, which keeps counting across soft resets and
+ * deep sleep, so the collector can place samples relative to the current device time sent in the batch.
+ */
+typedef struct {
+   unsigned int time;
+   short temperature;      // hundredths of a degree
+   short humidity;         // hundredths of a percent
+} sample_record_t;
+
+unsigned short get_status_record_encoded_length(const status_record_t *record);
+unsigned short encode_status_record(const status_record_t *record, unsigned char *buffer, unsigned short buffer_size);
+bool decode_status_record(const unsigned char *buffer, unsigned short length, status_record_t *record,
+                          char *strings_buffer, unsigned short strings_buffer_size);
+void encode_datagram_header(unsigned char type, unsigned int sequence, unsigned char *buffer);
+unsigned short encode_status_datagram(const status_record_t *record, unsigned int sequence, unsigned char *buffer,
+                                      unsigned short buffer_size);
+bool decode_status_datagram(const unsigned char *buffer, unsigned short length, unsigned int *sequence,
+                            status_record_t *record, char *strings_buffer, unsigned short strings_buffer_size);
+unsigned short encode_status_datagram_reply(unsigned int sequence, unsigned char commands, unsigned char *buffer);
+bool decode_status_datagram_reply(const unsigned char *buffer, unsigned short length, unsigned int sequence,
+                                  unsigned char *commands);
+unsigned short get_sample_batch_encoded_length(unsigned char samples_amount, const char *device_name);
+unsigned short encode_sample_batch(const sample_record_t samples[], unsigned char samples_amount,
+                                   unsigned int current_time, const char *device_name, unsigned char *buffer,
+                                   unsigned short buffer_size);
+bool decode_sample_batch(const unsigned char *buffer, unsigned short length, unsigned int *current_time,
+                         sample_record_t samples[], unsigned char max_samples_amount, unsigned char *samples_amount,
+                         char *device_name_buffer, unsigned short device_name_buffer_size);
+
+#endif
@@ -0,0 +1,32 @@
+#include "stdbool.h"
+#include "string.h"
+
+#ifndef TEMPLATE_RENDERER
+#define TEMPLATE_RENDERER
+
+#define TEMPLATE_MAX_SEGMENTS    56
+#define TEMPLATE_MAX_PARAMETERS  28
+
+/**
+ * One piece of a compiled template. Literal segments point into the original template string,
+ * parameter segments (literal == NULL) keep zero based parameter index in "value".
+ */
+typedef struct {
+   const char *literal;
+   unsigned short value;
+} template_segment_t;
+
+typedef struct {
+   template_segment_t segments[TEMPLATE_MAX_SEGMENTS];
+   unsigned char segments_amount;
+   unsigned char parameters_amount;
+   unsigned short literals_length;
+} compiled_template_t;
+
+bool compile_template(const char string[], compiled_template_t *compiled_template);
+unsigned short get_rendered_template_length(const compiled_template_t *compiled_template, const char *parameters[],
+                                            unsigned short parameters_lengths[]);
+unsigned short render_template(const compiled_template_t *compiled_template, const char *parameters[],
+                               const unsigned short parameters_lengths[], char *buffer, unsigned short buffer_size);
+
+#endif
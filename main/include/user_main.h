@@ -14,11 +14,21 @@
 #include "esp8266/rtc_register.h"
 #include "internal/esp_system_internal.h"
 #include "esp_wifi.h"
+#include "esp_sleep.h"
 #include "string.h"
 #include "utils.h"
+#include "number_formatter.h"
+#include "status_record.h"
+#include "report_policy.h"
+#include "sensor_statistics.h"
+#include "rtc_sample_buffer.h"
+#include "deep_sleep_state.h"
+#include "boot_profiler.h"
+#include "mqtt_client.h"
 #include "event_groups.h"
 #include "global_definitions.h"
 #include "malloc_logger.h"
+#include "execution_time_monitor.h"
 
 // components
 #include "sht21.h"
@@ -56,6 +66,82 @@
 #define STATUS_REQUESTS_SEND_INTERVAL     (STATUS_REQUESTS_SEND_INTERVAL_MS / portTICK_RATE_MS) // 30 sec
 
 #define ERRORS_CHECKER_INTERVAL_MS        (10 * 1000)
+#define STARTUP_INDICATION_DURATION_MS    (3 * 1000)
+#define STATUS_DATAGRAM_REPLY_TIMEOUT_MS  1000
+#define SENSOR_SAMPLING_INTERVAL_MS       (5 * 1000)
+
+// Valid ranges of the SHT21 conversion formulas, anything else is an error sentinel
+#define SENSOR_TEMPERATURE_MIN            (-4685)
+#define SENSOR_TEMPERATURE_MAX            12888
+#define SENSOR_TEMPERATURE_SPIKE          500  // 5 degrees between samples
+#define SENSOR_HUMIDITY_MIN               (-600)
+#define SENSOR_HUMIDITY_MAX               11900
+#define SENSOR_HUMIDITY_SPIKE             1500 // 15 %
+// Change driven reporting (USE_CHANGE_DRIVEN_REPORTS). Can be overridden in device_settings.h
+#ifndef REPORT_TEMPERATURE_DEADBAND
+#define REPORT_TEMPERATURE_DEADBAND       20  // 0.2 degree
+#endif
+#ifndef REPORT_HUMIDITY_DEADBAND
+#define REPORT_HUMIDITY_DEADBAND          100 // 1 %
+#endif
+#ifndef REPORT_LIGHT_DEADBAND
+#define REPORT_LIGHT_DEADBAND             20
+#endif
+#ifndef REPORT_HEARTBEAT_INTERVAL_MS
+#define REPORT_HEARTBEAT_INTERVAL_MS      (5 * 60 * 1000)
+#endif
+
+#define MQTT_PROCESS_INTERVAL_MS          1000
+#define MQTT_RECONNECTION_INTERVAL_MS     (10 * 1000)
+
+#if defined(USE_MQTT) && defined(USE_UDP_STATUS_REPORTS)
+#error "Only one of USE_MQTT and USE_UDP_STATUS_REPORTS can be defined"
+#endif
+
+// Deep sleep duty cycle: the device wakes, measures, reports and sleeps again
+#ifndef DEEP_SLEEP_INTERVAL_MS
+#define DEEP_SLEEP_INTERVAL_MS            STATUS_REQUESTS_SEND_INTERVAL_MS
+#endif
+// Wi-Fi is used only on every n-th wake, the other wakes only buffer the sample in the RTC memory
+#ifndef DEEP_SLEEP_REPORT_INTERVAL_WAKES
+#ifdef USE_RTC_SAMPLE_BUFFER
+#define DEEP_SLEEP_REPORT_INTERVAL_WAKES  6
+#else
+#define DEEP_SLEEP_REPORT_INTERVAL_WAKES  1
+#endif
+#endif
+// The device goes to sleep even if the report couldn't be sent
+#define DEEP_SLEEP_MAX_AWAKE_TIME_MS      (15 * 1000)
+// esp_deep_sleep_set_rf_option() values
+#define DEEP_SLEEP_RF_DEFAULT             0
+#define DEEP_SLEEP_RF_DISABLED            4
+
+#ifdef USE_DEEP_SLEEP
+#ifdef USE_MQTT
+#error "USE_DEEP_SLEEP needs a transport without a persistent connection"
+#endif
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+#error "Report policy state is lost in deep sleep, USE_CHANGE_DRIVEN_REPORTS can't be used with USE_DEEP_SLEEP"
+#endif
+#if !defined(USE_RTC_SAMPLE_BUFFER) && DEEP_SLEEP_REPORT_INTERVAL_WAKES > 1
+#error "Samples of the wakes without reports are kept only with USE_RTC_SAMPLE_BUFFER"
+#endif
+#endif
+
+// Topics are per device. The broker queues the commands while the device is offline
+#define MQTT_STATUS_TOPIC  "esp8266/" DEVICE_NAME "/status"
+#define MQTT_SAMPLES_TOPIC "esp8266/" DEVICE_NAME "/samples"
+#define MQTT_COMMAND_TOPIC "esp8266/" DEVICE_NAME "/command"
+#define MQTT_COMMAND_MAX_LENGTH 64
+
+#ifndef MQTT_STATUS_QOS
+#define MQTT_STATUS_QOS MQTT_QOS_AT_LEAST_ONCE
+#endif
+
+// Can be overridden in device_settings.h, e.g. SHT21_RESOLUTION_RH11_T11 for battery powered devices
+#ifndef SHT21_MEASUREMENT_RESOLUTION
+#define SHT21_MEASUREMENT_RESOLUTION SHT21_RESOLUTION_RH12_T14
+#endif
 
 #define MILLISECONDS_COUNTER_DIVIDER 10
 
@@ -66,6 +152,36 @@
 
 #define SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS  64
 #define CONNECTION_ERROR_CODE_RTC_ADDRESS       SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS + 1
+#define SAMPLE_BUFFER_RTC_ADDRESS               (CONNECTION_ERROR_CODE_RTC_ADDRESS + 1)
+// 3 header blocks + 2 blocks per sample
+#define SAMPLE_BUFFER_CAPACITY                  55
+#define DEEP_SLEEP_STATE_RTC_ADDRESS            (SAMPLE_BUFFER_RTC_ADDRESS + RTC_SAMPLE_BUFFER_HEADER_BLOCKS + \
+                                                 SAMPLE_BUFFER_CAPACITY * RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS)
+
+#if DEEP_SLEEP_STATE_RTC_ADDRESS + DEEP_SLEEP_STATE_BLOCKS > OTA_CHECKPOINT_RTC_ADDRESS
+#error "RTC memory of main overlaps the OTA checkpoint"
+#endif
+
+// Room for the datagram header before the sample batch
+#ifdef USE_UDP_STATUS_REPORTS
+#define SAMPLE_BATCH_PAYLOAD_OFFSET STATUS_DATAGRAM_HEADER_SIZE
+#else
+#define SAMPLE_BATCH_PAYLOAD_OFFSET 0
+#endif
+
+#define MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+typedef struct {
+   int temperature; // hundredths of a degree
+   unsigned short temperature_raw;
+   int humidity;    // hundredths of a percent
+   unsigned int timestamp; // milliseconds_counter_g value
+} sensor_sample_t;
+
+typedef struct {
+   unsigned int sequence;
+   sensor_sample_t sample;
+} sensor_sample_mailbox_t;
 
 typedef enum {
    ACCESS_POINT_CONNECTION_ERROR = 1,
@@ -78,6 +194,8 @@ const char BLINK_ON_WIFI_CONNECTION_TASK_NAME[] = "blink_on_wifi_connection_task
 const char SCAN_ACCESS_POINT_TASK_NAME[] = "scan_access_point_task";
 const char BLINK_LEDS_WHILE_UPDATING_TASK_NAME[] = "blink_leds_while_updating_task";
 const char UART_EVENT_TASK_NAME[] = "uart_event_task";
+const char SENSOR_SAMPLING_TASK_NAME[] = "sensor_sampling_task";
+const char MQTT_TASK_NAME[] = "mqtt_task";
 
 const char RESPONSE_SERVER_SENT_OK[] = "\"statusCode\":\"OK\"";
 const char STATUS_INFO_POST_REQUEST[] =
@@ -86,9 +204,25 @@ const char STATUS_INFO_POST_REQUEST[] =
       "Host: <2>\r\n"
       "User-Agent: ESP8266\r\n"
       "Content-Type: application/json\r\n"
-      "Connection: close\r\n"
-      "Accept: application/json\r\n\r\n"
-      "<3>\r\n";
+      "Connection: keep-alive\r\n"
+      "Accept: application/json\r\n\r\n";
+const char STATUS_INFO_BINARY_POST_REQUEST[] =
+      "POST /server/esp8266/statusInfo/binary HTTP/1.1\r\n"
+      "Content-Length: <1>\r\n"
+      "Host: <2>\r\n"
+      "User-Agent: ESP8266\r\n"
+      "Content-Type: application/octet-stream\r\n"
+      "Connection: keep-alive\r\n"
+      "Accept: application/json\r\n\r\n";
+const char SAMPLE_BATCH_POST_REQUEST[] =
+      "POST /server/esp8266/samples HTTP/1.1\r\n"
+      "Content-Length: <1>\r\n"
+      "Host: <2>\r\n"
+      "User-Agent: ESP8266\r\n"
+      "Content-Type: application/octet-stream\r\n"
+      "Connection: keep-alive\r\n"
+      "Accept: application/json\r\n\r\n";
+// Fields of the disabled features aren't sent. <21> is either empty or the fields of the first report
 const char STATUS_INFO_REQUEST_PAYLOAD_TEMPLATE[] =
       "{"
       "\"gain\":\"<1>\","
@@ -96,15 +230,30 @@ const char STATUS_INFO_REQUEST_PAYLOAD_TEMPLATE[] =
       "\"errors\":<3>,"
       "\"pendingConnectionErrors\":<4>,"
       "\"uptime\":<5>,"
-      "\"buildTimestamp\":\"<6>\","
-      "\"freeHeapSpace\":<7>,"
-      "\"resetReason\":\"<8>\","
-      "\"systemRestartReason\":\"<9>\","
-      "\"temperature\":<10>,"
-      "\"temperatureRaw\":<11>,"
-      "\"humidity\":<12>,"
-      "\"light\":<13>"
+      "\"freeHeapSpace\":<6>,"
+      "\"temperature\":<7>,"
+      "\"temperatureRaw\":<8>,"
+      "\"humidity\":<9>,"
+      "\"light\":<10>,"
+      "\"temperatureMin\":<11>,"
+      "\"temperatureMax\":<12>,"
+      "\"temperatureDeviation\":<13>,"
+      "\"humidityMin\":<14>,"
+      "\"humidityMax\":<15>,"
+      "\"humidityDeviation\":<16>,"
+      "\"samples\":<17>,"
+      "\"rejectedSamples\":<18>"
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+      ",\"suppressedReports\":<19>"
+#endif
+#ifdef USE_DEEP_SLEEP
+      ",\"awakeTime\":<20>"
+#endif
+      "<21>"
       "}";
+// Sent with the first report only, the empty ones are omitted
+const char *const STATUS_INFO_FIRST_REPORT_FIELD_NAMES[] =
+      {"buildTimestamp", "resetReason", "systemRestartReason", "bootTimeline"};
 const char UPDATE_FIRMWARE[] = "\"updateFirmware\":true";
 
 static void pins_config();
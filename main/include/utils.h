@@ -4,6 +4,8 @@
 #include "device_settings.h"
 #include "global_definitions.h"
 #include "malloc_logger.h"
+#include "http_response_parser.h"
+#include "template_renderer.h"
 #include "esp_err.h"
 #include "esp_event_loop.h"
 #include "esp_system.h"
@@ -18,18 +20,39 @@
 
 #define HEXADECIMAL_ADDRESS_FORMAT "%08x"
 #define WI_FI_RECONNECTION_INTERVAL_MS (30 * 1000)
+#define HTTP_SERVER_RECEIVE_TIMEOUT_MS (10 * 1000)
+#define RESPONSE_RECEIVE_BUFFER_SIZE 128
+
+#ifndef SERVER_UDP_PORT
+#define SERVER_UDP_PORT SERVER_PORT
+#endif
 
 #define RTC_MEM_BASE 0x60001000
 
+typedef struct {
+   unsigned int new_connections;
+   unsigned int reused_connections;
+   unsigned int reconnections;
+} http_connection_statistics_t;
+
 void *set_string_parameters(const char string[], const char *parameters[]);
 char *generate_post_request(char *request);
 bool compare_strings(char *string1, char *string2);
 char *put_flash_string_into_heap(const char *flash_string, unsigned int allocated_time);
 char *generate_reset_reason();
+void wifi_set_access_point_hint(const unsigned char bssid[6], unsigned char channel);
+bool wifi_get_access_point(unsigned char bssid[6], unsigned char *channel, int *rssi);
 void wifi_init_sta(void (*on_connected)(), void (*on_disconnected)(), void (*on_connection)());
 bool is_connected_to_wifi();
 void rtc_mem_read(unsigned int src_block, void *dst, unsigned int length);
 void rtc_mem_write(unsigned int dst_block, const void *src, unsigned int length);
+int connect_to_server(const char *ip_address, unsigned short port);
 int connect_to_http_server();
+void close_http_server_connection();
+http_connection_statistics_t get_http_connection_statistics();
 char *send_request(char *request, unsigned short response_buffer_length, unsigned int invocation_time);
+char *send_request_fragments(const struct iovec fragments[], unsigned char fragments_amount,
+                             unsigned short response_buffer_size, unsigned int invocation_time);
+int send_datagram(const unsigned char *datagram, unsigned short datagram_length, unsigned char *reply,
+                  unsigned short reply_size, unsigned int reply_timeout_ms);
 #endif
@@ -0,0 +1,455 @@
+/**
+ * Minimal MQTT 3.1.1 client over one persistent TCP connection.
+ *
+ * The session isn't clean, so the broker keeps the subscriptions and queues QoS 1 messages to the device while it's
+ * disconnected. Only QoS 0 and 1 are supported. All the socket operations are guarded by the mutex, so one task may
+ * call mqtt_process() in a loop while other tasks publish.
+ */
+
+#include "mqtt_client.h"
+
+static int mqtt_socket_id_g = -1;
+static SemaphoreHandle_t mqtt_mutex_g;
+static mqtt_message_handler_t mqtt_message_handler_g;
+static unsigned short mqtt_packet_id_g;
+static TickType_t mqtt_last_sent_time_g;
+static TickType_t mqtt_ping_sent_time_g;
+static bool mqtt_ping_pending_g;
+static unsigned char mqtt_receive_buffer_g[MQTT_RECEIVE_BUFFER_SIZE];
+
+static unsigned short get_u16(const unsigned char *buffer) {
+   return (buffer[0] << 8) | buffer[1];
+}
+
+static void put_u16(unsigned char *buffer, unsigned short value) {
+   buffer[0] = value >> 8;
+   buffer[1] = value & 0xFF;
+}
+
+/**
+ * Variable length encoding of the remaining length (7 bits per byte, up to 4 bytes). Returns the amount of bytes.
+ */
+static unsigned char put_remaining_length(unsigned char *buffer, unsigned int length) {
+   unsigned char bytes_amount = 0;
+
+   do {
+      unsigned char encoded_byte = length & 0x7F;
+
+      length >>= 7;
+      buffer[bytes_amount++] = length > 0 ? encoded_byte | 0x80 : encoded_byte;
+   } while (length > 0 && bytes_amount < 4);
+   return bytes_amount;
+}
+
+static unsigned short get_next_packet_id() {
+   mqtt_packet_id_g++;
+
+   // 0 isn't allowed
+   if (mqtt_packet_id_g == 0) {
+      mqtt_packet_id_g = 1;
+   }
+   return mqtt_packet_id_g;
+}
+
+static void close_connection() {
+   if (mqtt_socket_id_g < 0) {
+      return;
+   }
+
+   shutdown(mqtt_socket_id_g, 0);
+   close(mqtt_socket_id_g);
+   mqtt_socket_id_g = -1;
+   mqtt_ping_pending_g = false;
+}
+
+static bool send_fragments(const struct iovec fragments[], unsigned char fragments_amount) {
+   unsigned int packet_length = 0;
+
+   for (unsigned char i = 0; i < fragments_amount; i++) {
+      packet_length += fragments[i].iov_len;
+   }
+
+   if (writev(mqtt_socket_id_g, fragments, fragments_amount) != (int) packet_length) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nMQTT packet sending failed. Error no.: %d\n", errno);
+      #endif
+
+      close_connection();
+      return false;
+   }
+
+   mqtt_last_sent_time_g = xTaskGetTickCount();
+   return true;
+}
+
+static bool send_packet(const unsigned char *packet, unsigned short length) {
+   struct iovec fragment;
+
+   fragment.iov_base = (void *) packet;
+   fragment.iov_len = length;
+   return send_fragments(&fragment, 1);
+}
+
+static bool receive_exactly(unsigned char *buffer, unsigned int length) {
+   unsigned int received_bytes = 0;
+
+   while (received_bytes < length) {
+      int result = recv(mqtt_socket_id_g, buffer + received_bytes, length - received_bytes, 0);
+
+      if (result <= 0) {
+         // Timeout, error or the connection has been closed by the broker
+         close_connection();
+         return false;
+      }
+      received_bytes += result;
+   }
+   return true;
+}
+
+/**
+ * Receives one packet into mqtt_receive_buffer_g. The part which doesn't fit the buffer is read out and dropped.
+ *
+ * Returns the packet type and flags byte or -1 on error.
+ */
+static int receive_packet(unsigned int *remaining_length, unsigned short *stored_length) {
+   unsigned char fixed_header;
+
+   if (!receive_exactly(&fixed_header, 1)) {
+      return -1;
+   }
+
+   *remaining_length = 0;
+
+   for (unsigned char shift = 0; ; shift += 7) {
+      unsigned char encoded_byte;
+
+      if (shift > 21 || !receive_exactly(&encoded_byte, 1)) {
+         close_connection();
+         return -1;
+      }
+
+      *remaining_length |= (encoded_byte & 0x7F) << shift;
+
+      if ((encoded_byte & 0x80) == 0) {
+         break;
+      }
+   }
+
+   *stored_length = *remaining_length > MQTT_RECEIVE_BUFFER_SIZE ? MQTT_RECEIVE_BUFFER_SIZE : *remaining_length;
+
+   if (!receive_exactly(mqtt_receive_buffer_g, *stored_length)) {
+      return -1;
+   }
+
+   for (unsigned int dropped_bytes = *stored_length; dropped_bytes < *remaining_length; dropped_bytes++) {
+      unsigned char dropped_byte;
+
+      if (!receive_exactly(&dropped_byte, 1)) {
+         return -1;
+      }
+   }
+   return fixed_header;
+}
+
+static void handle_publish_packet(unsigned char fixed_header, unsigned int remaining_length,
+                                  unsigned short stored_length) {
+   unsigned char qos = (fixed_header >> MQTT_PUBLISH_QOS_SHIFT) & 0x03;
+
+   if (stored_length < 2) {
+      return;
+   }
+
+   unsigned short topic_length = get_u16(mqtt_receive_buffer_g);
+   unsigned short payload_position = 2 + topic_length + (qos > 0 ? 2 : 0);
+
+   if (payload_position > stored_length) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nMQTT message with too long topic has been dropped\n");
+      #endif
+
+      return;
+   }
+
+   if (remaining_length > stored_length) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nMQTT message has been dropped, %u bytes is too long\n", remaining_length);
+      #endif
+   } else if (mqtt_message_handler_g != NULL) {
+      mqtt_message_handler_g((const char *) (mqtt_receive_buffer_g + 2), topic_length,
+            mqtt_receive_buffer_g + payload_position, stored_length - payload_position);
+   }
+
+   if (qos == MQTT_QOS_AT_LEAST_ONCE) {
+      unsigned char puback_packet[] = {MQTT_PUBACK_PACKET, 2, 0, 0};
+
+      puback_packet[2] = mqtt_receive_buffer_g[2 + topic_length];
+      puback_packet[3] = mqtt_receive_buffer_g[3 + topic_length];
+      send_packet(puback_packet, sizeof(puback_packet));
+   }
+}
+
+/**
+ * Receives and handles one packet. Returns the packet type and flags byte or -1 on error.
+ */
+static int receive_and_handle_packet() {
+   unsigned int remaining_length;
+   unsigned short stored_length;
+   int fixed_header = receive_packet(&remaining_length, &stored_length);
+
+   if (fixed_header < 0) {
+      return -1;
+   }
+
+   switch (fixed_header & 0xF0) {
+      case MQTT_PUBLISH_PACKET:
+         handle_publish_packet(fixed_header, remaining_length, stored_length);
+         break;
+      case MQTT_PINGRESP_PACKET:
+         mqtt_ping_pending_g = false;
+         break;
+      default:
+         break;
+   }
+   return fixed_header;
+}
+
+/**
+ * Waits for the response packet of the specified type. Received PUBLISH packets are handled meanwhile.
+ * packet_id is compared if it isn't 0. Returns false on timeout or error.
+ */
+static bool wait_for_packet(unsigned char packet_type, unsigned short packet_id) {
+   TickType_t start_time = xTaskGetTickCount();
+
+   while (xTaskGetTickCount() - start_time < MQTT_RESPONSE_TIMEOUT_MS / portTICK_RATE_MS) {
+      int fixed_header = receive_and_handle_packet();
+
+      if (fixed_header < 0) {
+         return false;
+      }
+
+      if ((fixed_header & 0xF0) == packet_type &&
+            (packet_id == 0 || get_u16(mqtt_receive_buffer_g) == packet_id)) {
+         return true;
+      }
+   }
+
+   close_connection();
+   return false;
+}
+
+bool mqtt_connect(const char *client_id, mqtt_message_handler_t message_handler) {
+   if (mqtt_mutex_g == NULL) {
+      mqtt_mutex_g = xSemaphoreCreateMutex();
+   }
+
+   xSemaphoreTake(mqtt_mutex_g, portMAX_DELAY);
+
+   close_connection();
+   mqtt_message_handler_g = message_handler;
+   mqtt_socket_id_g = connect_to_server(MQTT_BROKER_IP_ADDRESS, MQTT_BROKER_PORT);
+
+   if (mqtt_socket_id_g < 0) {
+      xSemaphoreGive(mqtt_mutex_g);
+      return false;
+   }
+
+   struct timeval receive_timeout;
+   receive_timeout.tv_sec = MQTT_RESPONSE_TIMEOUT_MS / 1000;
+   receive_timeout.tv_usec = (MQTT_RESPONSE_TIMEOUT_MS % 1000) * 1000;
+   setsockopt(mqtt_socket_id_g, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+
+   unsigned short client_id_length = strlen(client_id);
+   // Protocol name, level 4 (3.1.1), connect flags without clean session, keep alive
+   unsigned char header[17] = {MQTT_CONNECT_PACKET};
+   unsigned char header_length = 1;
+   const unsigned char variable_header[] = {0, 4, 'M', 'Q', 'T', 'T', 4, 0, MQTT_KEEP_ALIVE_S >> 8, MQTT_KEEP_ALIVE_S & 0xFF};
+
+   header_length += put_remaining_length(header + header_length, sizeof(variable_header) + 2 + client_id_length);
+   memcpy(header + header_length, variable_header, sizeof(variable_header));
+   header_length += sizeof(variable_header);
+   put_u16(header + header_length, client_id_length);
+   header_length += 2;
+
+   struct iovec fragments[2];
+   fragments[0].iov_base = header;
+   fragments[0].iov_len = header_length;
+   fragments[1].iov_base = (void *) client_id;
+   fragments[1].iov_len = client_id_length;
+
+   bool connected = send_fragments(fragments, 2) && wait_for_packet(MQTT_CONNACK_PACKET, 0) &&
+         mqtt_receive_buffer_g[1] == 0;
+
+   if (connected) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nConnected to MQTT broker, session present: %u\n", mqtt_receive_buffer_g[0] & 1);
+      #endif
+   } else {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nMQTT connection to the broker failed\n");
+      #endif
+
+      close_connection();
+   }
+
+   xSemaphoreGive(mqtt_mutex_g);
+   return connected;
+}
+
+bool mqtt_is_connected() {
+   return mqtt_socket_id_g >= 0;
+}
+
+bool mqtt_subscribe(const char *topic, unsigned char qos) {
+   if (!mqtt_is_connected()) {
+      return false;
+   }
+
+   xSemaphoreTake(mqtt_mutex_g, portMAX_DELAY);
+
+   unsigned short topic_length = strlen(topic);
+   unsigned short packet_id = get_next_packet_id();
+   unsigned char header[9] = {MQTT_SUBSCRIBE_PACKET};
+   unsigned char header_length = 1;
+
+   header_length += put_remaining_length(header + header_length, 2 + 2 + topic_length + 1);
+   put_u16(header + header_length, packet_id);
+   header_length += 2;
+   put_u16(header + header_length, topic_length);
+   header_length += 2;
+
+   struct iovec fragments[3];
+   fragments[0].iov_base = header;
+   fragments[0].iov_len = header_length;
+   fragments[1].iov_base = (void *) topic;
+   fragments[1].iov_len = topic_length;
+   fragments[2].iov_base = &qos;
+   fragments[2].iov_len = 1;
+
+   // 0x80 return code - failure
+   bool subscribed = send_fragments(fragments, 3) && wait_for_packet(MQTT_SUBACK_PACKET, packet_id) &&
+         mqtt_receive_buffer_g[2] != 0x80;
+
+   xSemaphoreGive(mqtt_mutex_g);
+   return subscribed;
+}
+
+/**
+ * QoS 1 publishing waits for PUBACK. If it isn't received in MQTT_RESPONSE_TIMEOUT_MS, the connection is closed and
+ * false is returned, so the caller may publish the message again after reconnection.
+ */
+bool mqtt_publish(const char *topic, const unsigned char *payload, unsigned short payload_length, unsigned char qos) {
+   if (!mqtt_is_connected()) {
+      return false;
+   }
+
+   xSemaphoreTake(mqtt_mutex_g, portMAX_DELAY);
+
+   unsigned short topic_length = strlen(topic);
+   unsigned char header[7] = {MQTT_PUBLISH_PACKET | (qos << MQTT_PUBLISH_QOS_SHIFT)};
+   unsigned char header_length = 1;
+   unsigned char packet_id[2];
+   unsigned short packet_id_value = 0;
+   unsigned char packet_id_length = 0;
+
+   if (qos > MQTT_QOS_AT_MOST_ONCE) {
+      packet_id_value = get_next_packet_id();
+      put_u16(packet_id, packet_id_value);
+      packet_id_length = 2;
+   }
+
+   header_length += put_remaining_length(header + header_length, 2 + topic_length + packet_id_length + payload_length);
+   put_u16(header + header_length, topic_length);
+   header_length += 2;
+
+   struct iovec fragments[4];
+   fragments[0].iov_base = header;
+   fragments[0].iov_len = header_length;
+   fragments[1].iov_base = (void *) topic;
+   fragments[1].iov_len = topic_length;
+   fragments[2].iov_base = packet_id;
+   fragments[2].iov_len = packet_id_length;
+   fragments[3].iov_base = (void *) payload;
+   fragments[3].iov_len = payload_length;
+
+   bool published = send_fragments(fragments, 4) &&
+         (qos == MQTT_QOS_AT_MOST_ONCE || wait_for_packet(MQTT_PUBACK_PACKET, packet_id_value));
+
+   xSemaphoreGive(mqtt_mutex_g);
+   return published;
+}
+
+/**
+ * Waits up to timeout_ms for incoming packets and handles them, sends PINGREQ to keep the connection alive.
+ * Has to be called periodically (more often than MQTT_KEEP_ALIVE_S / 2). Returns false if the connection is lost.
+ */
+bool mqtt_process(unsigned int timeout_ms) {
+   int socket_id = mqtt_socket_id_g;
+
+   if (socket_id < 0) {
+      return false;
+   }
+
+   // Waiting without the mutex, so other tasks may publish meanwhile
+   fd_set read_sockets;
+   FD_ZERO(&read_sockets);
+   FD_SET(socket_id, &read_sockets);
+   struct timeval select_timeout;
+   select_timeout.tv_sec = timeout_ms / 1000;
+   select_timeout.tv_usec = (timeout_ms % 1000) * 1000;
+   select(socket_id + 1, &read_sockets, NULL, NULL, &select_timeout);
+
+   xSemaphoreTake(mqtt_mutex_g, portMAX_DELAY);
+
+   if (mqtt_socket_id_g >= 0) {
+      unsigned char peeked_byte;
+      int peek_result = recv(mqtt_socket_id_g, &peeked_byte, 1, MSG_PEEK | MSG_DONTWAIT);
+
+      // The data could already be read out by the publishing task
+      if (peek_result > 0) {
+         receive_and_handle_packet();
+      } else if (peek_result == 0 || (errno != EWOULDBLOCK && errno != EAGAIN)) {
+         close_connection();
+      }
+   }
+
+   TickType_t current_time = xTaskGetTickCount();
+
+   if (mqtt_socket_id_g >= 0 && mqtt_ping_pending_g &&
+         current_time - mqtt_ping_sent_time_g > MQTT_RESPONSE_TIMEOUT_MS / portTICK_RATE_MS) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nMQTT broker doesn't respond to PINGREQ\n");
+      #endif
+
+      close_connection();
+   } else if (mqtt_socket_id_g >= 0 && !mqtt_ping_pending_g &&
+         current_time - mqtt_last_sent_time_g > MQTT_KEEP_ALIVE_S * 1000 / 2 / portTICK_RATE_MS) {
+      const unsigned char pingreq_packet[] = {MQTT_PINGREQ_PACKET, 0};
+
+      if (send_packet(pingreq_packet, sizeof(pingreq_packet))) {
+         mqtt_ping_pending_g = true;
+         mqtt_ping_sent_time_g = current_time;
+      }
+   }
+
+   bool connected = mqtt_socket_id_g >= 0;
+
+   xSemaphoreGive(mqtt_mutex_g);
+   return connected;
+}
+
+void mqtt_disconnect() {
+   if (mqtt_mutex_g == NULL) {
+      return;
+   }
+
+   xSemaphoreTake(mqtt_mutex_g, portMAX_DELAY);
+
+   if (mqtt_socket_id_g >= 0) {
+      const unsigned char disconnect_packet[] = {MQTT_DISCONNECT_PACKET, 0};
+
+      send_packet(disconnect_packet, sizeof(disconnect_packet));
+      close_connection();
+   }
+
+   xSemaphoreGive(mqtt_mutex_g);
+}
@@ -0,0 +1,107 @@
+#include "number_formatter.h"
+
+/**
+ * Lightweight replacement of snprintf() for numbers. All the functions write \0 terminated string and return
+ * its length, or 0 (with empty string if buffer_size > 0) if the buffer is too small.
+ */
+
+static unsigned char write_digits(char *buffer, unsigned char buffer_size, unsigned int value,
+                                  unsigned char min_digits) {
+   char digits[10];
+   unsigned char digits_amount = 0;
+
+   do {
+      digits[digits_amount++] = '0' + value % 10;
+      value /= 10;
+   } while (value > 0 || digits_amount < min_digits);
+
+   if (digits_amount >= buffer_size) {
+      if (buffer_size > 0) {
+         buffer[0] = '\0';
+      }
+      return 0;
+   }
+
+   for (unsigned char i = 0; i < digits_amount; i++) {
+      buffer[i] = digits[digits_amount - 1 - i];
+   }
+   buffer[digits_amount] = '\0';
+   return digits_amount;
+}
+
+unsigned char format_unsigned(char *buffer, unsigned char buffer_size, unsigned int value) {
+   return write_digits(buffer, buffer_size, value, 1);
+}
+
+unsigned char format_signed(char *buffer, unsigned char buffer_size, int value) {
+   if (value >= 0) {
+      return write_digits(buffer, buffer_size, value, 1);
+   }
+
+   if (buffer_size < 2) {
+      if (buffer_size > 0) {
+         buffer[0] = '\0';
+      }
+      return 0;
+   }
+
+   buffer[0] = '-';
+   // Negation in unsigned arithmetic is valid for INT_MIN as well
+   unsigned char length = write_digits(buffer + 1, buffer_size - 1, 0U - (unsigned int) value, 1);
+
+   if (length == 0) {
+      buffer[0] = '\0';
+      return 0;
+   }
+   return length + 1;
+}
+
+/**
+ * Formats the value scaled by 10^fraction_digits as decimal fraction, e.g. 2105 with 2 fraction digits is "21.05",
+ * -5 is "-0.05".
+ */
+unsigned char format_fixed_point(char *buffer, unsigned char buffer_size, int value, unsigned char fraction_digits) {
+   unsigned int divider = 1;
+   unsigned char length = 0;
+
+   for (unsigned char i = 0; i < fraction_digits; i++) {
+      divider *= 10;
+   }
+
+   if (buffer_size == 0) {
+      return 0;
+   }
+
+   unsigned int absolute_value = value < 0 ? 0U - (unsigned int) value : (unsigned int) value;
+
+   if (value < 0) {
+      buffer[length++] = '-';
+   }
+
+   unsigned char integer_length = write_digits(buffer + length, buffer_size - length, absolute_value / divider, 1);
+
+   if (integer_length == 0) {
+      buffer[0] = '\0';
+      return 0;
+   }
+   length += integer_length;
+
+   if (fraction_digits == 0) {
+      return length;
+   }
+
+   if (length + 1 >= buffer_size) {
+      buffer[0] = '\0';
+      return 0;
+   }
+   buffer[length++] = '.';
+
+   unsigned char fraction_length = write_digits(buffer + length, buffer_size - length, absolute_value % divider,
+         fraction_digits);
+
+   if (fraction_length == 0) {
+      buffer[0] = '\0';
+      return 0;
+   }
+   return length + fraction_length;
+}
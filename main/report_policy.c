@@ -0,0 +1,56 @@
+#include "report_policy.h"
+
+static bool exceeds_deadband(int last_value, int value, unsigned short deadband) {
+   int difference = value - last_value;
+
+   return difference > deadband || -difference > deadband;
+}
+
+void report_policy_init(report_policy_t *policy, const report_policy_config_t *config) {
+   memset(policy, 0, sizeof(report_policy_t));
+   policy->config = *config;
+}
+
+/**
+ * Returns REPORT_REASON_NONE if the report should be suppressed. Reasons are checked in priority order, so errors
+ * and reset reasons are always sent immediately regardless of the measured values.
+ */
+report_reason_t report_policy_evaluate(report_policy_t *policy, const status_record_t *record,
+                                       const report_policy_values_t *values, unsigned int current_time_ms) {
+   report_reason_t reason = REPORT_REASON_NONE;
+
+   if (!policy->report_sent || record->first_report) {
+      reason = REPORT_REASON_FIRST_REPORT;
+      policy->statistics.first_reports++;
+   } else if (record->errors_counter != policy->last_errors_counter ||
+         record->pending_connection_errors_counter != policy->last_pending_connection_errors_counter) {
+      reason = REPORT_REASON_ERRORS;
+      policy->statistics.errors_reports++;
+   } else if (exceeds_deadband(policy->last_temperature, values->temperature, policy->config.temperature_deadband) ||
+         exceeds_deadband(policy->last_humidity, values->humidity, policy->config.humidity_deadband) ||
+         (values->light_present &&
+               exceeds_deadband(policy->last_light, values->light, policy->config.light_deadband))) {
+      reason = REPORT_REASON_CHANGE;
+      policy->statistics.change_reports++;
+   } else if (current_time_ms - policy->last_report_time_ms >= policy->config.heartbeat_interval_ms) {
+      reason = REPORT_REASON_HEARTBEAT;
+      policy->statistics.heartbeat_reports++;
+   } else {
+      policy->statistics.suppressed_reports++;
+   }
+   return reason;
+}
+
+/**
+ * Has to be called after the report has been sent. Not sent reports are evaluated again next time.
+ */
+void report_policy_on_sent(report_policy_t *policy, const status_record_t *record,
+                           const report_policy_values_t *values, unsigned int current_time_ms) {
+   policy->report_sent = true;
+   policy->last_report_time_ms = current_time_ms;
+   policy->last_temperature = values->temperature;
+   policy->last_humidity = values->humidity;
+   policy->last_light = values->light;
+   policy->last_errors_counter = record->errors_counter;
+   policy->last_pending_connection_errors_counter = record->pending_connection_errors_counter;
+}
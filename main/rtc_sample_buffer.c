@@ -0,0 +1,152 @@
+#include "rtc_sample_buffer.h"
+
+static unsigned int get_slot_address(const rtc_sample_buffer_t *buffer, unsigned char slot) {
+   return buffer->rtc_address + RTC_SAMPLE_BUFFER_HEADER_BLOCKS + slot * RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS;
+}
+
+static unsigned char calculate_header_crc(const unsigned char header[RTC_SAMPLE_BUFFER_HEADER_BLOCKS * 4]) {
+   unsigned char crc_data[RTC_SAMPLE_BUFFER_HEADER_BLOCKS * 4 - 1];
+
+   memcpy(crc_data, header, 3);
+   memcpy(crc_data + 3, header + 4, sizeof(crc_data) - 3);
+   return sht21_calculate_crc8(crc_data, sizeof(crc_data));
+}
+
+static void write_header(const rtc_sample_buffer_t *buffer) {
+   unsigned char header[RTC_SAMPLE_BUFFER_HEADER_BLOCKS * 4];
+
+   header[0] = RTC_SAMPLE_BUFFER_MAGIC;
+   header[1] = buffer->head;
+   header[2] = buffer->samples_amount;
+   memcpy(header + 4, &buffer->oldest_sequence, 4);
+   memcpy(header + 8, &buffer->last_time, 4);
+   header[3] = calculate_header_crc(header);
+
+   rtc_mem_write(buffer->rtc_address, header, sizeof(header));
+}
+
+static unsigned char calculate_sample_crc(const unsigned char sample[RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS * 4]) {
+   unsigned char crc_data[RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS * 4 - 1];
+
+   memcpy(crc_data, sample, 3);
+   memcpy(crc_data + 3, sample + 4, sizeof(crc_data) - 3);
+   return sht21_calculate_crc8(crc_data, sizeof(crc_data));
+}
+
+/**
+ * Restores the buffer from the RTC memory. Returns false if there was no valid buffer (e.g. after power on),
+ * then the buffer is cleared.
+ */
+bool rtc_sample_buffer_init(rtc_sample_buffer_t *buffer, unsigned int rtc_address, unsigned char capacity) {
+   unsigned char header[RTC_SAMPLE_BUFFER_HEADER_BLOCKS * 4];
+
+   assert(rtc_address + RTC_SAMPLE_BUFFER_HEADER_BLOCKS + capacity * RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS <=
+         RTC_SAMPLE_BUFFER_LAST_BLOCK + 1);
+
+   buffer->rtc_address = rtc_address;
+   buffer->capacity = capacity;
+
+   rtc_mem_read(rtc_address, header, sizeof(header));
+
+   if (header[0] == RTC_SAMPLE_BUFFER_MAGIC && header[3] == calculate_header_crc(header) &&
+         header[1] < capacity && header[2] <= capacity) {
+      buffer->head = header[1];
+      buffer->samples_amount = header[2];
+      memcpy(&buffer->oldest_sequence, header + 4, 4);
+      memcpy(&buffer->last_time, header + 8, 4);
+      return true;
+   }
+
+   buffer->head = 0;
+   buffer->samples_amount = 0;
+   buffer->oldest_sequence = 0;
+   buffer->last_time = 0;
+   write_header(buffer);
+   return false;
+}
+
+/**
+ * Appends the sample. The oldest one is overwritten if the buffer is full.
+ */
+void rtc_sample_buffer_push(rtc_sample_buffer_t *buffer, const sample_record_t *sample) {
+   unsigned char stored_sample[RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS * 4];
+
+   stored_sample[0] = sample->time & 0xFF;
+   stored_sample[1] = (sample->time >> 8) & 0xFF;
+   stored_sample[2] = (sample->time >> 16) & 0xFF;
+   memcpy(stored_sample + 4, &sample->temperature, 2);
+   memcpy(stored_sample + 6, &sample->humidity, 2);
+   stored_sample[3] = calculate_sample_crc(stored_sample);
+
+   unsigned char slot = (buffer->head + buffer->samples_amount) % buffer->capacity;
+
+   rtc_mem_write(get_slot_address(buffer, slot), stored_sample, sizeof(stored_sample));
+
+   if (buffer->samples_amount < buffer->capacity) {
+      buffer->samples_amount++;
+   } else {
+      buffer->head = (buffer->head + 1) % buffer->capacity;
+      buffer->oldest_sequence++;
+   }
+
+   buffer->last_time = sample->time;
+   write_header(buffer);
+}
+
+/**
+ * Reads up to max_samples_amount the oldest samples without removing them. Time is restored relatively to the last
+ * write time, because only 24 bits of it are stored.
+ *
+ * *end_sequence is set to the sequence number after the last read sample, it has to be passed to
+ * rtc_sample_buffer_remove() when the samples have been uploaded. Returns the amount of valid samples.
+ */
+unsigned char rtc_sample_buffer_read(const rtc_sample_buffer_t *buffer, sample_record_t samples[],
+                                     unsigned char max_samples_amount, unsigned int *end_sequence) {
+   unsigned char valid_samples_amount = 0;
+   unsigned char slots_amount = buffer->samples_amount < max_samples_amount ?
+         buffer->samples_amount : max_samples_amount;
+
+   for (unsigned char i = 0; i < slots_amount; i++) {
+      unsigned char stored_sample[RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS * 4];
+
+      rtc_mem_read(get_slot_address(buffer, (buffer->head + i) % buffer->capacity), stored_sample,
+            sizeof(stored_sample));
+
+      if (stored_sample[3] != calculate_sample_crc(stored_sample)) {
+         continue;
+      }
+
+      sample_record_t *sample = &samples[valid_samples_amount++];
+      unsigned int time_low_bits = stored_sample[0] | (stored_sample[1] << 8) | (stored_sample[2] << 16);
+
+      sample->time = (buffer->last_time & 0xFF000000) | time_low_bits;
+      if (sample->time > buffer->last_time) {
+         sample->time -= 0x01000000;
+      }
+      memcpy(&sample->temperature, stored_sample + 4, 2);
+      memcpy(&sample->humidity, stored_sample + 6, 2);
+   }
+
+   *end_sequence = buffer->oldest_sequence + slots_amount;
+   return valid_samples_amount;
+}
+
+/**
+ * Removes the samples before end_sequence. Samples overwritten after reading are taken into account.
+ */
+void rtc_sample_buffer_remove(rtc_sample_buffer_t *buffer, unsigned int end_sequence) {
+   if ((int) (end_sequence - buffer->oldest_sequence) <= 0) {
+      return;
+   }
+
+   unsigned int amount = end_sequence - buffer->oldest_sequence;
+
+   if (amount > buffer->samples_amount) {
+      amount = buffer->samples_amount;
+   }
+
+   buffer->head = (buffer->head + amount) % buffer->capacity;
+   buffer->samples_amount -= amount;
+   buffer->oldest_sequence = end_sequence;
+   write_header(buffer);
+}
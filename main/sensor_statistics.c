@@ -0,0 +1,179 @@
+#include "sensor_statistics.h"
+
+static int get_median(const median_filter_t *filter) {
+   int sorted_values[MEDIAN_FILTER_SIZE];
+
+   memcpy(sorted_values, filter->values, filter->values_amount * sizeof(int));
+
+   // Insertion sort, there are only a few values
+   for (unsigned char i = 1; i < filter->values_amount; i++) {
+      int value = sorted_values[i];
+      signed char j = i - 1;
+
+      for (; j >= 0 && sorted_values[j] > value; j--) {
+         sorted_values[j + 1] = sorted_values[j];
+      }
+      sorted_values[j + 1] = value;
+   }
+
+   // Lower median for the even amount
+   return sorted_values[(filter->values_amount - 1) / 2];
+}
+
+void median_filter_init(median_filter_t *filter, int min_value, int max_value, int spike_threshold) {
+   memset(filter, 0, sizeof(median_filter_t));
+   filter->min_value = min_value;
+   filter->max_value = max_value;
+   filter->spike_threshold = spike_threshold;
+}
+
+/**
+ * Returns false if the value is rejected. Otherwise *filtered_value is set to the median of the last accepted values.
+ */
+bool median_filter_add(median_filter_t *filter, int value, int *filtered_value) {
+   if (value < filter->min_value || value > filter->max_value) {
+      return false;
+   }
+
+   if (filter->values_amount > 0) {
+      int difference = value - get_median(filter);
+
+      if (difference > filter->spike_threshold || -difference > filter->spike_threshold) {
+         filter->consecutive_spikes++;
+
+         if (filter->consecutive_spikes < MEDIAN_FILTER_SIZE) {
+            return false;
+         }
+
+         // The value has really changed
+         filter->values_amount = 0;
+         filter->position = 0;
+      }
+   }
+
+   filter->consecutive_spikes = 0;
+   filter->values[filter->position] = value;
+   filter->position = (filter->position + 1) % MEDIAN_FILTER_SIZE;
+
+   if (filter->values_amount < MEDIAN_FILTER_SIZE) {
+      filter->values_amount++;
+   }
+
+   *filtered_value = get_median(filter);
+   return true;
+}
+
+/**
+ * The last filtered value, i.e. the median of the last accepted values. Returns false if no value has been accepted.
+ */
+bool median_filter_get_value(const median_filter_t *filter, int *filtered_value) {
+   if (filter->values_amount == 0) {
+      return false;
+   }
+
+   *filtered_value = get_median(filter);
+   return true;
+}
+
+void running_statistics_reset(running_statistics_t *statistics) {
+   memset(statistics, 0, sizeof(running_statistics_t));
+}
+
+static int divide_rounded(int dividend, int divisor) {
+   return dividend < 0 ? -((-dividend + divisor / 2) / divisor) : (dividend + divisor / 2) / divisor;
+}
+
+void running_statistics_add(running_statistics_t *statistics, int value) {
+   if (statistics->count == 0 || value < statistics->min) {
+      statistics->min = value;
+   }
+   if (statistics->count == 0 || value > statistics->max) {
+      statistics->max = value;
+   }
+
+   if (statistics->count < SENSOR_STATISTICS_MAX_COUNT) {
+      statistics->count++;
+   } else {
+      // Decayed, so m2 stays about count times the variance as the new squared differences are added
+      statistics->m2 -= statistics->m2 / statistics->count;
+   }
+
+   int scaled_value = value * (1 << RUNNING_STATISTICS_MEAN_SHIFT);
+   int delta = scaled_value - statistics->mean;
+
+   statistics->mean += divide_rounded(delta, statistics->count);
+   statistics->m2 += (long long) delta * (scaled_value - statistics->mean);
+}
+
+int running_statistics_get_mean(const running_statistics_t *statistics) {
+   return divide_rounded(statistics->mean, 1 << RUNNING_STATISTICS_MEAN_SHIFT);
+}
+
+/**
+ * Sample standard deviation rounded to integer. Integer square root, so libm isn't required.
+ */
+unsigned int running_statistics_get_standard_deviation(const running_statistics_t *statistics) {
+   if (statistics->count < 2) {
+      return 0;
+   }
+
+   long long divisor = (long long) (statistics->count - 1) << (2 * RUNNING_STATISTICS_MEAN_SHIFT);
+   unsigned int variance = statistics->m2 <= 0 ? 0 : (unsigned int) ((statistics->m2 + divisor / 2) / divisor);
+   unsigned int root = 0;
+   unsigned int bit = 1 << 30;
+
+   while (bit > variance) {
+      bit >>= 2;
+   }
+
+   while (bit != 0) {
+      if (variance >= root + bit) {
+         variance -= root + bit;
+         root = (root >> 1) + bit;
+      } else {
+         root >>= 1;
+      }
+      bit >>= 2;
+   }
+
+   // Rounding to the nearest
+   return variance > root ? root + 1 : root;
+}
+
+void sensor_statistics_init(sensor_statistics_t *sensor_statistics, int min_value, int max_value,
+                            int spike_threshold) {
+   median_filter_init(&sensor_statistics->filter, min_value, max_value, spike_threshold);
+   sensor_statistics_reset(sensor_statistics);
+}
+
+/**
+ * Filters the value and adds the filtered one to the statistics. Returns false if the value has been rejected.
+ */
+bool sensor_statistics_add(sensor_statistics_t *sensor_statistics, int value) {
+   int filtered_value;
+
+   if (!median_filter_add(&sensor_statistics->filter, value, &filtered_value)) {
+      return sensor_statistics_reject(sensor_statistics);
+   }
+
+   running_statistics_add(&sensor_statistics->statistics, filtered_value);
+   return true;
+}
+
+/**
+ * Counts the value, which couldn't be read, as rejected. Returns false, so it can be used as sensor_statistics_add().
+ */
+bool sensor_statistics_reject(sensor_statistics_t *sensor_statistics) {
+   if (sensor_statistics->rejected_amount < SENSOR_STATISTICS_MAX_COUNT) {
+      sensor_statistics->rejected_amount++;
+   }
+   return false;
+}
+
+/**
+ * Starts the new interval. The median filter keeps its values, so spikes are still detected right after the reset.
+ */
+void sensor_statistics_reset(sensor_statistics_t *sensor_statistics) {
+   running_statistics_reset(&sensor_statistics->statistics);
+   sensor_statistics->rejected_amount = 0;
+}
@@ -0,0 +1,334 @@
+#include "status_record.h"
+
+/**
+ * Compact binary form of the status report, an alternative to STATUS_INFO_REQUEST_PAYLOAD_TEMPLATE JSON.
+ * The fixed part is STATUS_RECORD_FIXED_PART_SIZE (46) bytes, so the periodic report is 47 bytes plus the device name.
+ * All numbers are little endian:
+ *
+ *  0  u8   version (STATUS_RECORD_VERSION)
+ *  1  u8   flags (STATUS_RECORD_*_FLAG)
+ *  2  i8   signal strength
+ *  3  u16  errors counter
+ *  5  u8   pending connection errors counter
+ *  6  u32  uptime, seconds
+ * 10  u32  free heap space
+ * 14  i16  temperature, hundredths of a degree
+ * 16  u16  temperature raw
+ * 18  i16  humidity, hundredths of a percent
+ * 20  u16  light
+ * 22  u32  suppressed reports
+ * 26  i16  temperature min
+ * 28  i16  temperature max
+ * 30  u16  temperature standard deviation
+ * 32  i16  humidity min
+ * 34  i16  humidity max
+ * 36  u16  humidity standard deviation
+ * 38  u16  samples amount
+ * 40  u16  rejected samples amount
+ * 42  u32  awake time of the previous report cycle, milliseconds
+ * 46  u8 length + bytes: device name
+ *     and only with STATUS_RECORD_FIRST_REPORT_FLAG:
+ *     u8 length + bytes: build timestamp, reset reason, system restart reason, boot timeline
+ *
+ * UDP datagram: u8 STATUS_DATAGRAM_TYPE, u32 sequence number, status record.
+ * Sample batch datagram: u8 SAMPLE_BATCH_DATAGRAM_TYPE, u32 sequence number, sample batch.
+ * Optional reply: u8 STATUS_DATAGRAM_REPLY_TYPE, u32 sequence number of the datagram, u8 commands
+ * (STATUS_DATAGRAM_*_COMMAND). The sequence number lets the collector detect lost datagrams and
+ * the device to ignore stale replies.
+ *
+ * Sample batch (samples buffered on the device, uploaded at once):
+ *  0  u8   version (SAMPLE_BATCH_VERSION)
+ *  1  u32  current device time, seconds
+ *  5  u8   samples amount
+ *  6  samples amount * (u32 time, i16 temperature, i16 humidity), the oldest first
+ *     u8 length + bytes: device name
+ */
+
+static unsigned char get_string_length(const char *string) {
+   if (string == NULL) {
+      return 0;
+   }
+
+   size_t length = strlen(string);
+   return length > STATUS_RECORD_MAX_STRING_SIZE ? STATUS_RECORD_MAX_STRING_SIZE : length;
+}
+
+static unsigned char *put_u16(unsigned char *buffer, unsigned short value) {
+   buffer[0] = value & 0xFF;
+   buffer[1] = value >> 8;
+   return buffer + 2;
+}
+
+static unsigned char *put_u32(unsigned char *buffer, unsigned int value) {
+   buffer = put_u16(buffer, value & 0xFFFF);
+   return put_u16(buffer, value >> 16);
+}
+
+static unsigned char *put_string(unsigned char *buffer, const char *string) {
+   unsigned char length = get_string_length(string);
+
+   *buffer++ = length;
+   if (length > 0) {
+      memcpy(buffer, string, length);
+   }
+   return buffer + length;
+}
+
+static unsigned short get_u16(const unsigned char *buffer) {
+   return buffer[0] | (buffer[1] << 8);
+}
+
+static unsigned int get_u32(const unsigned char *buffer) {
+   return get_u16(buffer) | ((unsigned int) get_u16(buffer + 2) << 16);
+}
+
+unsigned short get_status_record_encoded_length(const status_record_t *record) {
+   unsigned short length = STATUS_RECORD_FIXED_PART_SIZE + 1 + get_string_length(record->device_name);
+
+   if (record->first_report) {
+      length += 4 + get_string_length(record->build_timestamp) + get_string_length(record->reset_reason) +
+            get_string_length(record->system_restart_reason) + get_string_length(record->boot_timeline);
+   }
+   return length;
+}
+
+/**
+ * Returns the encoded length or 0 if buffer_size is not enough (see get_status_record_encoded_length()).
+ */
+unsigned short encode_status_record(const status_record_t *record, unsigned char *buffer, unsigned short buffer_size) {
+   unsigned short length = get_status_record_encoded_length(record);
+
+   if (length > buffer_size) {
+      return 0;
+   }
+
+   unsigned char *position = buffer;
+
+   *position++ = STATUS_RECORD_VERSION;
+   *position++ = (record->light_present ? STATUS_RECORD_LIGHT_PRESENT_FLAG : 0) |
+         (record->first_report ? STATUS_RECORD_FIRST_REPORT_FLAG : 0);
+   *position++ = (unsigned char) record->signal_strength;
+   position = put_u16(position, record->errors_counter);
+   *position++ = record->pending_connection_errors_counter;
+   position = put_u32(position, record->uptime);
+   position = put_u32(position, record->free_heap_space);
+   position = put_u16(position, (unsigned short) record->temperature);
+   position = put_u16(position, record->temperature_raw);
+   position = put_u16(position, (unsigned short) record->humidity);
+   position = put_u16(position, record->light_present ? record->light : 0);
+   position = put_u32(position, record->suppressed_reports);
+   position = put_u16(position, (unsigned short) record->temperature_min);
+   position = put_u16(position, (unsigned short) record->temperature_max);
+   position = put_u16(position, record->temperature_deviation);
+   position = put_u16(position, (unsigned short) record->humidity_min);
+   position = put_u16(position, (unsigned short) record->humidity_max);
+   position = put_u16(position, record->humidity_deviation);
+   position = put_u16(position, record->samples_amount);
+   position = put_u16(position, record->rejected_samples_amount);
+   position = put_u32(position, record->awake_time);
+   position = put_string(position, record->device_name);
+
+   if (record->first_report) {
+      position = put_string(position, record->build_timestamp);
+      position = put_string(position, record->reset_reason);
+      position = put_string(position, record->system_restart_reason);
+      position = put_string(position, record->boot_timeline);
+   }
+   return position - buffer;
+}
+
+static const unsigned char *get_string(const unsigned char *position, const unsigned char *end, const char **string,
+                                       char **strings_position, const char *strings_end) {
+   if (position >= end) {
+      return NULL;
+   }
+
+   unsigned char length = *position++;
+
+   if (position + length > end || *strings_position + length + 1 > strings_end) {
+      return NULL;
+   }
+
+   memcpy(*strings_position, position, length);
+   (*strings_position)[length] = '\0';
+   *string = *strings_position;
+   *strings_position += length + 1;
+   return position + length;
+}
+
+/**
+ * Reference decoder for the collector side. Decoded strings are copied into strings_buffer, which has to be
+ * at least "length" bytes long.
+ */
+bool decode_status_record(const unsigned char *buffer, unsigned short length, status_record_t *record,
+                          char *strings_buffer, unsigned short strings_buffer_size) {
+   const unsigned char *end = buffer + length;
+   const char *strings_end = strings_buffer + strings_buffer_size;
+
+   if (length < STATUS_RECORD_FIXED_PART_SIZE || buffer[0] != STATUS_RECORD_VERSION) {
+      return false;
+   }
+
+   memset(record, 0, sizeof(status_record_t));
+
+   unsigned char flags = buffer[1];
+
+   record->light_present = (flags & STATUS_RECORD_LIGHT_PRESENT_FLAG) != 0;
+   record->first_report = (flags & STATUS_RECORD_FIRST_REPORT_FLAG) != 0;
+   record->signal_strength = (signed char) buffer[2];
+   record->errors_counter = get_u16(buffer + 3);
+   record->pending_connection_errors_counter = buffer[5];
+   record->uptime = get_u32(buffer + 6);
+   record->free_heap_space = get_u32(buffer + 10);
+   record->temperature = (short) get_u16(buffer + 14);
+   record->temperature_raw = get_u16(buffer + 16);
+   record->humidity = (short) get_u16(buffer + 18);
+   record->light = get_u16(buffer + 20);
+   record->suppressed_reports = get_u32(buffer + 22);
+   record->temperature_min = (short) get_u16(buffer + 26);
+   record->temperature_max = (short) get_u16(buffer + 28);
+   record->temperature_deviation = get_u16(buffer + 30);
+   record->humidity_min = (short) get_u16(buffer + 32);
+   record->humidity_max = (short) get_u16(buffer + 34);
+   record->humidity_deviation = get_u16(buffer + 36);
+   record->samples_amount = get_u16(buffer + 38);
+   record->rejected_samples_amount = get_u16(buffer + 40);
+   record->awake_time = get_u32(buffer + 42);
+
+   const unsigned char *position = buffer + STATUS_RECORD_FIXED_PART_SIZE;
+   char *strings_position = strings_buffer;
+
+   position = get_string(position, end, &record->device_name, &strings_position, strings_end);
+
+   if (position != NULL && record->first_report) {
+      position = get_string(position, end, &record->build_timestamp, &strings_position, strings_end);
+      if (position != NULL) {
+         position = get_string(position, end, &record->reset_reason, &strings_position, strings_end);
+      }
+      if (position != NULL) {
+         position = get_string(position, end, &record->system_restart_reason, &strings_position, strings_end);
+      }
+      if (position != NULL) {
+         position = get_string(position, end, &record->boot_timeline, &strings_position, strings_end);
+      }
+   }
+   return position == end;
+}
+
+/**
+ * Buffer has to be at least STATUS_DATAGRAM_HEADER_SIZE bytes long.
+ */
+void encode_datagram_header(unsigned char type, unsigned int sequence, unsigned char *buffer) {
+   buffer[0] = type;
+   put_u32(buffer + 1, sequence);
+}
+
+unsigned short encode_status_datagram(const status_record_t *record, unsigned int sequence, unsigned char *buffer,
+                                      unsigned short buffer_size) {
+   if (buffer_size < STATUS_DATAGRAM_HEADER_SIZE) {
+      return 0;
+   }
+
+   encode_datagram_header(STATUS_DATAGRAM_TYPE, sequence, buffer);
+
+   unsigned short record_length = encode_status_record(record, buffer + STATUS_DATAGRAM_HEADER_SIZE,
+         buffer_size - STATUS_DATAGRAM_HEADER_SIZE);
+   return record_length == 0 ? 0 : STATUS_DATAGRAM_HEADER_SIZE + record_length;
+}
+
+bool decode_status_datagram(const unsigned char *buffer, unsigned short length, unsigned int *sequence,
+                            status_record_t *record, char *strings_buffer, unsigned short strings_buffer_size) {
+   if (length < STATUS_DATAGRAM_HEADER_SIZE || buffer[0] != STATUS_DATAGRAM_TYPE) {
+      return false;
+   }
+
+   *sequence = get_u32(buffer + 1);
+   return decode_status_record(buffer + STATUS_DATAGRAM_HEADER_SIZE, length - STATUS_DATAGRAM_HEADER_SIZE, record,
+         strings_buffer, strings_buffer_size);
+}
+
+/**
+ * Buffer has to be at least STATUS_DATAGRAM_REPLY_SIZE bytes long.
+ */
+unsigned short encode_status_datagram_reply(unsigned int sequence, unsigned char commands, unsigned char *buffer) {
+   buffer[0] = STATUS_DATAGRAM_REPLY_TYPE;
+   put_u32(buffer + 1, sequence);
+   buffer[5] = commands;
+   return STATUS_DATAGRAM_REPLY_SIZE;
+}
+
+bool decode_status_datagram_reply(const unsigned char *buffer, unsigned short length, unsigned int sequence,
+                                  unsigned char *commands) {
+   if (length != STATUS_DATAGRAM_REPLY_SIZE || buffer[0] != STATUS_DATAGRAM_REPLY_TYPE ||
+         get_u32(buffer + 1) != sequence) {
+      return false;
+   }
+
+   *commands = buffer[5];
+   return true;
+}
+
+unsigned short get_sample_batch_encoded_length(unsigned char samples_amount, const char *device_name) {
+   return SAMPLE_BATCH_FIXED_PART_SIZE + samples_amount * SAMPLE_BATCH_ENTRY_SIZE + 1 +
+         get_string_length(device_name);
+}
+
+/**
+ * Returns the encoded length or 0 if buffer_size is not enough (see get_sample_batch_encoded_length()).
+ */
+unsigned short encode_sample_batch(const sample_record_t samples[], unsigned char samples_amount,
+                                   unsigned int current_time, const char *device_name, unsigned char *buffer,
+                                   unsigned short buffer_size) {
+   if (get_sample_batch_encoded_length(samples_amount, device_name) > buffer_size) {
+      return 0;
+   }
+
+   unsigned char *position = buffer;
+
+   *position++ = SAMPLE_BATCH_VERSION;
+   position = put_u32(position, current_time);
+   *position++ = samples_amount;
+
+   for (unsigned char i = 0; i < samples_amount; i++) {
+      position = put_u32(position, samples[i].time);
+      position = put_u16(position, (unsigned short) samples[i].temperature);
+      position = put_u16(position, (unsigned short) samples[i].humidity);
+   }
+
+   position = put_string(position, device_name);
+   return position - buffer;
+}
+
+/**
+ * Reference decoder for the collector side.
+ */
+bool decode_sample_batch(const unsigned char *buffer, unsigned short length, unsigned int *current_time,
+                         sample_record_t samples[], unsigned char max_samples_amount, unsigned char *samples_amount,
+                         char *device_name_buffer, unsigned short device_name_buffer_size) {
+   if (length < SAMPLE_BATCH_FIXED_PART_SIZE || buffer[0] != SAMPLE_BATCH_VERSION) {
+      return false;
+   }
+
+   *current_time = get_u32(buffer + 1);
+   *samples_amount = buffer[5];
+
+   const unsigned char *position = buffer + SAMPLE_BATCH_FIXED_PART_SIZE;
+   const unsigned char *end = buffer + length;
+
+   if (*samples_amount > max_samples_amount || position + *samples_amount * SAMPLE_BATCH_ENTRY_SIZE > end) {
+      return false;
+   }
+
+   for (unsigned char i = 0; i < *samples_amount; i++) {
+      samples[i].time = get_u32(position);
+      samples[i].temperature = (short) get_u16(position + 4);
+      samples[i].humidity = (short) get_u16(position + 6);
+      position += SAMPLE_BATCH_ENTRY_SIZE;
+   }
+
+   const char *device_name;
+   char *strings_position = device_name_buffer;
+
+   position = get_string(position, end, &device_name, &strings_position, device_name_buffer + device_name_buffer_size);
+   return position == end;
+}
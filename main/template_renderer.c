@@ -0,0 +1,138 @@
+#include "template_renderer.h"
+
+/**
+ * Splits the template with "<x>" parameters placeholders into literal and parameter segments. Literal segments are
+ * not copied, so the template string has to live as long as the compiled template (flash constants do).
+ *
+ * Returns false on malformed template or when TEMPLATE_MAX_SEGMENTS is exceeded.
+ */
+bool compile_template(const char string[], compiled_template_t *compiled_template) {
+   compiled_template->segments_amount = 0;
+   compiled_template->parameters_amount = 0;
+   compiled_template->literals_length = 0;
+
+   const char *literal_start = string;
+   const char *string_pointer = string;
+
+   for (;; string_pointer++) {
+      char string_char = *string_pointer;
+
+      if (string_char == '>') {
+         return false;
+      }
+      if (string_char != '<' && string_char != '\0') {
+         continue;
+      }
+
+      if (string_pointer > literal_start) {
+         if (compiled_template->segments_amount >= TEMPLATE_MAX_SEGMENTS) {
+            return false;
+         }
+
+         template_segment_t *segment = &compiled_template->segments[compiled_template->segments_amount++];
+         segment->literal = literal_start;
+         segment->value = string_pointer - literal_start;
+         compiled_template->literals_length += segment->value;
+      }
+
+      if (string_char == '\0') {
+         break;
+      }
+
+      // Parameter: "<1>" ... "<99>"
+      string_pointer++;
+      if (*string_pointer < '1' || *string_pointer > '9') {
+         return false;
+      }
+
+      unsigned short parameter_numeric_value = *string_pointer - '0';
+
+      string_pointer++;
+      if (*string_pointer >= '0' && *string_pointer <= '9') {
+         parameter_numeric_value = parameter_numeric_value * 10 + *string_pointer - '0';
+         string_pointer++;
+      }
+      if (*string_pointer != '>' || parameter_numeric_value > TEMPLATE_MAX_PARAMETERS ||
+            compiled_template->segments_amount >= TEMPLATE_MAX_SEGMENTS) {
+         return false;
+      }
+
+      template_segment_t *segment = &compiled_template->segments[compiled_template->segments_amount++];
+      segment->literal = NULL;
+      // Parameters are starting with 1
+      segment->value = parameter_numeric_value - 1;
+
+      if (parameter_numeric_value > compiled_template->parameters_amount) {
+         compiled_template->parameters_amount = parameter_numeric_value;
+      }
+
+      literal_start = string_pointer + 1;
+   }
+   return true;
+}
+
+/**
+ * Calculates the exact length (without the last \0 character) of the rendered template. Parameters lengths are
+ * stored into *parameters_lengths (at least compiled_template->parameters_amount elements) to be passed
+ * into render_template(), so every parameter is measured only once.
+ *
+ * *parameters - array of pointers to strings, NULL elements are rendered as empty strings
+ */
+unsigned short get_rendered_template_length(const compiled_template_t *compiled_template, const char *parameters[],
+                                            unsigned short parameters_lengths[]) {
+   unsigned short result_length = compiled_template->literals_length;
+
+   for (unsigned char i = 0; i < compiled_template->parameters_amount; i++) {
+      parameters_lengths[i] = parameters[i] == NULL ? 0 : strlen(parameters[i]);
+   }
+
+   for (unsigned char i = 0; i < compiled_template->segments_amount; i++) {
+      const template_segment_t *segment = &compiled_template->segments[i];
+
+      if (segment->literal == NULL) {
+         result_length += parameters_lengths[segment->value];
+      }
+   }
+   return result_length;
+}
+
+/**
+ * Renders the compiled template into the buffer in one pass. The result is \0 terminated.
+ *
+ * Returns the length of the rendered string or 0 if buffer_size is not enough
+ * (get_rendered_template_length() + 1 is required).
+ */
+unsigned short render_template(const compiled_template_t *compiled_template, const char *parameters[],
+                               const unsigned short parameters_lengths[], char *buffer, unsigned short buffer_size) {
+   unsigned short result_length = 0;
+
+   for (unsigned char i = 0; i < compiled_template->segments_amount; i++) {
+      const template_segment_t *segment = &compiled_template->segments[i];
+      const char *source;
+      unsigned short source_length;
+
+      if (segment->literal == NULL) {
+         source = parameters[segment->value];
+         source_length = parameters_lengths[segment->value];
+      } else {
+         source = segment->literal;
+         source_length = segment->value;
+      }
+
+      if (result_length + source_length >= buffer_size) {
+         return 0;
+      }
+
+      if (source_length > 0) {
+         memcpy(buffer + result_length, source, source_length);
+         result_length += source_length;
+      }
+   }
+
+   if (result_length >= buffer_size) {
+      return 0;
+   }
+
+   buffer[result_length] = '\0';
+   return result_length;
+}
@@ -27,6 +27,7 @@ static os_timer_t millisecons_time_serv_g;
 static os_timer_t status_sender_timer_g;
 static os_timer_t errors_checker_timer_g;
 static os_timer_t blink_both_leds_g;
+static os_timer_t startup_indication_timer_g;
 
 static EventGroupHandle_t general_event_group_g;
 
@@ -34,6 +35,43 @@ static QueueHandle_t uart0_queue;
 
 static SemaphoreHandle_t wirelessNetworkActionsSemaphore_g;
 
+static volatile sensor_sample_mailbox_t sensor_sample_mailbox_g;
+// Filtered samples since the last sent report. Guarded by the critical section
+static sensor_statistics_t temperature_statistics_g;
+static sensor_statistics_t humidity_statistics_g;
+
+#ifdef USE_RTC_SAMPLE_BUFFER
+// Guarded by the critical section
+static rtc_sample_buffer_t sample_buffer_g;
+// Device time at start, continues from the last buffered sample
+static unsigned int device_time_base_g;
+#endif
+
+#ifdef USE_DEEP_SLEEP
+// Restored from the RTC memory on start, saved before sleeping
+static deep_sleep_state_t deep_sleep_state_g;
+static os_timer_t deep_sleep_timer_g;
+#endif
+
+#ifdef USE_UDP_STATUS_REPORTS
+static unsigned int status_datagram_sequence_g;
+#endif
+
+#ifdef USE_MQTT
+static volatile bool mqtt_update_firmware_requested_g;
+#endif
+
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+// Used only by send_status_info_task under wirelessNetworkActionsSemaphore_g
+static report_policy_t report_policy_g;
+#endif
+
+static compiled_template_t status_info_post_request_template_g;
+static compiled_template_t status_info_request_payload_template_g;
+#if defined(USE_RTC_SAMPLE_BUFFER) && !defined(USE_MQTT) && !defined(USE_UDP_STATUS_REPORTS)
+static compiled_template_t sample_batch_post_request_template_g;
+#endif
+
 static void milliseconds_counter() {
    milliseconds_counter_g++;
 }
@@ -113,6 +151,19 @@ static void stop_both_leds_blinking() {
    os_timer_disarm(&blink_both_leds_g);
 }
 
+/**
+ * The startup blinking runs while Wi-Fi is associating, then the LEDs show the current state.
+ */
+static void stop_startup_indication() {
+   stop_both_leds_blinking();
+
+   bool server_available = (xEventGroupGetBits(general_event_group_g) & FIRST_STATUS_INFO_SENT_FLAG) &&
+         repetitive_request_errors_counter_g == 0;
+
+   gpio_set_level(AP_CONNECTION_STATUS_LED_PIN, is_connected_to_wifi() ? 1 : 0);
+   gpio_set_level(SERVER_AVAILABILITY_STATUS_LED_PIN, server_available ? 1 : 0);
+}
+
 static void blink_on_send(gpio_num_t pin) {
    int initial_pin_state = gpio_get_level(pin);
    unsigned char i;
@@ -137,97 +188,317 @@ static void blink_on_send(gpio_num_t pin) {
    }
 }
 
-void send_status_info_task(void *pvParameters) {
-   xSemaphoreTake(wirelessNetworkActionsSemaphore_g, portMAX_DELAY);
-   blink_on_send(SERVER_AVAILABILITY_STATUS_LED_PIN);
+/**
+ * Single writer, many readers mailbox without locks (sequence lock). The writer makes the sequence odd while
+ * the sample is being updated, so readers retry if the sequence is odd or changed during reading.
+ */
+static void publish_sensor_sample(const sensor_sample_t *sample) {
+   sensor_sample_mailbox_g.sequence++;
+   MEMORY_BARRIER();
+   sensor_sample_mailbox_g.sample = *sample;
+   MEMORY_BARRIER();
+   sensor_sample_mailbox_g.sequence++;
+}
 
-   char signal_strength[5];
-   snprintf(signal_strength, 5, "%d", signal_strength_g);
+static void read_sensor_sample(sensor_sample_t *sample) {
+   unsigned int sequence;
 
-   char errors_counter[6];
-   snprintf(errors_counter, 6, "%u", errors_counter_g);
+   do {
+      sequence = sensor_sample_mailbox_g.sequence;
+      MEMORY_BARRIER();
+      *sample = sensor_sample_mailbox_g.sample;
+      MEMORY_BARRIER();
+   } while ((sequence & 1) || sequence != sensor_sample_mailbox_g.sequence);
+}
 
-   char pending_connection_errors_counter[4];
-   snprintf(pending_connection_errors_counter, 4, "%u", pending_connection_errors_counter_g);
+/**
+ * A failed reading (temperature_read or humidity_read is false) is counted as rejected.
+ * Returns true if neither the temperature nor the humidity has been rejected.
+ */
+static bool add_sensor_sample_to_statistics(const sensor_sample_t *sample, bool temperature_read, bool humidity_read) {
+   taskENTER_CRITICAL();
+   bool temperature_accepted = temperature_read ?
+         sensor_statistics_add(&temperature_statistics_g, sample->temperature) :
+         sensor_statistics_reject(&temperature_statistics_g);
+   bool humidity_accepted = humidity_read ?
+         sensor_statistics_add(&humidity_statistics_g, sample->humidity) :
+         sensor_statistics_reject(&humidity_statistics_g);
+   taskEXIT_CRITICAL();
+
+   return temperature_accepted && humidity_accepted;
+}
 
-   char uptime[11];
-   snprintf(uptime, 11, "%u", milliseconds_counter_g / MILLISECONDS_COUNTER_DIVIDER);
+static void read_sensor_statistics(sensor_statistics_t *temperature_statistics,
+                                   sensor_statistics_t *humidity_statistics) {
+   taskENTER_CRITICAL();
+   *temperature_statistics = temperature_statistics_g;
+   *humidity_statistics = humidity_statistics_g;
+   taskEXIT_CRITICAL();
+}
 
-   char *build_timestamp = "";
-   char free_heap_space[7];
-   snprintf(free_heap_space, 7, "%u", esp_get_free_heap_size());
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+/**
+ * The latest filtered samples, the record values are used until the first sample has been accepted.
+ */
+static void read_report_policy_values(const status_record_t *record, report_policy_values_t *values) {
+   sensor_statistics_t temperature_statistics;
+   sensor_statistics_t humidity_statistics;
+   int temperature;
+   int humidity;
+
+   read_sensor_statistics(&temperature_statistics, &humidity_statistics);
+
+   values->temperature = median_filter_get_value(&temperature_statistics.filter, &temperature) ?
+         temperature : record->temperature;
+   values->humidity = median_filter_get_value(&humidity_statistics.filter, &humidity) ? humidity : record->humidity;
+   values->light = record->light;
+   values->light_present = record->light_present;
+}
+#endif
 
-   char *reset_reason = "";
-   char *system_restart_reason = "";
+/**
+ * Starts the new aggregation interval after the report has been sent.
+ */
+static void reset_sensor_statistics() {
+   taskENTER_CRITICAL();
+   sensor_statistics_reset(&temperature_statistics_g);
+   sensor_statistics_reset(&humidity_statistics_g);
+   taskEXIT_CRITICAL();
+}
 
-   float temperature = 0.0F;
-   char temperature_param[10];
-   temperature_param[0] = '\0';
-   char temperature_raw_param[6];
-   temperature_raw_param[0] = '\0';
-   unsigned short temperature_raw = 0;
-   i2c_master_init();
-   sht21_get_temperature(&temperature, &temperature_raw);
-   i2c_master_deinit();
-   snprintf(temperature_raw_param, 6, "%u", temperature_raw);
-   snprintf(temperature_param, 10, "%d.%u", (int) temperature, abs((int) (temperature * 100)) - (abs((int) (temperature)) * 100));
+#ifdef USE_RTC_SAMPLE_BUFFER
+static unsigned int get_device_time() {
+   return device_time_base_g + milliseconds_counter_g / MILLISECONDS_COUNTER_DIVIDER;
+}
 
-   float humidity = 0.0F;
-   char humidity_param[10];
-   humidity_param[0] = '\0';
+static void buffer_sensor_sample(const sensor_sample_t *sensor_sample) {
+   sample_record_t sample;
+
+   sample.time = get_device_time();
+   sample.temperature = sensor_sample->temperature;
+   sample.humidity = sensor_sample->humidity;
+
+   taskENTER_CRITICAL();
+   rtc_sample_buffer_push(&sample_buffer_g, &sample);
+   taskEXIT_CRITICAL();
+}
+#endif
+
+/**
+ * Measures the temperature and the humidity, publishes the sample and adds it to the statistics.
+ */
+static void take_sensor_sample(bool *resolution_set) {
+   sensor_sample_t sample;
+
+   sample.temperature = 0;
+   sample.temperature_raw = 0;
+   sample.humidity = 0;
+
+   EXECUTION_TIME_START(sensor_sampling);
+   // Both measurements within one driver installation
    i2c_master_init();
-   sht21_get_humidity(&humidity);
+   if (!*resolution_set) {
+      // The sensor keeps the user register until power off
+      *resolution_set = sht21_set_resolution(SHT21_MEASUREMENT_RESOLUTION) == ESP_OK;
+   }
+   esp_err_t temperature_result = sht21_get_temperature_centi(&sample.temperature, &sample.temperature_raw);
+   esp_err_t humidity_result = sht21_get_humidity_centi(&sample.humidity);
    i2c_master_deinit();
-   snprintf(humidity_param, 10, "%u.%u", (unsigned int) humidity, abs((int) (humidity * 100)) - (abs((int) (humidity)) * 100));
+   EXECUTION_TIME_END(sensor_sampling, 2);
+
+   boot_profiler_mark(BOOT_PHASE_FIRST_SENSOR_READ);
+
+   if (temperature_result != ESP_OK || humidity_result != ESP_OK) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nSensor reading failed. Temperature: %d, humidity: %d\n", temperature_result, humidity_result);
+      #endif
+   } else {
+      // The last complete sample stays published
+      sample.timestamp = milliseconds_counter_g;
+      publish_sensor_sample(&sample);
+   }
+
+   // Only valid samples are buffered
+   if (add_sensor_sample_to_statistics(&sample, temperature_result == ESP_OK, humidity_result == ESP_OK)) {
+#ifdef USE_RTC_SAMPLE_BUFFER
+      buffer_sensor_sample(&sample);
+#endif
+   }
+}
+
+static void sensor_sampling_task(void *pvParameters) {
+   bool resolution_set = false;
+
+   for (;;) {
+      take_sensor_sample(&resolution_set);
+      vTaskDelay(SENSOR_SAMPLING_INTERVAL_MS / portTICK_RATE_MS);
+   }
+}
+
+#ifdef USE_DEEP_SLEEP
+static bool is_reporting_wake(unsigned int wake) {
+   return wake % DEEP_SLEEP_REPORT_INTERVAL_WAKES == 0;
+}
+
+/**
+ * Saves the duty cycle state into the RTC memory and sleeps until the next wake, which starts from app_main().
+ */
+static void enter_deep_sleep(bool report_sent) {
+   os_timer_disarm(&deep_sleep_timer_g);
+
+   // Ticks are counted from the scheduler start, so the boot loader time isn't included
+   unsigned int awake_time_ms = xTaskGetTickCount() * portTICK_RATE_MS;
+
+   deep_sleep_state_g.awake_time_ms += awake_time_ms;
+   if (report_sent) {
+      deep_sleep_state_g.previous_cycle_awake_time_ms = deep_sleep_state_g.awake_time_ms;
+      deep_sleep_state_g.awake_time_ms = 0;
+   }
+#ifdef USE_RTC_SAMPLE_BUFFER
+   deep_sleep_state_g.device_time = device_time_base_g + (awake_time_ms + DEEP_SLEEP_INTERVAL_MS + 500) / 1000;
+#endif
+   deep_sleep_state_save(&deep_sleep_state_g, DEEP_SLEEP_STATE_RTC_ADDRESS);
+
+   // The radio is neither calibrated nor powered on the wakes which only buffer the sample
+   esp_deep_sleep_set_rf_option(is_reporting_wake(deep_sleep_state_g.wakes_amount + 1) ?
+         DEEP_SLEEP_RF_DEFAULT : DEEP_SLEEP_RF_DISABLED);
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nWake %u, awake time: %u ms, report sent: %u\n", deep_sleep_state_g.wakes_amount, awake_time_ms,
+         report_sent);
+   #endif
+
+   esp_deep_sleep((unsigned long long) DEEP_SLEEP_INTERVAL_MS * 1000);
+}
+
+static void on_awake_timeout() {
+   if (!is_connected_to_wifi()) {
+      // The access point could have changed the channel, all of them are scanned on the next reporting wake
+      deep_sleep_state_g.access_point_channel = 0;
+   }
+   enter_deep_sleep(false);
+}
+#endif
+
+static unsigned short get_saturated_sum(unsigned short value1, unsigned short value2) {
+   unsigned int sum = (unsigned int) value1 + value2;
+
+   return sum > SENSOR_STATISTICS_MAX_COUNT ? SENSOR_STATISTICS_MAX_COUNT : sum;
+}
+
+/**
+ * If there are no valid samples in the interval, the last sample is reported, so the server sees sensor errors.
+ */
+static void fill_measurement_statistics(const sensor_statistics_t *statistics, int last_value, short *value,
+                                        short *min, short *max, unsigned short *deviation) {
+   if (statistics->statistics.count == 0) {
+      *value = last_value;
+      *min = last_value;
+      *max = last_value;
+      *deviation = 0;
+      return;
+   }
+
+   *value = running_statistics_get_mean(&statistics->statistics);
+   *min = statistics->statistics.min;
+   *max = statistics->statistics.max;
+   *deviation = running_statistics_get_standard_deviation(&statistics->statistics);
+}
+
+static void fill_status_record(status_record_t *record, char *system_restart_reason_buffer,
+                               unsigned char system_restart_reason_buffer_size,
+                               char boot_timeline_buffer[BOOT_PROFILER_TIMELINE_MAX_LENGTH]) {
+   memset(record, 0, sizeof(status_record_t));
+
+   record->signal_strength = signal_strength_g;
+   record->errors_counter = errors_counter_g;
+   record->pending_connection_errors_counter = pending_connection_errors_counter_g;
+   record->uptime = milliseconds_counter_g / MILLISECONDS_COUNTER_DIVIDER;
+   record->free_heap_space = esp_get_free_heap_size();
+   record->device_name = DEVICE_NAME;
+   record->build_timestamp = "";
+   record->reset_reason = "";
+   record->system_restart_reason = "";
+   record->boot_timeline = "";
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+   record->suppressed_reports = report_policy_g.statistics.suppressed_reports;
+#endif
+#ifdef USE_DEEP_SLEEP
+   record->awake_time = deep_sleep_state_g.previous_cycle_awake_time_ms;
+#endif
+
+   sensor_sample_t sensor_sample;
+   read_sensor_sample(&sensor_sample);
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nSensor sample age: %u ms\n", (milliseconds_counter_g - sensor_sample.timestamp) * (1000 / MILLISECONDS_COUNTER_DIVIDER));
+   #endif
+
+   sensor_statistics_t temperature_statistics;
+   sensor_statistics_t humidity_statistics;
+   read_sensor_statistics(&temperature_statistics, &humidity_statistics);
+
+   fill_measurement_statistics(&temperature_statistics, sensor_sample.temperature, &record->temperature,
+         &record->temperature_min, &record->temperature_max, &record->temperature_deviation);
+   fill_measurement_statistics(&humidity_statistics, sensor_sample.humidity, &record->humidity,
+         &record->humidity_min, &record->humidity_max, &record->humidity_deviation);
+   record->temperature_raw = sensor_sample.temperature_raw;
+   record->samples_amount = get_saturated_sum(temperature_statistics.statistics.count,
+         temperature_statistics.rejected_amount);
+   record->rejected_samples_amount = get_saturated_sum(temperature_statistics.rejected_amount,
+         humidity_statistics.rejected_amount);
 #ifdef STREET_MONITOR
-   char light_param[6];
-   light_param[0] = '\0';
-   unsigned short light = adc_read();
-   snprintf(light_param, 6, "%u", light);
-#else
-   char *light_param = "null";
+   record->light_present = true;
+   record->light = adc_read();
 #endif
 
    if ((xEventGroupGetBits(general_event_group_g) & FIRST_STATUS_INFO_SENT_FLAG) == 0) {
-      char build_timestamp_filled[30];
-      snprintf(build_timestamp_filled, 30, "%s", __TIMESTAMP__);
-      build_timestamp = build_timestamp_filled;
+      record->first_report = true;
+      record->build_timestamp = __TIMESTAMP__;
+
+      boot_profiler_format_timeline(boot_timeline_buffer, BOOT_PROFILER_TIMELINE_MAX_LENGTH);
+      record->boot_timeline = boot_timeline_buffer;
 
+#ifdef USE_DEEP_SLEEP
+      // Not the deep sleep wake, but the start of the duty cycle, which hasn't been confirmed yet
+      esp_reset_reason_t rst_info = deep_sleep_state_g.reset_reason;
+#else
       esp_reset_reason_t rst_info = esp_reset_reason();
+#endif
 
       switch (rst_info) {
          case ESP_RST_UNKNOWN:
-            reset_reason = "Unknown";
+            record->reset_reason = "Unknown";
             break;
          case ESP_RST_POWERON:
-            reset_reason = "Power on";
+            record->reset_reason = "Power on";
             break;
          case ESP_RST_EXT:
-            reset_reason = "Reset by external pin";
+            record->reset_reason = "Reset by external pin";
             break;
          case ESP_RST_SW:
-            reset_reason = "Software";
+            record->reset_reason = "Software";
             break;
          case ESP_RST_PANIC:
-            reset_reason = "Exception/panic";
+            record->reset_reason = "Exception/panic";
             break;
          case ESP_RST_INT_WDT:
-            reset_reason = "Watchdog";
+            record->reset_reason = "Watchdog";
             break;
          case ESP_RST_TASK_WDT:
-            reset_reason = "Task watchdog";
+            record->reset_reason = "Task watchdog";
             break;
          case ESP_RST_WDT:
-            reset_reason = "Other watchdog";
+            record->reset_reason = "Other watchdog";
             break;
          case ESP_RST_DEEPSLEEP:
-            reset_reason = "Deep sleep";
+            record->reset_reason = "Deep sleep";
             break;
          case ESP_RST_BROWNOUT:
-            reset_reason = "Brownout";
+            record->reset_reason = "Brownout";
             break;
          case ESP_RST_SDIO:
-            reset_reason = "SDIO";
+            record->reset_reason = "SDIO";
             break;
       }
 
@@ -235,94 +506,597 @@ void send_status_info_task(void *pvParameters) {
 
       rtc_mem_read(SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS, &system_restart_reason_type, 4);
 
-      if (system_restart_reason_type == ACCESS_POINT_CONNECTION_ERROR) {
+      if (system_restart_reason_type == ACCESS_POINT_CONNECTION_ERROR ||
+            system_restart_reason_type == REQUEST_CONNECTION_ERROR) {
          int connection_error_code = 1;
-         char system_restart_reason_inner[31];
+         const char *prefix = system_restart_reason_type == ACCESS_POINT_CONNECTION_ERROR ?
+               "AP connections error. Code: " : "Requests error. Code: ";
+         unsigned char prefix_length = strlen(prefix);
 
          rtc_mem_read(CONNECTION_ERROR_CODE_RTC_ADDRESS, &connection_error_code, 4);
 
-         snprintf(system_restart_reason_inner, 31, "AP connections error. Code: %d", connection_error_code);
-         system_restart_reason = system_restart_reason_inner;
-      } else if (system_restart_reason_type == REQUEST_CONNECTION_ERROR) {
-         int connection_error_code = 1;
-         char system_restart_reason_inner[25];
+         memcpy(system_restart_reason_buffer, prefix, prefix_length);
+         format_signed(system_restart_reason_buffer + prefix_length, system_restart_reason_buffer_size - prefix_length,
+               connection_error_code);
+         record->system_restart_reason = system_restart_reason_buffer;
+      } else if (system_restart_reason_type == SOFTWARE_UPGRADE) {
+         record->system_restart_reason = "Software upgrade";
+      }
+   }
+}
 
-         rtc_mem_read(CONNECTION_ERROR_CODE_RTC_ADDRESS, &connection_error_code, 4);
+/**
+ * The restart reason is kept in the RTC memory until the server has confirmed the report, which carries it.
+ */
+static void clear_system_restart_reason() {
+   unsigned int overwrite_value = 0xFFFF;
 
-         snprintf(system_restart_reason_inner, 25, "Requests error. Code: %d", connection_error_code);
-         system_restart_reason = system_restart_reason_inner;
-      } else if (system_restart_reason_type == SOFTWARE_UPGRADE) {
-         system_restart_reason = "Software upgrade";
+   rtc_mem_write(SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS, &overwrite_value, 4);
+   rtc_mem_write(CONNECTION_ERROR_CODE_RTC_ADDRESS, &overwrite_value, 4);
+}
+
+#ifndef USE_UDP_STATUS_REPORTS
+#ifndef USE_BINARY_STATUS_PAYLOAD
+/**
+ * ',"buildTimestamp":"...","resetReason":"..."' and so on for the not empty fields of the first report.
+ * Returns NULL if there are none, otherwise do not forget to call free() function on the returned pointer.
+ */
+static char *create_first_report_fields(const status_record_t *record) {
+   const char *values[] = {record->build_timestamp, record->reset_reason, record->system_restart_reason,
+         record->boot_timeline};
+   unsigned char fields_amount = sizeof(values) / sizeof(values[0]);
+   unsigned short length = 0;
+
+   for (unsigned char i = 0; i < fields_amount; i++) {
+      if (values[i] != NULL && values[i][0] != '\0') {
+         // ,"name":"value"
+         length += strlen(STATUS_INFO_FIRST_REPORT_FIELD_NAMES[i]) + strlen(values[i]) + 6;
+      }
+   }
+
+   if (length == 0) {
+      return NULL;
+   }
+
+   char *fields = MALLOC(length + 1, milliseconds_counter_g);
+
+   if (fields == NULL) {
+      return NULL;
+   }
+
+   char *position = fields;
+
+   for (unsigned char i = 0; i < fields_amount; i++) {
+      if (values[i] == NULL || values[i][0] == '\0') {
+         continue;
       }
 
-      unsigned int overwrite_value = 0xFFFF;
-      rtc_mem_write(SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS, &overwrite_value, 4);
-      rtc_mem_write(CONNECTION_ERROR_CODE_RTC_ADDRESS, &overwrite_value, 4);
+      unsigned short name_length = strlen(STATUS_INFO_FIRST_REPORT_FIELD_NAMES[i]);
+      unsigned short value_length = strlen(values[i]);
+
+      memcpy(position, ",\"", 2);
+      memcpy(position + 2, STATUS_INFO_FIRST_REPORT_FIELD_NAMES[i], name_length);
+      memcpy(position + 2 + name_length, "\":\"", 3);
+      memcpy(position + 5 + name_length, values[i], value_length);
+      position[5 + name_length + value_length] = '"';
+      position += name_length + value_length + 6;
+   }
+   *position = '\0';
+   return fields;
+}
+#endif
+
+/**
+ * Do not forget to call free() function on returned pointer when it's no longer needed.
+ */
+static char *create_status_info_payload(const status_record_t *record, unsigned short *payload_length) {
+#ifdef USE_BINARY_STATUS_PAYLOAD
+   *payload_length = get_status_record_encoded_length(record);
+   unsigned char *payload = (unsigned char *) MALLOC(*payload_length, milliseconds_counter_g);
+
+   if (payload != NULL) {
+      encode_status_record(record, payload, *payload_length);
+   }
+   return (char *) payload;
+#else
+   char signal_strength[5];
+   format_signed(signal_strength, 5, record->signal_strength);
+
+   char errors_counter[6];
+   format_unsigned(errors_counter, 6, record->errors_counter);
+
+   char pending_connection_errors_counter[4];
+   format_unsigned(pending_connection_errors_counter, 4, record->pending_connection_errors_counter);
+
+   char uptime[11];
+   format_unsigned(uptime, 11, record->uptime);
+
+   char free_heap_space[7];
+   format_unsigned(free_heap_space, 7, record->free_heap_space);
+
+   char temperature_param[10];
+   format_fixed_point(temperature_param, 10, record->temperature, 2);
+
+   char temperature_raw_param[6];
+   format_unsigned(temperature_raw_param, 6, record->temperature_raw);
+
+   char humidity_param[10];
+   format_fixed_point(humidity_param, 10, record->humidity, 2);
+
+   char light_param[6] = "null";
+   if (record->light_present) {
+      format_unsigned(light_param, 6, record->light);
    }
 
+   char suppressed_reports_param[11];
+   format_unsigned(suppressed_reports_param, 11, record->suppressed_reports);
+
+   char temperature_min_param[10];
+   format_fixed_point(temperature_min_param, 10, record->temperature_min, 2);
+
+   char temperature_max_param[10];
+   format_fixed_point(temperature_max_param, 10, record->temperature_max, 2);
+
+   char temperature_deviation_param[10];
+   format_fixed_point(temperature_deviation_param, 10, record->temperature_deviation, 2);
+
+   char humidity_min_param[10];
+   format_fixed_point(humidity_min_param, 10, record->humidity_min, 2);
+
+   char humidity_max_param[10];
+   format_fixed_point(humidity_max_param, 10, record->humidity_max, 2);
+
+   char humidity_deviation_param[10];
+   format_fixed_point(humidity_deviation_param, 10, record->humidity_deviation, 2);
+
+   char samples_param[6];
+   format_unsigned(samples_param, 6, record->samples_amount);
+
+   char rejected_samples_param[6];
+   format_unsigned(rejected_samples_param, 6, record->rejected_samples_amount);
+
+   char awake_time_param[11];
+   format_unsigned(awake_time_param, 11, record->awake_time);
+
+   char *first_report_fields = create_first_report_fields(record);
+
    const char *status_info_request_payload_template_parameters[] =
-         {signal_strength, DEVICE_NAME, errors_counter, pending_connection_errors_counter, uptime, build_timestamp, free_heap_space,
-               reset_reason, system_restart_reason, temperature_param, temperature_raw_param, humidity_param, light_param, NULL};
-   char *request_payload = set_string_parameters(STATUS_INFO_REQUEST_PAYLOAD_TEMPLATE, status_info_request_payload_template_parameters);
+         {signal_strength, record->device_name, errors_counter, pending_connection_errors_counter, uptime,
+               free_heap_space, temperature_param, temperature_raw_param, humidity_param, light_param,
+               temperature_min_param, temperature_max_param, temperature_deviation_param, humidity_min_param,
+               humidity_max_param, humidity_deviation_param, samples_param, rejected_samples_param,
+               suppressed_reports_param, awake_time_param, first_report_fields};
+   unsigned short status_info_request_payload_parameters_lengths[TEMPLATE_MAX_PARAMETERS];
+
+   *payload_length = get_rendered_template_length(&status_info_request_payload_template_g,
+         status_info_request_payload_template_parameters, status_info_request_payload_parameters_lengths);
+   char *payload = MALLOC(*payload_length + 1, milliseconds_counter_g);
+
+   if (payload != NULL) {
+      render_template(&status_info_request_payload_template_g, status_info_request_payload_template_parameters,
+            status_info_request_payload_parameters_lengths, payload, *payload_length + 1);
+   }
+
+   if (first_report_fields != NULL) {
+      FREE(first_report_fields);
+   }
 
    #ifdef ALLOW_USE_PRINTF
-   //printf("\nRequest payload: %s\n", request_payload);
+   printf("\nRequest payload: %s\n", payload);
    #endif
 
-   unsigned short request_payload_length = strnlen(request_payload, 0xFFFF);
-   char request_payload_length_string[6];
-   snprintf(request_payload_length_string, 6, "%u", request_payload_length);
-   const char *request_template_parameters[] = {request_payload_length_string, SERVER_IP_ADDRESS, request_payload, NULL};
-   char *request = set_string_parameters(STATUS_INFO_POST_REQUEST, request_template_parameters);
-   FREE(request_payload);
+   return payload;
+#endif
+}
+#endif
+
+#ifdef USE_MQTT
+/**
+ * Publishes the status to MQTT_STATUS_TOPIC. Commands aren't expected in the reply, they come to MQTT_COMMAND_TOPIC.
+ */
+static bool send_status_info_mqtt_message(const status_record_t *record) {
+   EXECUTION_TIME_START(payload_rendering);
+   unsigned short payload_length;
+   char *payload = create_status_info_payload(record, &payload_length);
+   EXECUTION_TIME_END(payload_rendering, payload_length);
+
+   if (payload == NULL) {
+      return false;
+   }
+
+   EXECUTION_TIME_START(status_publishing);
+   bool published = mqtt_publish(MQTT_STATUS_TOPIC, (unsigned char *) payload, payload_length, MQTT_STATUS_QOS);
+   EXECUTION_TIME_END(status_publishing, payload_length);
+
+   FREE(payload);
+   return published;
+}
+#elif defined(USE_UDP_STATUS_REPORTS)
+/**
+ * Sends the status as one UDP datagram without connection. The server's reply is optional. With UDP_REPLY_EXPECTED
+ * *confirmed is set only when the reply with the same sequence number has been received, otherwise the sent datagram
+ * is treated as delivered. Commands are taken only from the reply. Returns false if the datagram hasn't been sent.
+ */
+static bool send_status_info_datagram(const status_record_t *record, bool *confirmed, bool *update_firmware_requested) {
+   unsigned short datagram_length = STATUS_DATAGRAM_HEADER_SIZE + get_status_record_encoded_length(record);
+   unsigned char *datagram = (unsigned char *) MALLOC(datagram_length, milliseconds_counter_g);
+
+   if (datagram == NULL) {
+      return false;
+   }
+
+   unsigned int sequence = status_datagram_sequence_g++;
+   encode_status_datagram(record, sequence, datagram, datagram_length);
+
+   unsigned char reply[STATUS_DATAGRAM_REPLY_SIZE];
+
+   EXECUTION_TIME_START(status_datagram);
+   int reply_length = send_datagram(datagram, datagram_length, reply, sizeof(reply), STATUS_DATAGRAM_REPLY_TIMEOUT_MS);
+   EXECUTION_TIME_END(status_datagram, datagram_length);
+
+   FREE(datagram);
+
+   if (reply_length < 0) {
+      return false;
+   }
+
+   unsigned char commands;
+   bool replied = reply_length > 0 && decode_status_datagram_reply(reply, reply_length, sequence, &commands);
+
+   #ifdef UDP_REPLY_EXPECTED
+   *confirmed = replied;
+   #else
+   // The server may never reply, otherwise the reset reason would be repeated in every report
+   *confirmed = true;
+   #endif
+   *update_firmware_requested = replied && (commands & STATUS_DATAGRAM_UPDATE_FIRMWARE_COMMAND);
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nStatus datagram %u has been sent, %s\n", sequence, replied ? "replied" : "no reply");
+   #endif
+
+   return true;
+}
+#else
+/**
+ * Renders the request header and sends it with the payload. Do not forget to call free() function on returned
+ * response when it's no longer needed.
+ */
+static char *send_http_post_request(const compiled_template_t *header_template, const char *payload,
+                                    unsigned short payload_length) {
+   char payload_length_string[6];
+   format_unsigned(payload_length_string, 6, payload_length);
+   const char *request_template_parameters[] = {payload_length_string, SERVER_IP_ADDRESS};
+   unsigned short request_parameters_lengths[TEMPLATE_MAX_PARAMETERS];
+   unsigned short request_header_length = get_rendered_template_length(header_template, request_template_parameters,
+         request_parameters_lengths);
+   char *request_header = MALLOC(request_header_length + 1, milliseconds_counter_g);
+
+   if (request_header == NULL) {
+      return NULL;
+   }
+
+   render_template(header_template, request_template_parameters, request_parameters_lengths, request_header,
+         request_header_length + 1);
 
    #ifdef ALLOW_USE_PRINTF
-   printf("\nCreated request: %s\n", request);
+   printf("\nCreated request header: %s\n", request_header);
    #endif
 
-   char *response = send_request(request, 255, milliseconds_counter_g);
+   // Header and body are sent as separate fragments, so the body is never copied into the request
+   struct iovec request_fragments[2];
+   request_fragments[0].iov_base = request_header;
+   request_fragments[0].iov_len = request_header_length;
+   request_fragments[1].iov_base = (void *) payload;
+   request_fragments[1].iov_len = payload_length;
+
+   char *response = send_request_fragments(request_fragments, 2, 255, milliseconds_counter_g);
+
+   FREE(request_header);
+   return response;
+}
+
+/**
+ * Sends the status over kept alive HTTP connection. Returns true if the server confirmed it.
+ */
+static bool send_status_info_http_request(const status_record_t *record, bool *update_firmware_requested) {
+   EXECUTION_TIME_START(payload_rendering);
+   unsigned short request_payload_length;
+   char *request_payload = create_status_info_payload(record, &request_payload_length);
+   EXECUTION_TIME_END(payload_rendering, request_payload_length);
+
+   if (request_payload == NULL) {
+      return false;
+   }
+
+   EXECUTION_TIME_START(status_request);
+   char *response = send_http_post_request(&status_info_post_request_template_g, request_payload,
+         request_payload_length);
+   EXECUTION_TIME_END(status_request, request_payload_length);
+
+   FREE(request_payload);
+
+   if (response == NULL) {
+      return false;
+   }
+
+   bool confirmed = strstr(response, RESPONSE_SERVER_SENT_OK) != NULL;
+
+   *update_firmware_requested = confirmed && strstr(response, UPDATE_FIRMWARE) != NULL;
+   FREE(response);
+   return confirmed;
+}
+#endif
+
+#ifdef USE_RTC_SAMPLE_BUFFER
+#ifdef USE_MQTT
+static bool send_sample_batch(unsigned char *payload, unsigned short batch_length) {
+   return mqtt_publish(MQTT_SAMPLES_TOPIC, payload, batch_length, MQTT_QOS_AT_LEAST_ONCE);
+}
+#elif defined(USE_UDP_STATUS_REPORTS)
+/**
+ * Unlike the status, the samples are kept until the collector confirms them with the reply.
+ */
+static bool send_sample_batch(unsigned char *payload, unsigned short batch_length) {
+   unsigned int sequence = status_datagram_sequence_g++;
+   unsigned char reply[STATUS_DATAGRAM_REPLY_SIZE];
+   unsigned char commands;
+
+   encode_datagram_header(SAMPLE_BATCH_DATAGRAM_TYPE, sequence, payload);
+
+   int reply_length = send_datagram(payload, STATUS_DATAGRAM_HEADER_SIZE + batch_length, reply, sizeof(reply),
+         STATUS_DATAGRAM_REPLY_TIMEOUT_MS);
 
-   FREE(request);
+   return reply_length > 0 && decode_status_datagram_reply(reply, reply_length, sequence, &commands);
+}
+#else
+static bool send_sample_batch(unsigned char *payload, unsigned short batch_length) {
+   char *response = send_http_post_request(&sample_batch_post_request_template_g, (char *) payload, batch_length);
 
    if (response == NULL) {
+      return false;
+   }
+
+   bool confirmed = strstr(response, RESPONSE_SERVER_SENT_OK) != NULL;
+
+   FREE(response);
+   return confirmed;
+}
+#endif
+
+/**
+ * Uploads all the buffered samples in one request. They are removed from the RTC memory only when the upload has been
+ * confirmed, samples buffered meanwhile stay for the next upload.
+ */
+static void upload_buffered_samples() {
+   sample_record_t *samples = (sample_record_t *) MALLOC(SAMPLE_BUFFER_CAPACITY * sizeof(sample_record_t),
+         milliseconds_counter_g);
+
+   if (samples == NULL) {
+      return;
+   }
+
+   unsigned int end_sequence;
+
+   taskENTER_CRITICAL();
+   unsigned char samples_amount = rtc_sample_buffer_read(&sample_buffer_g, samples, SAMPLE_BUFFER_CAPACITY,
+         &end_sequence);
+   taskEXIT_CRITICAL();
+
+   bool uploaded = true;
+
+   if (samples_amount > 0) {
+      unsigned short batch_length = get_sample_batch_encoded_length(samples_amount, DEVICE_NAME);
+      unsigned char *payload = (unsigned char *) MALLOC(SAMPLE_BATCH_PAYLOAD_OFFSET + batch_length,
+            milliseconds_counter_g);
+
+      if (payload != NULL) {
+         encode_sample_batch(samples, samples_amount, get_device_time(), DEVICE_NAME,
+               payload + SAMPLE_BATCH_PAYLOAD_OFFSET, batch_length);
+
+         EXECUTION_TIME_START(sample_batch_upload);
+         uploaded = send_sample_batch(payload, batch_length);
+         EXECUTION_TIME_END(sample_batch_upload, samples_amount);
+
+         FREE(payload);
+      } else {
+         uploaded = false;
+      }
+   }
+
+   FREE(samples);
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nBuffered samples: %u, uploaded: %u\n", samples_amount, uploaded);
+   #endif
+
+   // Also drops the slots with corrupted samples
+   if (uploaded) {
+      taskENTER_CRITICAL();
+      rtc_sample_buffer_remove(&sample_buffer_g, end_sequence);
+      taskEXIT_CRITICAL();
+   }
+}
+#endif
+
+static void start_firmware_update() {
+   xEventGroupSetBits(general_event_group_g, UPDATE_FIRMWARE_FLAG);
+   start_both_leds_blinking();
+
+   SYSTEM_RESTART_REASON_TYPE reason = SOFTWARE_UPGRADE;
+   rtc_mem_write(SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS, &reason, 4);
+
+   close_http_server_connection();
+   update_firmware();
+}
+
+static void on_status_info_sent(bool sent, bool confirmed, bool update_firmware_requested) {
+   if (!sent) {
       repetitive_request_errors_counter_g++;
       errors_counter_g++;
       gpio_set_level(SERVER_AVAILABILITY_STATUS_LED_PIN, 0);
-   } else {
-      if (strstr(response, RESPONSE_SERVER_SENT_OK)) {
-         repetitive_request_errors_counter_g = 0;
-         gpio_set_level(SERVER_AVAILABILITY_STATUS_LED_PIN, 1);
+      return;
+   }
 
-         if ((xEventGroupGetBits(general_event_group_g) & FIRST_STATUS_INFO_SENT_FLAG) == 0) {
-            xEventGroupSetBits(general_event_group_g, FIRST_STATUS_INFO_SENT_FLAG);
-         }
+   gpio_set_level(SERVER_AVAILABILITY_STATUS_LED_PIN, confirmed ? 1 : 0);
 
-         #ifdef ALLOW_USE_PRINTF
-         printf("\nResponse OK\n");
-         #endif
+   // An unacknowledged UDP datagram doesn't prove the server is reachable when a reply is expected
+   if (!confirmed) {
+      return;
+   }
 
-         if (strstr(response, UPDATE_FIRMWARE)) {
-            xEventGroupSetBits(general_event_group_g, UPDATE_FIRMWARE_FLAG);
-            start_both_leds_blinking();
+   repetitive_request_errors_counter_g = 0;
 
-            SYSTEM_RESTART_REASON_TYPE reason = SOFTWARE_UPGRADE;
-            rtc_mem_write(SYSTEM_RESTART_REASON_TYPE_RTC_ADDRESS, &reason, 4);
+   // Reset reasons are repeated until the server has confirmed them
+   if ((xEventGroupGetBits(general_event_group_g) & FIRST_STATUS_INFO_SENT_FLAG) == 0) {
+      xEventGroupSetBits(general_event_group_g, FIRST_STATUS_INFO_SENT_FLAG);
+      clear_system_restart_reason();
+      #ifdef USE_DEEP_SLEEP
+      // Saved with the state before the sleep
+      deep_sleep_state_g.first_report_confirmed = true;
+      #endif
 
-            update_firmware();
-         }
-      } else {
-         repetitive_request_errors_counter_g++;
-         errors_counter_g++;
-         gpio_set_level(SERVER_AVAILABILITY_STATUS_LED_PIN, 0);
+      boot_profiler_mark(BOOT_PHASE_FIRST_RESPONSE_OK);
+      boot_profiler_print();
+   }
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nResponse OK\n");
+   #endif
+
+   if (update_firmware_requested) {
+      start_firmware_update();
+   }
+}
+
+void send_status_info_task(void *pvParameters) {
+   xSemaphoreTake(wirelessNetworkActionsSemaphore_g, portMAX_DELAY);
+
+   status_record_t status_record;
+   char system_restart_reason_buffer[40];
+   char boot_timeline_buffer[BOOT_PROFILER_TIMELINE_MAX_LENGTH];
+
+   fill_status_record(&status_record, system_restart_reason_buffer, sizeof(system_restart_reason_buffer),
+         boot_timeline_buffer);
+
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+   unsigned int current_time_ms = milliseconds_counter_g * (1000 / MILLISECONDS_COUNTER_DIVIDER);
+   report_policy_values_t report_policy_values;
+
+   read_report_policy_values(&status_record, &report_policy_values);
+
+   report_reason_t report_reason = report_policy_evaluate(&report_policy_g, &status_record, &report_policy_values,
+         current_time_ms);
+
+   if (report_reason == REPORT_REASON_NONE) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nStatus report suppressed. Total suppressed: %u\n", report_policy_g.statistics.suppressed_reports);
+      #endif
+
+      xSemaphoreGive(wirelessNetworkActionsSemaphore_g);
+      vTaskDelete(NULL);
+      return;
+   }
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nStatus report reason: %u\n", report_reason);
+   #endif
+#endif
+
+   blink_on_send(SERVER_AVAILABILITY_STATUS_LED_PIN);
+
+   bool update_firmware_requested = false;
+#ifdef USE_MQTT
+   // QoS 1 message is confirmed by the broker with PUBACK
+   bool sent = send_status_info_mqtt_message(&status_record);
+   bool confirmed = sent;
+#elif defined(USE_UDP_STATUS_REPORTS)
+   bool confirmed = false;
+   bool sent = send_status_info_datagram(&status_record, &confirmed, &update_firmware_requested);
+#else
+   // Not confirmed HTTP request is an error
+   bool sent = send_status_info_http_request(&status_record, &update_firmware_requested);
+   bool confirmed = sent;
+#endif
+
+   if (sent) {
+      reset_sensor_statistics();
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+      report_policy_on_sent(&report_policy_g, &status_record, &report_policy_values, current_time_ms);
+#endif
+#ifdef USE_RTC_SAMPLE_BUFFER
+      if (!update_firmware_requested) {
+         upload_buffered_samples();
       }
+#endif
+   }
+
+   on_status_info_sent(sent, confirmed, update_firmware_requested);
 
-      FREE(response);
+#ifdef USE_DEEP_SLEEP
+   // Not retried, the next report is sent on the next reporting wake
+   if (!update_firmware_requested) {
+      enter_deep_sleep(sent);
    }
+#endif
 
    xSemaphoreGive(wirelessNetworkActionsSemaphore_g);
    vTaskDelete(NULL);
 }
 
+#ifdef USE_MQTT
+/**
+ * Called from mqtt_task. The firmware update is started there after mqtt_process() returns.
+ */
+static void on_mqtt_message(const char *topic, unsigned short topic_length, const unsigned char *payload,
+                            unsigned short payload_length) {
+   char command[MQTT_COMMAND_MAX_LENGTH + 1];
+
+   if (topic_length != sizeof(MQTT_COMMAND_TOPIC) - 1 || memcmp(topic, MQTT_COMMAND_TOPIC, topic_length) != 0 ||
+         payload_length > MQTT_COMMAND_MAX_LENGTH) {
+      return;
+   }
+
+   memcpy(command, payload, payload_length);
+   command[payload_length] = '\0';
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nReceived command: %s\n", command);
+   #endif
+
+   if (strstr(command, UPDATE_FIRMWARE)) {
+      mqtt_update_firmware_requested_g = true;
+   }
+}
+
+/**
+ * Keeps the connection to the broker, so the commands are received immediately instead of with the next status.
+ */
+static void mqtt_task(void *pvParameters) {
+   for (;;) {
+      if (!mqtt_is_connected()) {
+         if (!is_connected_to_wifi() || !mqtt_connect(DEVICE_NAME, on_mqtt_message) ||
+               !mqtt_subscribe(MQTT_COMMAND_TOPIC, MQTT_QOS_AT_LEAST_ONCE)) {
+            vTaskDelay(MQTT_RECONNECTION_INTERVAL_MS / portTICK_RATE_MS);
+            continue;
+         }
+      }
+
+      mqtt_process(MQTT_PROCESS_INTERVAL_MS);
+
+      if (mqtt_update_firmware_requested_g) {
+         mqtt_disconnect();
+
+         xSemaphoreTake(wirelessNetworkActionsSemaphore_g, portMAX_DELAY);
+         start_firmware_update();
+         xSemaphoreGive(wirelessNetworkActionsSemaphore_g);
+
+         vTaskDelete(NULL);
+      }
+   }
+}
+#endif
+
 static void send_status_info() {
    if (is_connected_to_wifi() == false || xTaskGetHandle(SEND_STATUS_INFO_TASK_NAME) != NULL ||
          (xEventGroupGetBits(general_event_group_g) & UPDATE_FIRMWARE_FLAG)) {
@@ -414,8 +1188,18 @@ static void uart_event_task(void *pvParameters) {
 }
 
 static void on_wifi_connected() {
+   boot_profiler_mark(BOOT_PHASE_GOT_IP);
    gpio_set_level(AP_CONNECTION_STATUS_LED_PIN, 1);
    repetitive_ap_connecting_errors_counter_g = 0;
+#ifdef USE_DEEP_SLEEP
+   int rssi;
+
+   // There is no periodic scanning in the deep sleep mode
+   if (wifi_get_access_point(deep_sleep_state_g.access_point_bssid, &deep_sleep_state_g.access_point_channel,
+         &rssi)) {
+      signal_strength_g = rssi;
+   }
+#endif
    send_status_info();
 }
 
@@ -502,19 +1286,98 @@ static void i2c_master_deinit() {
 }
 
 void app_main(void) {
+   boot_profiler_mark(BOOT_PHASE_START);
    general_event_group_g = xEventGroupCreate();
 
+#ifdef USE_CHANGE_DRIVEN_REPORTS
+   report_policy_config_t report_policy_config;
+   report_policy_config.temperature_deadband = REPORT_TEMPERATURE_DEADBAND;
+   report_policy_config.humidity_deadband = REPORT_HUMIDITY_DEADBAND;
+   report_policy_config.light_deadband = REPORT_LIGHT_DEADBAND;
+   report_policy_config.heartbeat_interval_ms = REPORT_HEARTBEAT_INTERVAL_MS;
+   report_policy_init(&report_policy_g, &report_policy_config);
+#endif
+
+#ifdef USE_BINARY_STATUS_PAYLOAD
+   bool templates_compiled = compile_template(STATUS_INFO_BINARY_POST_REQUEST, &status_info_post_request_template_g) &&
+#else
+   bool templates_compiled = compile_template(STATUS_INFO_POST_REQUEST, &status_info_post_request_template_g) &&
+#endif
+         compile_template(STATUS_INFO_REQUEST_PAYLOAD_TEMPLATE, &status_info_request_payload_template_g);
+#if defined(USE_RTC_SAMPLE_BUFFER) && !defined(USE_MQTT) && !defined(USE_UDP_STATUS_REPORTS)
+   templates_compiled = templates_compiled &&
+         compile_template(SAMPLE_BATCH_POST_REQUEST, &sample_batch_post_request_template_g);
+#endif
+   if (!templates_compiled) {
+      // Malformed template or more segments than TEMPLATE_MAX_SEGMENTS with the enabled features
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nRequest templates haven't been compiled\n");
+      #endif
+
+      esp_restart();
+   }
+
+   bool startup_blink = true;
+#ifdef USE_DEEP_SLEEP
+   bool woken_up = deep_sleep_state_load(&deep_sleep_state_g, DEEP_SLEEP_STATE_RTC_ADDRESS) &&
+         esp_reset_reason() == ESP_RST_DEEPSLEEP;
+
+   if (!woken_up) {
+      // E.g. restart on WIFI_REASON_NO_AP_FOUND, the cached access point isn't used
+      deep_sleep_state_g.access_point_channel = 0;
+      // The reset reason of this start has to be reported
+      deep_sleep_state_g.first_report_confirmed = false;
+      deep_sleep_state_g.reset_reason = esp_reset_reason();
+   } else if (deep_sleep_state_g.first_report_confirmed) {
+      // Build timestamp, reset reasons and boot timeline have already been sent after the power on
+      xEventGroupSetBits(general_event_group_g, FIRST_STATUS_INFO_SENT_FLAG);
+   }
+   deep_sleep_state_g.wakes_amount++;
+   // Blinking would take the most of the awake time
+   startup_blink = !woken_up;
+#endif
+
+#ifdef USE_RTC_SAMPLE_BUFFER
+   rtc_sample_buffer_init(&sample_buffer_g, SAMPLE_BUFFER_RTC_ADDRESS, SAMPLE_BUFFER_CAPACITY);
+   // The reset duration is unknown, so the device time continues right after the last buffered sample
+   device_time_base_g = sample_buffer_g.last_time + 1;
+#ifdef USE_DEEP_SLEEP
+   if (woken_up) {
+      device_time_base_g = deep_sleep_state_g.device_time;
+   }
+#endif
+#endif
+
    pins_config();
+   boot_profiler_mark(BOOT_PHASE_PINS);
    //i2c_master_init();
    uart_config();
-
-   start_both_leds_blinking();
-   vTaskDelay(3000 / portTICK_RATE_MS);
-   stop_both_leds_blinking();
+   boot_profiler_mark(BOOT_PHASE_UART);
 
    gpio_set_level(AP_CONNECTION_STATUS_LED_PIN, 0);
    gpio_set_level(SERVER_AVAILABILITY_STATUS_LED_PIN, 0);
 
+   if (startup_blink) {
+      // Doesn't block, Wi-Fi is started meanwhile
+      start_both_leds_blinking();
+      os_timer_setfn(&startup_indication_timer_g, (os_timer_func_t *) stop_startup_indication, NULL);
+      os_timer_arm(&startup_indication_timer_g, STARTUP_INDICATION_DURATION_MS, false);
+   }
+
+   sensor_statistics_init(&temperature_statistics_g, SENSOR_TEMPERATURE_MIN, SENSOR_TEMPERATURE_MAX,
+         SENSOR_TEMPERATURE_SPIKE);
+   sensor_statistics_init(&humidity_statistics_g, SENSOR_HUMIDITY_MIN, SENSOR_HUMIDITY_MAX, SENSOR_HUMIDITY_SPIKE);
+
+#ifdef USE_DEEP_SLEEP
+   // The only sample of the wake
+   bool resolution_set = false;
+   take_sensor_sample(&resolution_set);
+
+   if (woken_up && !is_reporting_wake(deep_sleep_state_g.wakes_amount)) {
+      enter_deep_sleep(false);
+   }
+#endif
+
    #ifdef ALLOW_USE_PRINTF
    const esp_partition_t *running = esp_ota_get_running_partition();
    printf("\nRunning partition type: label: %s, %d, subtype: %d, offset: 0x%X, size: 0x%X\n",
@@ -528,18 +1391,37 @@ void app_main(void) {
    ip_info.gw.addr = inet_addr(OWN_GETAWAY_ADDRESS);
    ip_info.netmask.addr = inet_addr(OWN_NETMASK);
    tcpip_adapter_set_ip_info(TCPIP_ADAPTER_IF_STA, &ip_info);
+   boot_profiler_mark(BOOT_PHASE_TCPIP_ADAPTER);
 
    wirelessNetworkActionsSemaphore_g = xSemaphoreCreateBinary();
    xSemaphoreGive(wirelessNetworkActionsSemaphore_g);
 
+#ifdef USE_DEEP_SLEEP
+   if (deep_sleep_state_g.access_point_channel != 0) {
+      wifi_set_access_point_hint(deep_sleep_state_g.access_point_bssid, deep_sleep_state_g.access_point_channel);
+   }
+#endif
+
    wifi_init_sta(on_wifi_connected, on_wifi_disconnected, blink_on_wifi_connection);
+   boot_profiler_mark(BOOT_PHASE_WIFI_START);
 
+#ifdef USE_DEEP_SLEEP
+   // The status is sent on Wi-Fi connection, then the device goes to sleep
+   os_timer_setfn(&deep_sleep_timer_g, (os_timer_func_t *) on_awake_timeout, NULL);
+   os_timer_arm(&deep_sleep_timer_g, DEEP_SLEEP_MAX_AWAKE_TIME_MS, false);
+#else
+   // The sensor warms up and the first sample is taken while associating
+   xTaskCreate(sensor_sampling_task, SENSOR_SAMPLING_TASK_NAME, configMINIMAL_STACK_SIZE, NULL, 1, NULL);
    xTaskCreate(scan_access_point_task, SCAN_ACCESS_POINT_TASK_NAME, configMINIMAL_STACK_SIZE, NULL, 1, NULL);
+#ifdef USE_MQTT
+   xTaskCreate(mqtt_task, MQTT_TASK_NAME, configMINIMAL_STACK_SIZE * 2, NULL, 1, NULL);
+#endif
 
    os_timer_setfn(&errors_checker_timer_g, (os_timer_func_t *) check_errors_amount, NULL);
    os_timer_arm(&errors_checker_timer_g, ERRORS_CHECKER_INTERVAL_MS, true);
 
    schedule_sending_status_info(STATUS_REQUESTS_SEND_INTERVAL_MS);
+#endif
 
    start_100millisecons_counter();
 }
@@ -17,6 +17,16 @@ static void (*on_wifi_connection)();
 
 static os_timer_t wi_fi_reconnection_timer_g;
 
+// Channel 0 - no hint, all the channels are scanned
+static unsigned char access_point_hint_bssid_g[6];
+static unsigned char access_point_hint_channel_g;
+
+// Kept alive connection to the HTTP server, -1 if there is no one
+static int http_server_socket_id_g = -1;
+static http_connection_statistics_t http_connection_statistics_g;
+// UDP socket connected to the server, -1 if not created yet
+static int udp_socket_id_g = -1;
+
 /**
  * Do not forget to call free() function on returned pointer when it's no longer needed.
  *
@@ -150,7 +160,14 @@ char *put_flash_string_into_heap(const char *flash_string, unsigned int allocate
    return heap_string;
 }
 
+static void reconnect_to_wifi(void *arg) {
+   (void) arg;
+   esp_wifi_connect();
+}
+
 static esp_err_t esp_event_handler(void *ctx, system_event_t *event) {
+   (void) ctx;
+
    switch(event->event_id) {
       case SYSTEM_EVENT_STA_START:
          esp_wifi_connect();
@@ -204,7 +221,7 @@ static esp_err_t esp_event_handler(void *ctx, system_event_t *event) {
          xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT);
 
          os_timer_disarm(&wi_fi_reconnection_timer_g);
-         os_timer_setfn(&wi_fi_reconnection_timer_g, (os_timer_func_t *) esp_wifi_connect, NULL);
+         os_timer_setfn(&wi_fi_reconnection_timer_g, reconnect_to_wifi, NULL);
          os_timer_arm(&wi_fi_reconnection_timer_g, WI_FI_RECONNECTION_INTERVAL_MS, true);
          break;
       default:
@@ -213,6 +230,31 @@ static esp_err_t esp_event_handler(void *ctx, system_event_t *event) {
    return ESP_OK;
 }
 
+/**
+ * Connecting to the known BSSID on the known channel skips the scan of all the channels. Has to be called before
+ * wifi_init_sta().
+ */
+void wifi_set_access_point_hint(const unsigned char bssid[6], unsigned char channel) {
+   memcpy(access_point_hint_bssid_g, bssid, 6);
+   access_point_hint_channel_g = channel;
+}
+
+/**
+ * Returns false if not connected.
+ */
+bool wifi_get_access_point(unsigned char bssid[6], unsigned char *channel, int *rssi) {
+   wifi_ap_record_t access_point;
+
+   if (!is_connected_to_wifi() || esp_wifi_sta_get_ap_info(&access_point) != ESP_OK) {
+      return false;
+   }
+
+   memcpy(bssid, access_point.bssid, 6);
+   *channel = access_point.primary;
+   *rssi = access_point.rssi;
+   return true;
+}
+
 void wifi_init_sta(void (*on_connected)(), void (*on_disconnected)(), void (*on_connection)()) {
    on_wifi_connected = on_connected;
    on_wifi_disconnected = on_disconnected;
@@ -226,9 +268,16 @@ void wifi_init_sta(void (*on_connected)(), void (*on_disconnected)(), void (*on_
    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
    wifi_config_t wifi_config;
+   memset(&wifi_config, 0, sizeof(wifi_config_t));
    memcpy(&wifi_config.sta.ssid, ACCESS_POINT_NAME, 32);
    memcpy(&wifi_config.sta.password, ACCESS_POINT_PASSWORD, 64);
 
+   if (access_point_hint_channel_g != 0) {
+      wifi_config.sta.bssid_set = true;
+      memcpy(wifi_config.sta.bssid, access_point_hint_bssid_g, 6);
+      wifi_config.sta.channel = access_point_hint_channel_g;
+   }
+
    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
    ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
    ESP_ERROR_CHECK(esp_wifi_start());
@@ -239,7 +288,7 @@ void wifi_init_sta(void (*on_connected)(), void (*on_disconnected)(), void (*on_
 }
 
 bool is_connected_to_wifi() {
-   return (xEventGroupGetBits(wifi_event_group) & WIFI_CONNECTED_BIT) == WIFI_CONNECTED_BIT;
+   return (xEventGroupGetBits(wifi_event_group) & WIFI_CONNECTED_BIT) != 0;
 }
 
 /**
@@ -272,7 +321,7 @@ void rtc_mem_read(unsigned int src_block, void *dst, unsigned int length) {
    // copy the data
    for (unsigned int read_bytes = 0; read_bytes < length; read_bytes += 4) {
       uint32_t *ram = (uint32_t *) (dst + read_bytes);
-      uint32_t *rtc = (uint32_t *) (RTC_MEM_BASE + (src_block * 4) + read_bytes);
+      uint32_t *rtc = (uint32_t *) (uintptr_t) (RTC_MEM_BASE + (src_block * 4) + read_bytes);
       *ram = READ_PERI_REG(rtc);
    }
 }
@@ -309,12 +358,12 @@ void rtc_mem_write(unsigned int dst_block, const void *src, unsigned int length)
    // copy the data
    for (unsigned int read_bytes = 0; read_bytes < length; read_bytes += 4) {
       uint32_t *ram = (uint32_t *) (src + read_bytes);
-      uint32_t *rtc = (uint32_t *) (RTC_MEM_BASE + (dst_block * 4) + read_bytes);
+      uint32_t *rtc = (uint32_t *) (uintptr_t) (RTC_MEM_BASE + (dst_block * 4) + read_bytes);
       WRITE_PERI_REG(rtc, *ram);
    }
 }
 
-int connect_to_http_server() {
+int connect_to_server(const char *ip_address, unsigned short port) {
    int socket_id = socket(AF_INET, SOCK_STREAM, IPPROTO_IP); // SOCK_STREAM - TCP
 
    if (socket_id < 0) {
@@ -329,9 +378,9 @@ int connect_to_http_server() {
    #endif
 
    struct sockaddr_in destination_address;
-   destination_address.sin_addr.s_addr = inet_addr(SERVER_IP_ADDRESS);
+   destination_address.sin_addr.s_addr = inet_addr(ip_address);
    destination_address.sin_family = AF_INET;
-   destination_address.sin_port = htons(SERVER_PORT);
+   destination_address.sin_port = htons(port);
 
    int connection_result = connect(socket_id, (struct sockaddr *) &destination_address, sizeof(destination_address));
 
@@ -359,78 +408,379 @@ int connect_to_http_server() {
    return socket_id;
 }
 
-char *send_request(char *request, unsigned short response_buffer_size, unsigned int invocation_time) {
-   int socket_id = connect_to_http_server();
+int connect_to_http_server() {
+   return connect_to_server(SERVER_IP_ADDRESS, SERVER_PORT);
+}
 
-   if (socket_id < 0) {
-      return NULL;
-   }
+static bool is_http_server_connection_alive(int socket_id) {
+   char peeked_byte;
+   int result = recv(socket_id, &peeked_byte, 1, MSG_PEEK | MSG_DONTWAIT);
 
-   unsigned short received_bytes_amount = 0;
-   char *final_response_result = MALLOC(response_buffer_size, invocation_time);
+   // 0 - the connection has been closed by the server, > 0 - unexpected data from the previous response
+   return result < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+}
 
-   int send_result = send(socket_id, request, strlen(request), 0);
+/**
+ * Returns the kept alive connection to the server if it's still open, otherwise connects again.
+ */
+static int get_http_server_connection(bool *reused) {
+   *reused = false;
+
+   if (http_server_socket_id_g >= 0) {
+      if (is_http_server_connection_alive(http_server_socket_id_g)) {
+         *reused = true;
+         http_connection_statistics_g.reused_connections++;
+         return http_server_socket_id_g;
+      }
 
-   if (send_result < 0) {
       #ifdef ALLOW_USE_PRINTF
-      printf("\nError occurred during sending. Error no.: %d\n", send_result);
+      printf("\nSocket %d has been closed by the server\n", http_server_socket_id_g);
       #endif
 
+      close_http_server_connection();
+      http_connection_statistics_g.reconnections++;
+   }
+
+   http_server_socket_id_g = connect_to_http_server();
+
+   if (http_server_socket_id_g >= 0) {
+      // The server doesn't close kept alive connection, so the response without known length mustn't block forever
+      struct timeval receive_timeout;
+      receive_timeout.tv_sec = HTTP_SERVER_RECEIVE_TIMEOUT_MS / 1000;
+      receive_timeout.tv_usec = (HTTP_SERVER_RECEIVE_TIMEOUT_MS % 1000) * 1000;
+      setsockopt(http_server_socket_id_g, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+
+      http_connection_statistics_g.new_connections++;
+   }
+   return http_server_socket_id_g;
+}
+
+void close_http_server_connection() {
+   if (http_server_socket_id_g < 0) {
+      return;
+   }
+
+   shutdown(http_server_socket_id_g, 0);
+   close(http_server_socket_id_g);
+   http_server_socket_id_g = -1;
+}
+
+http_connection_statistics_t get_http_connection_statistics() {
+   return http_connection_statistics_g;
+}
+
+typedef struct {
+   char *buffer;
+   unsigned short buffer_size;
+   unsigned short length;
+} response_body_t;
+
+static void append_response_body(http_response_parser_t *parser, const char *data, size_t length) {
+   response_body_t *response_body = (response_body_t *) parser->context;
+   unsigned short free_space = response_body->buffer_size - 1 - response_body->length;
+
+   // The rest of the long body is still parsed, but not stored
+   if (length > free_space) {
+      length = free_space;
+   }
+
+   memcpy(response_body->buffer + response_body->length, data, length);
+   response_body->length += length;
+}
+
+/**
+ * Reads the response until its end, found by the parser, without waiting for the server to close the connection.
+ * Received chunks are parsed in place, only the body is copied into the returned buffer.
+ *
+ * *keep_alive is set to false if the connection can't be used for the next request. *dropped is set to true if
+ * the server closed or reset the connection before sending any byte of the response.
+ */
+static char *receive_response(int socket_id, unsigned short response_buffer_size, unsigned int invocation_time,
+                              bool *keep_alive, bool *dropped) {
+   char receive_buffer[RESPONSE_RECEIVE_BUFFER_SIZE];
+   http_response_parser_t parser;
+   response_body_t response_body;
+   bool connection_closed = false;
+
+   response_body.buffer = MALLOC(response_buffer_size, invocation_time);
+   response_body.buffer_size = response_buffer_size;
+   response_body.length = 0;
+
+   *dropped = false;
+
+   if (response_body.buffer == NULL) {
+      *keep_alive = false;
       return NULL;
    }
-   #ifdef ALLOW_USE_PRINTF
-   printf("\nRequest has been sent. Socket %d\n", socket_id);
-   #endif
 
-   for (;;) {
-      unsigned char tmp_buffer_size = response_buffer_size <= 255 ? response_buffer_size : 255;
-      char tmp_buffer[tmp_buffer_size];
-      int len = recv(socket_id, tmp_buffer, tmp_buffer_size - 1, 0);
-      tmp_buffer[len] = '\0';
+   http_response_parser_init(&parser, append_response_body, &response_body);
+
+   bool received = false;
+
+   while (!http_response_parser_is_done(&parser) && !http_response_parser_is_error(&parser)) {
+      int len = recv(socket_id, receive_buffer, RESPONSE_RECEIVE_BUFFER_SIZE, 0);
 
       if (len < 0) {
          #ifdef ALLOW_USE_PRINTF
-         printf("\nReceive failed. Error no.: %d\n", len);
+         printf("\nReceive failed. Error no.: %d\n", errno);
          #endif
 
+         // Timeout isn't the drop: the server might be still processing the request
+         *dropped = !received && errno == ECONNRESET;
+         connection_closed = true;
          break;
       } else if (len == 0) {
-         final_response_result[received_bytes_amount] = '\0';
+         *dropped = !received;
+         http_response_parser_finish(&parser);
+         connection_closed = true;
+         break;
+      }
+      received = true;
 
-         #ifdef ALLOW_USE_PRINTF
-         printf("\nFinal response: %s\n", final_response_result);
-         #endif
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nReceived %d bytes\n", len);
+      #endif
 
-         break;
+      size_t parsed_bytes = http_response_parser_execute(&parser, receive_buffer, len);
+
+      if (parsed_bytes < (size_t) len && http_response_parser_is_done(&parser)) {
+         // Not requested data after the response, the connection is out of sync
+         parser.connection_close = true;
+      }
+   }
+
+   response_body.buffer[response_body.length] = '\0';
+   *keep_alive = http_response_parser_is_done(&parser) && !parser.connection_close && !connection_closed;
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("\nStatus code: %u, response: %s\n", parser.status_code, response_body.buffer);
+   #endif
+
+   if (!http_response_parser_is_done(&parser)) {
+      // The response is incomplete or malformed
+      FREE(response_body.buffer);
+      return NULL;
+   }
+   return response_body.buffer;
+}
+
+/**
+ * writev() may write only a part of the fragments (e.g. when the send buffer is full), so it's called again for the
+ * rest. A partly written fragment is finished with write(). Returns -1 on error or when nothing could be written.
+ */
+static int write_all_fragments(int socket_id, const struct iovec fragments[], unsigned char fragments_amount) {
+   unsigned char fragment_index = 0;
+   size_t fragment_offset = 0;
+
+   for (;;) {
+      // Empty fragments are skipped, so the loop ends when everything has been written
+      while (fragment_index < fragments_amount && fragment_offset == fragments[fragment_index].iov_len) {
+         fragment_index++;
+         fragment_offset = 0;
+      }
+      if (fragment_index == fragments_amount) {
+         return 0;
+      }
+
+      int written_bytes;
+
+      if (fragment_offset > 0) {
+         written_bytes = write(socket_id, (const char *) fragments[fragment_index].iov_base + fragment_offset,
+               fragments[fragment_index].iov_len - fragment_offset);
       } else {
-         bool max_length_exceed = false;
+         written_bytes = writev(socket_id, fragments + fragment_index, fragments_amount - fragment_index);
+      }
+
+      if (written_bytes <= 0) {
+         return -1;
+      }
 
-         for (unsigned short i = 0; i < len; i++) {
-            unsigned short addend = received_bytes_amount + i;
+      size_t remaining_bytes = (size_t) written_bytes;
 
-            if (addend >= response_buffer_size) {
-               max_length_exceed = true;
-               received_bytes_amount = response_buffer_size;
-               break;
-            }
+      while (remaining_bytes > 0) {
+         size_t fragment_remaining_bytes = fragments[fragment_index].iov_len - fragment_offset;
 
-            *(final_response_result + addend) = tmp_buffer[i];
+         if (remaining_bytes < fragment_remaining_bytes) {
+            fragment_offset += remaining_bytes;
+            break;
          }
-         received_bytes_amount += max_length_exceed ? 0 : len;
+         remaining_bytes -= fragment_remaining_bytes;
+         fragment_index++;
+         fragment_offset = 0;
+      }
+   }
+}
 
-         #ifdef ALLOW_USE_PRINTF
-         printf("\nReceived %d bytes\n", len);
-         printf("\nResponse: %s\n", tmp_buffer);
-         #endif
+/**
+ * Writes the request into the HTTP server connection. Returns the socket or -1 on failure.
+ */
+static int write_request_fragments(const struct iovec fragments[], unsigned char fragments_amount,
+                                   bool *reused_connection) {
+   int socket_id = get_http_server_connection(reused_connection);
+
+   if (socket_id < 0) {
+      return -1;
+   }
+
+   int send_result = write_all_fragments(socket_id, fragments, fragments_amount);
+
+   if (send_result < 0 && *reused_connection) {
+      // The server could close the connection between the check and sending
+      close_http_server_connection();
+      http_connection_statistics_g.reconnections++;
+      socket_id = get_http_server_connection(reused_connection);
+
+      if (socket_id < 0) {
+         return -1;
       }
+
+      send_result = write_all_fragments(socket_id, fragments, fragments_amount);
    }
 
+   if (send_result < 0) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nError occurred during sending. Error no.: %d\n", errno);
+      #endif
+
+      close_http_server_connection();
+      return -1;
+   }
    #ifdef ALLOW_USE_PRINTF
-   printf("Shutting down socket and restarting...\n");
+   printf("\nRequest has been sent. Socket %d\n", socket_id);
    #endif
 
-   shutdown(socket_id, 0);
-   close(socket_id);
+   return socket_id;
+}
+
+/**
+ * Sends the request consisting of several fragments (e.g. headers and body) with writev(), so fragments don't need
+ * to be concatenated into one buffer.
+ *
+ * Do not forget to call free() function on returned pointer when it's no longer needed.
+ */
+char *send_request_fragments(const struct iovec fragments[], unsigned char fragments_amount,
+                             unsigned short response_buffer_size, unsigned int invocation_time) {
+   bool reused_connection;
+   int socket_id = write_request_fragments(fragments, fragments_amount, &reused_connection);
+
+   if (socket_id < 0) {
+      return NULL;
+   }
+
+   bool keep_alive;
+   bool dropped;
+   char *final_response_result = receive_response(socket_id, response_buffer_size, invocation_time, &keep_alive,
+                                                  &dropped);
+
+   if (dropped && reused_connection) {
+      // The server closed the idle connection when the request was on the way, so the request hasn't been processed
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nSocket %d has been dropped by the server, sending again\n", socket_id);
+      #endif
+
+      close_http_server_connection();
+      http_connection_statistics_g.reconnections++;
+      socket_id = write_request_fragments(fragments, fragments_amount, &reused_connection);
+
+      if (socket_id < 0) {
+         return NULL;
+      }
+
+      final_response_result = receive_response(socket_id, response_buffer_size, invocation_time, &keep_alive,
+                                                &dropped);
+   }
+
+   if (!keep_alive) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("Shutting down socket...\n");
+      #endif
+
+      close_http_server_connection();
+   }
+
+   #ifdef ALLOW_USE_PRINTF
+   printf("Connections. New: %u, reused: %u, reconnections: %u\n", http_connection_statistics_g.new_connections,
+         http_connection_statistics_g.reused_connections, http_connection_statistics_g.reconnections);
+   #endif
 
    return final_response_result;
 }
+
+char *send_request(char *request, unsigned short response_buffer_size, unsigned int invocation_time) {
+   struct iovec fragment;
+   fragment.iov_base = request;
+   fragment.iov_len = strlen(request);
+
+   return send_request_fragments(&fragment, 1, response_buffer_size, invocation_time);
+}
+
+static int get_udp_socket() {
+   if (udp_socket_id_g >= 0) {
+      return udp_socket_id_g;
+   }
+
+   int socket_id = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+
+   if (socket_id < 0) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nFailed to allocate UDP socket\n");
+      #endif
+
+      return -1;
+   }
+
+   struct sockaddr_in destination_address;
+   destination_address.sin_addr.s_addr = inet_addr(SERVER_IP_ADDRESS);
+   destination_address.sin_family = AF_INET;
+   destination_address.sin_port = htons(SERVER_UDP_PORT);
+
+   // Connected UDP socket receives datagrams only from the server
+   if (connect(socket_id, (struct sockaddr *) &destination_address, sizeof(destination_address)) != 0) {
+      close(socket_id);
+      return -1;
+   }
+
+   udp_socket_id_g = socket_id;
+   return udp_socket_id_g;
+}
+
+/**
+ * Sends the datagram to SERVER_IP_ADDRESS:SERVER_UDP_PORT and waits up to reply_timeout_ms for the optional reply.
+ *
+ * Returns the reply length, 0 if there was no reply or -1 if the datagram hasn't been sent.
+ */
+int send_datagram(const unsigned char *datagram, unsigned short datagram_length, unsigned char *reply,
+                  unsigned short reply_size, unsigned int reply_timeout_ms) {
+   if (!is_connected_to_wifi()) {
+      return -1;
+   }
+
+   int socket_id = get_udp_socket();
+
+   if (socket_id < 0) {
+      return -1;
+   }
+
+   if (send(socket_id, datagram, datagram_length, 0) < 0) {
+      #ifdef ALLOW_USE_PRINTF
+      printf("\nError occurred during datagram sending. Error no.: %d\n", errno);
+      #endif
+
+      close(udp_socket_id_g);
+      udp_socket_id_g = -1;
+      return -1;
+   }
+
+   if (reply_size == 0 || reply_timeout_ms == 0) {
+      return 0;
+   }
+
+   struct timeval receive_timeout;
+   receive_timeout.tv_sec = reply_timeout_ms / 1000;
+   receive_timeout.tv_usec = (reply_timeout_ms % 1000) * 1000;
+   setsockopt(socket_id, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+
+   int reply_length = recv(socket_id, reply, reply_size, 0);
+
+   return reply_length < 0 ? 0 : reply_length;
+}
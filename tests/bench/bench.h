@@ -0,0 +1,38 @@
+#include <stddef.h>
+
+#ifndef BENCH_HEADER
+#define BENCH_HEADER
+
+/**
+ * Operation under the benchmark, called "iterations" times in a row
+ */
+typedef void (*bench_operation_t)(void *context, unsigned int iterations);
+
+typedef struct {
+   char name[64];
+   unsigned long long iterations;
+   double ns_per_op;
+   double allocations_per_op;
+   double bytes_allocated_per_op;
+   // Processed bytes per second, 0 if the operation has no input size
+   double throughput_mb_per_s;
+} bench_result_t;
+
+/**
+ * Runs the operation until at least BENCH_MIN_TIME_NS has passed. bytes_per_op is the processed input size for the
+ * throughput, heap usage is counted by the os_malloc() shim.
+ */
+void bench_run(const char *name, bench_operation_t operation, void *context, size_t bytes_per_op);
+// Keeps the result of the operation, so the compiler can't remove it
+void bench_consume(const void *pointer);
+void bench_consume_value(unsigned int value);
+
+// Suites, see bench_main.c
+void bench_strings();
+void bench_http_response_parser();
+void bench_sht21();
+void bench_ota_parser();
+void bench_number_formatter();
+void bench_ota_update();
+
+#endif
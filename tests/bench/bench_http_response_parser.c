@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "http_response_parser.h"
+#include "bench.h"
+
+#define LARGE_BODY_LENGTH 4096
+
+typedef struct {
+   char *response;
+   size_t response_length;
+   // recv() sizes the response is split into
+   size_t chunk_size;
+   size_t expected_body_length;
+   size_t body_length;
+} response_context_t;
+
+static void on_body(http_response_parser_t *parser, const char *data, size_t length) {
+   response_context_t *context = parser->context;
+
+   context->body_length += length;
+   bench_consume(data);
+}
+
+/**
+ * The status server reply: small JSON body with Content-Length
+ */
+static void init_status_response(response_context_t *context, size_t chunk_size) {
+   static const char BODY[] = "{\"statusCode\":\"OK\",\"updateFirmware\":false}";
+
+   context->response = malloc(512);
+   context->response_length = sprintf(context->response, "HTTP/1.1 200 OK\r\nServer: nginx\r\nDate: Sat, 17 Oct "
+         "2026 10:00:00 GMT\r\nContent-Type: application/json;charset=UTF-8\r\nContent-Length: %zu\r\n"
+         "Connection: keep-alive\r\n\r\n%s", sizeof(BODY) - 1, BODY);
+   context->chunk_size = chunk_size;
+   context->expected_body_length = sizeof(BODY) - 1;
+}
+
+/**
+ * Larger body sent with the chunked transfer coding, 1460 bytes per chunk
+ */
+static void init_chunked_response(response_context_t *context, size_t chunk_size) {
+   context->response = malloc(LARGE_BODY_LENGTH * 2);
+   context->response_length = sprintf(context->response, "HTTP/1.1 200 OK\r\nServer: nginx\r\nContent-Type: "
+         "application/json\r\nTransfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n");
+
+   for (size_t offset = 0; offset < LARGE_BODY_LENGTH;) {
+      size_t length = LARGE_BODY_LENGTH - offset < 1460 ? LARGE_BODY_LENGTH - offset : 1460;
+
+      context->response_length += sprintf(context->response + context->response_length, "%zx\r\n", length);
+      memset(context->response + context->response_length, 'a' + offset % 26, length);
+      context->response_length += length;
+      memcpy(context->response + context->response_length, "\r\n", 2);
+      context->response_length += 2;
+      offset += length;
+   }
+   memcpy(context->response + context->response_length, "0\r\n\r\n", 5);
+   context->response_length += 5;
+   context->chunk_size = chunk_size;
+   context->expected_body_length = LARGE_BODY_LENGTH;
+}
+
+static void run_parser(void *context, unsigned int iterations) {
+   response_context_t *response_context = context;
+   http_response_parser_t parser;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      http_response_parser_init(&parser, on_body, response_context);
+      response_context->body_length = 0;
+
+      for (size_t offset = 0; offset < response_context->response_length; offset += response_context->chunk_size) {
+         size_t length = response_context->response_length - offset < response_context->chunk_size ?
+               response_context->response_length - offset : response_context->chunk_size;
+
+         http_response_parser_execute(&parser, response_context->response + offset, length);
+      }
+      if (!http_response_parser_is_done(&parser) ||
+            response_context->body_length != response_context->expected_body_length) {
+         fprintf(stderr, "Response isn't parsed\n");
+         exit(1);
+      }
+   }
+}
+
+void bench_http_response_parser() {
+   static const size_t CHUNK_SIZES[] = {1, 64, 536, 1460};
+   char name[64];
+
+   for (unsigned int chunked = 0; chunked < 2; chunked++) {
+      for (unsigned int i = 0; i < sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]); i++) {
+         response_context_t context;
+
+         if (chunked) {
+            init_chunked_response(&context, CHUNK_SIZES[i]);
+         } else {
+            init_status_response(&context, CHUNK_SIZES[i]);
+         }
+         snprintf(name, sizeof(name), "http_response_parser/%s/recv=%zu", chunked ? "chunked" : "status",
+               CHUNK_SIZES[i]);
+         bench_run(name, run_parser, &context, context.response_length);
+         free(context.response);
+      }
+   }
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_shims.h"
+#include "bench.h"
+
+#define BENCH_MIN_TIME_NS  200000000ULL
+#define BENCH_MAX_RESULTS  64
+
+typedef void (*bench_suite_t)();
+
+// bench_runner_compressed is built with the compressed image update only
+static const bench_suite_t SUITES[] = {
+   #ifdef USE_COMPRESSED_FIRMWARE
+   bench_ota_update
+   #else
+   bench_strings,
+   bench_http_response_parser,
+   bench_sht21,
+   bench_ota_parser,
+   bench_number_formatter,
+   bench_ota_update
+   #endif
+};
+static bench_result_t results_g[BENCH_MAX_RESULTS];
+static unsigned int results_amount_g;
+static volatile unsigned int sink_g;
+
+void bench_consume(const void *pointer) {
+   sink_g += (unsigned int) (size_t) pointer;
+}
+
+void bench_consume_value(unsigned int value) {
+   sink_g += value;
+}
+
+static unsigned long long get_time_ns() {
+   struct timespec time;
+
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return (unsigned long long) time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+void bench_run(const char *name, bench_operation_t operation, void *context, size_t bytes_per_op) {
+   unsigned long long iterations = 1;
+   unsigned long long elapsed_ns;
+   shim_heap_statistics_t heap_statistics;
+
+   // Warm up
+   operation(context, 1);
+
+   for (;;) {
+      shim_reset_heap_statistics();
+      unsigned long long start_ns = get_time_ns();
+
+      operation(context, iterations);
+      elapsed_ns = get_time_ns() - start_ns;
+      heap_statistics = shim_get_heap_statistics();
+
+      if (elapsed_ns >= BENCH_MIN_TIME_NS) {
+         break;
+      }
+      // Aiming at 1.2 of the minimal time
+      unsigned long long required_iterations = elapsed_ns == 0 ? iterations * 100 :
+            iterations * BENCH_MIN_TIME_NS * 12 / 10 / elapsed_ns;
+
+      iterations = required_iterations > iterations * 100 ? iterations * 100 :
+            required_iterations <= iterations ? iterations + 1 : required_iterations;
+   }
+
+   if (results_amount_g >= BENCH_MAX_RESULTS) {
+      fprintf(stderr, "Too many benchmarks, %s is skipped\n", name);
+      return;
+   }
+
+   bench_result_t *result = &results_g[results_amount_g++];
+
+   snprintf(result->name, sizeof(result->name), "%s", name);
+   result->iterations = iterations;
+   result->ns_per_op = (double) elapsed_ns / iterations;
+   result->allocations_per_op = (double) heap_statistics.allocations / iterations;
+   result->bytes_allocated_per_op = (double) heap_statistics.allocated_bytes / iterations;
+   result->throughput_mb_per_s = bytes_per_op == 0 ? 0 : bytes_per_op * 1000.0 / result->ns_per_op;
+
+   printf("%-48s %12.1f ns/op %8.2f allocs/op %10.1f B/op", result->name, result->ns_per_op,
+         result->allocations_per_op, result->bytes_allocated_per_op);
+   if (bytes_per_op > 0) {
+      printf(" %10.2f MB/s", result->throughput_mb_per_s);
+   }
+   printf("\n");
+}
+
+static bool write_results(const char *file_name) {
+   FILE *file = fopen(file_name, "w");
+
+   if (file == NULL) {
+      return false;
+   }
+
+   fprintf(file, "{\n  \"benchmarks\": [\n");
+   for (unsigned int i = 0; i < results_amount_g; i++) {
+      const bench_result_t *result = &results_g[i];
+
+      fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"allocations_per_op\": %.3f, "
+            "\"bytes_allocated_per_op\": %.3f, \"throughput_mb_per_s\": %.3f}%s\n", result->name, result->iterations,
+            result->ns_per_op, result->allocations_per_op, result->bytes_allocated_per_op,
+            result->throughput_mb_per_s, i + 1 < results_amount_g ? "," : "");
+   }
+   fprintf(file, "  ]\n}\n");
+   return fclose(file) == 0;
+}
+
+/**
+ * Usage: bench_runner [results file]
+ * Results are written as JSON, so they can be compared between builds.
+ */
+int main(int argc, char *argv[]) {
+   const char *file_name = argc > 1 ? argv[1] : "bench_results.json";
+
+   for (unsigned int i = 0; i < sizeof(SUITES) / sizeof(SUITES[0]); i++) {
+      SUITES[i]();
+   }
+
+   if (!write_results(file_name)) {
+      fprintf(stderr, "Results can't be written into %s\n", file_name);
+      return 1;
+   }
+   printf("Results: %s\n", file_name);
+   return 0;
+}
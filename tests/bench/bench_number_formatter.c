@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include "number_formatter.h"
+#include "bench.h"
+
+#define VALUES_AMOUNT 64
+
+typedef struct {
+   int values[VALUES_AMOUNT];
+} values_context_t;
+
+static void run_format_unsigned(void *context, unsigned int iterations) {
+   values_context_t *values_context = context;
+   char buffer[16];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(format_unsigned(buffer, sizeof(buffer), values_context->values[i % VALUES_AMOUNT]));
+   }
+}
+
+static void run_snprintf_unsigned(void *context, unsigned int iterations) {
+   values_context_t *values_context = context;
+   char buffer[16];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(snprintf(buffer, sizeof(buffer), "%u", values_context->values[i % VALUES_AMOUNT]));
+   }
+}
+
+static void run_format_fixed_point(void *context, unsigned int iterations) {
+   values_context_t *values_context = context;
+   char buffer[16];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(format_fixed_point(buffer, sizeof(buffer), values_context->values[i % VALUES_AMOUNT], 2));
+   }
+}
+
+/**
+ * What the firmware used to do with the temperature: float division and "%.2f"
+ */
+static void run_snprintf_float(void *context, unsigned int iterations) {
+   values_context_t *values_context = context;
+   char buffer[16];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(snprintf(buffer, sizeof(buffer), "%.2f", values_context->values[i % VALUES_AMOUNT] / 100.0f));
+   }
+}
+
+void bench_number_formatter() {
+   values_context_t uptime_values;
+   values_context_t temperature_values;
+
+   for (unsigned int i = 0; i < VALUES_AMOUNT; i++) {
+      // Uptime seconds and free heap sizes
+      uptime_values.values[i] = i % 2 ? 38000 + i * 37 : i * 104729;
+      // Centidegrees from -40.00 to 80.00
+      temperature_values.values[i] = -4000 + i * 1904;
+   }
+
+   bench_run("format_unsigned", run_format_unsigned, &uptime_values, 0);
+   bench_run("snprintf/unsigned", run_snprintf_unsigned, &uptime_values, 0);
+   bench_run("format_fixed_point/fraction_digits=2", run_format_fixed_point, &temperature_values, 0);
+   bench_run("snprintf/float_2_digits", run_snprintf_float, &temperature_values, 0);
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "http_response_parser.h"
+#include "mbedtls/sha256.h"
+#include "bench.h"
+
+#define FIRMWARE_LENGTH (64 * 1024)
+
+typedef struct {
+   char *response;
+   size_t response_length;
+   // recv() sizes the response is split into
+   size_t chunk_size;
+   size_t body_length;
+   // The body is hashed as in the OTA receive loop, NULL - not hashed
+   mbedtls_sha256_context *sha256_context;
+} ota_response_context_t;
+
+typedef struct {
+   unsigned char *data;
+   size_t update_size;
+} sha256_context_t;
+
+static void on_body(http_response_parser_t *parser, const char *data, size_t length) {
+   ota_response_context_t *context = parser->context;
+
+   context->body_length += length;
+   if (context->sha256_context != NULL) {
+      mbedtls_sha256_update_ret(context->sha256_context, (const unsigned char *) data, length);
+   }
+}
+
+/**
+ * The firmware response as it's sent by the server, chunked or with Content-Length
+ */
+static void init_response(ota_response_context_t *context, bool chunked, size_t chunk_size) {
+   static const char SHA256[] = "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08";
+   char headers[512];
+   size_t headers_length = sprintf(headers, "HTTP/1.1 200 OK\r\nServer: nginx\r\nContent-Type: "
+         "application/octet-stream\r\n%s\r\nETag: \"5f3c-1d2e\"\r\nX-Firmware-SHA256: %s\r\nConnection: close\r\n\r\n",
+         chunked ? "Transfer-Encoding: chunked" : "Content-Length: 65536", SHA256);
+
+   context->response = malloc(headers_length + FIRMWARE_LENGTH * 2);
+   memcpy(context->response, headers, headers_length);
+   context->response_length = headers_length;
+   context->chunk_size = chunk_size;
+   context->sha256_context = NULL;
+
+   for (size_t offset = 0; offset < FIRMWARE_LENGTH;) {
+      size_t length = chunked ? 1460 : FIRMWARE_LENGTH;
+
+      if (length > FIRMWARE_LENGTH - offset) {
+         length = FIRMWARE_LENGTH - offset;
+      }
+      if (chunked) {
+         context->response_length += sprintf(context->response + context->response_length, "%zx\r\n", length);
+      }
+      for (size_t i = 0; i < length; i++) {
+         context->response[context->response_length + i] = (char) ((offset + i) * 31 + 7);
+      }
+      context->response_length += length;
+      offset += length;
+      if (chunked) {
+         memcpy(context->response + context->response_length, "\r\n", 2);
+         context->response_length += 2;
+      }
+   }
+   if (chunked) {
+      memcpy(context->response + context->response_length, "0\r\n\r\n", 5);
+      context->response_length += 5;
+   }
+}
+
+static void run_parser(void *context, unsigned int iterations) {
+   ota_response_context_t *response_context = context;
+   http_response_parser_t parser;
+   unsigned char sha256[HTTP_RESPONSE_PARSER_SHA256_SIZE];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      http_response_parser_init(&parser, on_body, response_context);
+      response_context->body_length = 0;
+      if (response_context->sha256_context != NULL) {
+         mbedtls_sha256_init(response_context->sha256_context);
+         mbedtls_sha256_starts_ret(response_context->sha256_context, 0);
+      }
+
+      for (size_t offset = 0; offset < response_context->response_length; offset += response_context->chunk_size) {
+         size_t length = response_context->response_length - offset < response_context->chunk_size ?
+               response_context->response_length - offset : response_context->chunk_size;
+
+         http_response_parser_execute(&parser, response_context->response + offset, length);
+      }
+      if (!http_response_parser_is_done(&parser) || response_context->body_length != FIRMWARE_LENGTH) {
+         fprintf(stderr, "Firmware response isn't parsed\n");
+         exit(1);
+      }
+      if (response_context->sha256_context != NULL) {
+         mbedtls_sha256_finish_ret(response_context->sha256_context, sha256);
+         mbedtls_sha256_free(response_context->sha256_context);
+         bench_consume_value(sha256[0]);
+      }
+   }
+}
+
+static void run_sha256(void *context, unsigned int iterations) {
+   sha256_context_t *data_context = context;
+   mbedtls_sha256_context sha256_context;
+   unsigned char sha256[HTTP_RESPONSE_PARSER_SHA256_SIZE];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      mbedtls_sha256_init(&sha256_context);
+      mbedtls_sha256_starts_ret(&sha256_context, 0);
+      for (size_t offset = 0; offset < FIRMWARE_LENGTH; offset += data_context->update_size) {
+         mbedtls_sha256_update_ret(&sha256_context, data_context->data + offset, data_context->update_size);
+      }
+      mbedtls_sha256_finish_ret(&sha256_context, sha256);
+      mbedtls_sha256_free(&sha256_context);
+      bench_consume_value(sha256[0]);
+   }
+}
+
+void bench_ota_parser() {
+   static const size_t CHUNK_SIZES[] = {64, 536, 1024, 1460};
+   // Divisors of FIRMWARE_LENGTH
+   static const size_t SHA256_UPDATE_SIZES[] = {64, 512, 1024};
+   char name[64];
+
+   for (unsigned int chunked = 0; chunked < 2; chunked++) {
+      for (unsigned int i = 0; i < sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]); i++) {
+         ota_response_context_t context;
+
+         init_response(&context, chunked, CHUNK_SIZES[i]);
+         snprintf(name, sizeof(name), "ota_response_parser/%s/recv=%zu", chunked ? "chunked" : "content_length",
+               CHUNK_SIZES[i]);
+         bench_run(name, run_parser, &context, context.response_length);
+
+         // Cost of the digest check in the receive loop
+         if (!chunked) {
+            mbedtls_sha256_context sha256_context;
+
+            context.sha256_context = &sha256_context;
+            snprintf(name, sizeof(name), "ota_response_parser+sha256/content_length/recv=%zu", CHUNK_SIZES[i]);
+            bench_run(name, run_parser, &context, context.response_length);
+         }
+         free(context.response);
+      }
+   }
+
+   sha256_context_t sha256_context = {malloc(FIRMWARE_LENGTH), 0};
+
+   for (size_t i = 0; i < FIRMWARE_LENGTH; i++) {
+      sha256_context.data[i] = (unsigned char) (i * 31 + 7);
+   }
+   for (unsigned int i = 0; i < sizeof(SHA256_UPDATE_SIZES) / sizeof(SHA256_UPDATE_SIZES[0]); i++) {
+      sha256_context.update_size = SHA256_UPDATE_SIZES[i];
+      snprintf(name, sizeof(name), "sha256/update=%zu", SHA256_UPDATE_SIZES[i]);
+      bench_run(name, run_sha256, &sha256_context, FIRMWARE_LENGTH);
+   }
+   free(sha256_context.data);
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ota.h"
+#include "firmware_server.h"
+#include "host_shims.h"
+#include "lzss_encoder.h"
+#include "bench.h"
+
+#define IMAGE_LENGTH (256 * 1024)
+
+static void on_wifi_event() {
+}
+
+static void run_update(void *context, unsigned int iterations) {
+   unsigned int *updates_amount = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      update_firmware();
+      shim_wait_for_tasks();
+   }
+   *updates_amount += iterations;
+}
+
+/**
+ * The whole update over the loopback: receiving, parsing, hashing and writing into the file backed partition, so
+ * the throughput includes the socket and the flash shim too. With USE_COMPRESSED_FIRMWARE (bench_runner_compressed)
+ * the LZS1 packed image is downloaded and decoded. The heap isn't freed until the end of the update, so the allocated
+ * bytes per update are its peak heap usage.
+ */
+void bench_ota_update() {
+   static const size_t WRITE_SIZES[] = {0, 1460};
+   unsigned char *image = malloc(IMAGE_LENGTH);
+   local_server_t server;
+   firmware_server_t firmware_server;
+   char name[64];
+   unsigned int updates_amount = 0;
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   // Compresses about as well as the firmware: half of every sector is repetitive
+   srand(1);
+   for (unsigned int i = 0; i < IMAGE_LENGTH; i++) {
+      image[i] = (i / 2048) % 2 ? rand() : (unsigned char) (i / 16);
+   }
+
+   #ifdef USE_COMPRESSED_FIRMWARE
+   unsigned char *file = malloc(LZSS_ENCODED_BOUND(IMAGE_LENGTH));
+   size_t file_length = lzss_encode(image, IMAGE_LENGTH, file);
+   const char *name_prefix = "ota_update_compressed";
+   #else
+   unsigned char *file = image;
+   size_t file_length = IMAGE_LENGTH;
+   const char *name_prefix = "ota_update";
+   #endif
+
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+   firmware_server_init(&firmware_server, file, file_length, image, IMAGE_LENGTH);
+   if (!local_server_start(&server, firmware_server_respond, &firmware_server)) {
+      if (file != image) {
+         free(file);
+      }
+      free(image);
+      return;
+   }
+   shim_server_port = server.port;
+   shim_partition_reset(2 * IMAGE_LENGTH);
+
+   for (unsigned int chunked = 0; chunked <= 1; chunked++) {
+      for (unsigned int i = 0; i < sizeof(WRITE_SIZES) / sizeof(WRITE_SIZES[0]); i++) {
+         firmware_server.chunked = chunked;
+         firmware_server.write_size = WRITE_SIZES[i];
+         snprintf(name, sizeof(name), "%s/%s/send=%zu", name_prefix, chunked ? "chunked" : "content_length",
+               WRITE_SIZES[i]);
+         bench_run(name, run_update, &updates_amount, IMAGE_LENGTH);
+      }
+   }
+
+   // Every successful update restarts
+   if (shim_get_restarts_amount() - restarts_amount != updates_amount) {
+      fprintf(stderr, "ota_update: %u of %u updates failed\n",
+            updates_amount - (shim_get_restarts_amount() - restarts_amount), updates_amount);
+   }
+
+   local_server_stop(&server);
+   if (file != image) {
+      free(file);
+   }
+   free(image);
+}
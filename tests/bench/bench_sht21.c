@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include "host_shims.h"
+#include "bench.h"
+// Conversions are static, so they are benchmarked in this translation unit
+#include "../../components/sht21/sht21.c"
+
+#define RAW_VALUES_AMOUNT 256
+
+typedef struct {
+   unsigned short raw_values[RAW_VALUES_AMOUNT];
+   unsigned char checksums[RAW_VALUES_AMOUNT];
+} raw_data_context_t;
+
+/**
+ * Fixed measurements over the whole range, status bit 1 is set for humidity
+ */
+static void init_raw_data(raw_data_context_t *context, bool humidity) {
+   for (unsigned int i = 0; i < RAW_VALUES_AMOUNT; i++) {
+      unsigned short raw_value = (unsigned short) ((i * 0x0101 + 0x40) & 0xFFFC) | (humidity ? 0x2 : 0);
+
+      context->raw_values[i] = raw_value;
+      context->checksums[i] = sht21_calculate_crc(raw_value);
+   }
+}
+
+static void run_crc(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(sht21_calculate_crc(raw_data->raw_values[i % RAW_VALUES_AMOUNT]));
+   }
+}
+
+static void run_crc_bitwise(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      unsigned short raw_value = raw_data->raw_values[i % RAW_VALUES_AMOUNT];
+      unsigned char frame[2] = {raw_value >> 8, raw_value & 0xFF};
+
+      bench_consume_value(shim_sht21_reference_crc8(frame, sizeof(frame)));
+   }
+}
+
+static void run_crc8(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(sht21_calculate_crc8((const unsigned char *) raw_data->raw_values,
+            sizeof(raw_data->raw_values)));
+   }
+}
+
+static void run_temperature(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      unsigned int index = i % RAW_VALUES_AMOUNT;
+      float temperature = sht21_calculate_temperature(raw_data->raw_values[index], raw_data->checksums[index]);
+
+      bench_consume_value((unsigned int) temperature);
+   }
+}
+
+static void run_temperature_centi(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      unsigned int index = i % RAW_VALUES_AMOUNT;
+
+      bench_consume_value(sht21_calculate_temperature_centi(raw_data->raw_values[index], raw_data->checksums[index]));
+   }
+}
+
+static void run_humidity(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      unsigned int index = i % RAW_VALUES_AMOUNT;
+      float humidity = sht21_calculate_humidity(raw_data->raw_values[index], raw_data->checksums[index]);
+
+      bench_consume_value((unsigned int) humidity);
+   }
+}
+
+static void run_humidity_centi(void *context, unsigned int iterations) {
+   raw_data_context_t *raw_data = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      unsigned int index = i % RAW_VALUES_AMOUNT;
+
+      bench_consume_value(sht21_calculate_humidity_centi(raw_data->raw_values[index], raw_data->checksums[index]));
+   }
+}
+
+void bench_sht21() {
+   raw_data_context_t temperature_data;
+   raw_data_context_t humidity_data;
+
+   init_raw_data(&temperature_data, false);
+   init_raw_data(&humidity_data, true);
+
+   bench_run("sht21_calculate_crc", run_crc, &temperature_data, 2);
+   // The bit by bit CRC, which the table has replaced
+   bench_run("sht21_crc_bitwise", run_crc_bitwise, &temperature_data, 2);
+   bench_run("sht21_calculate_crc8/length=512", run_crc8, &temperature_data, sizeof(temperature_data.raw_values));
+   bench_run("sht21_calculate_temperature", run_temperature, &temperature_data, 0);
+   bench_run("sht21_calculate_temperature_centi", run_temperature_centi, &temperature_data, 0);
+   bench_run("sht21_calculate_humidity", run_humidity, &humidity_data, 0);
+   bench_run("sht21_calculate_humidity_centi", run_humidity_centi, &humidity_data, 0);
+}
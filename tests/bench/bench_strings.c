@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_libc.h"
+#include "template_renderer.h"
+#include "utils.h"
+#include "bench.h"
+
+#define MAX_PARAMETERS_AMOUNT 24
+
+typedef struct {
+   char template[1024];
+   char parameter_values[MAX_PARAMETERS_AMOUNT][16];
+   const char *parameters[MAX_PARAMETERS_AMOUNT + 1];
+   size_t rendered_length;
+   compiled_template_t compiled_template;
+} template_context_t;
+
+typedef struct {
+   char *string1;
+   char *string2;
+} compare_context_t;
+
+/**
+ * JSON like template: {"field1":"<1>",...}, literal_length characters of the literal text per parameter
+ */
+static void init_template_context(template_context_t *context, unsigned int parameters_amount,
+                                  unsigned int literal_length) {
+   size_t length = 0;
+
+   memset(context, 0, sizeof(template_context_t));
+   for (unsigned int i = 0; i < parameters_amount; i++) {
+      length += sprintf(context->template + length, "\"%.*s\":<%u>,", literal_length - 4,
+            "abcdefghijklmnopqrstuvwxyz0123456789", i + 1);
+      sprintf(context->parameter_values[i], "%u", 1000000 + i * 7919);
+      context->parameters[i] = context->parameter_values[i];
+   }
+   context->parameters[parameters_amount] = NULL;
+
+   char *rendered = set_string_parameters(context->template, context->parameters);
+
+   context->rendered_length = strlen(rendered);
+   free(rendered);
+
+   compile_template(context->template, &context->compiled_template);
+}
+
+static void run_set_string_parameters(void *context, unsigned int iterations) {
+   template_context_t *template_context = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      char *rendered = set_string_parameters(template_context->template, template_context->parameters);
+
+      bench_consume(rendered);
+      free(rendered);
+   }
+}
+
+static void run_compile_template(void *context, unsigned int iterations) {
+   template_context_t *template_context = context;
+   compiled_template_t compiled_template;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(compile_template(template_context->template, &compiled_template));
+   }
+}
+
+/**
+ * The same steps as the status request payload in user_main.c: length, allocation and rendering
+ */
+static void run_render_template(void *context, unsigned int iterations) {
+   template_context_t *template_context = context;
+   unsigned short parameters_lengths[TEMPLATE_MAX_PARAMETERS];
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      unsigned short length = get_rendered_template_length(&template_context->compiled_template,
+            template_context->parameters, parameters_lengths);
+      char *rendered = os_malloc(length + 1);
+
+      render_template(&template_context->compiled_template, template_context->parameters, parameters_lengths, rendered,
+            length + 1);
+      bench_consume(rendered);
+      os_free(rendered);
+   }
+}
+
+static void run_compare_strings(void *context, unsigned int iterations) {
+   compare_context_t *compare_context = context;
+
+   for (unsigned int i = 0; i < iterations; i++) {
+      bench_consume_value(compare_strings(compare_context->string1, compare_context->string2));
+   }
+}
+
+static void run_put_flash_string_into_heap(void *context, unsigned int iterations) {
+   for (unsigned int i = 0; i < iterations; i++) {
+      char *heap_string = put_flash_string_into_heap(context, 0);
+
+      bench_consume(heap_string);
+      free(heap_string);
+   }
+}
+
+void bench_strings() {
+   static const unsigned int PARAMETERS_AMOUNTS[] = {2, 8, 24};
+   static const unsigned int STRING_LENGTHS[] = {16, 256};
+   template_context_t template_context;
+   char name[64];
+
+   for (unsigned int i = 0; i < sizeof(PARAMETERS_AMOUNTS) / sizeof(PARAMETERS_AMOUNTS[0]); i++) {
+      init_template_context(&template_context, PARAMETERS_AMOUNTS[i], 24);
+      snprintf(name, sizeof(name), "set_string_parameters/params=%u/length=%zu", PARAMETERS_AMOUNTS[i],
+            template_context.rendered_length);
+      bench_run(name, run_set_string_parameters, &template_context, template_context.rendered_length);
+      snprintf(name, sizeof(name), "render_template/params=%u/length=%zu", PARAMETERS_AMOUNTS[i],
+            template_context.rendered_length);
+      bench_run(name, run_render_template, &template_context, template_context.rendered_length);
+      snprintf(name, sizeof(name), "compile_template/params=%u", PARAMETERS_AMOUNTS[i]);
+      bench_run(name, run_compile_template, &template_context, strlen(template_context.template));
+   }
+
+   for (unsigned int i = 0; i < sizeof(STRING_LENGTHS) / sizeof(STRING_LENGTHS[0]); i++) {
+      unsigned int length = STRING_LENGTHS[i];
+      char *string1 = malloc(length + 1);
+      char *string2 = malloc(length + 1);
+      compare_context_t compare_context = {string1, string2};
+
+      memset(string1, 'a', length);
+      memset(string2, 'a', length);
+      string1[length] = '\0';
+      string2[length] = '\0';
+
+      snprintf(name, sizeof(name), "compare_strings/equal/length=%u", length);
+      bench_run(name, run_compare_strings, &compare_context, length);
+
+      // Typical response check: the difference is found in the first characters
+      string2[1] = 'b';
+      snprintf(name, sizeof(name), "compare_strings/different/length=%u", length);
+      bench_run(name, run_compare_strings, &compare_context, 2);
+
+      snprintf(name, sizeof(name), "put_flash_string_into_heap/length=%u", length);
+      bench_run(name, run_put_flash_string_into_heap, string1, length);
+
+      free(string1);
+      free(string2);
+   }
+}
@@ -0,0 +1,150 @@
+#include <pthread.h>
+#include <sched.h>
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "host_shims.h"
+
+#define MAX_TASKS_AMOUNT 16
+
+typedef struct {
+   void (*function)(void *);
+   void *parameters;
+} task_start_t;
+
+static pthread_mutex_t critical_section_mutex_g;
+static pthread_once_t critical_section_once_g = PTHREAD_ONCE_INIT;
+static pthread_mutex_t tasks_mutex_g = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t tasks_g[MAX_TASKS_AMOUNT];
+static unsigned int tasks_amount_g;
+
+static volatile TickType_t tick_count_g;
+
+void vTaskDelay(TickType_t ticks) {
+   __atomic_add_fetch(&tick_count_g, ticks, __ATOMIC_SEQ_CST);
+   sched_yield();
+}
+
+TickType_t xTaskGetTickCount(void) {
+   return __atomic_load_n(&tick_count_g, __ATOMIC_SEQ_CST);
+}
+
+int64_t esp_timer_get_time(void) {
+   return (int64_t) xTaskGetTickCount() * portTICK_RATE_MS * 1000;
+}
+
+static void *run_task(void *argument) {
+   task_start_t task_start = *(task_start_t *) argument;
+
+   free(argument);
+   task_start.function(task_start.parameters);
+   return NULL;
+}
+
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack_depth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *created_task) {
+   (void) name;
+   (void) stack_depth;
+   (void) priority;
+
+   task_start_t *task_start = malloc(sizeof(task_start_t));
+
+   task_start->function = task;
+   task_start->parameters = parameters;
+
+   pthread_mutex_lock(&tasks_mutex_g);
+   assert(tasks_amount_g < MAX_TASKS_AMOUNT);
+
+   if (pthread_create(&tasks_g[tasks_amount_g], NULL, run_task, task_start) != 0) {
+      pthread_mutex_unlock(&tasks_mutex_g);
+      free(task_start);
+      return pdFALSE;
+   }
+
+   if (created_task != NULL) {
+      *created_task = (TaskHandle_t) (uintptr_t) (tasks_amount_g + 1);
+   }
+   tasks_amount_g++;
+   pthread_mutex_unlock(&tasks_mutex_g);
+   return pdPASS;
+}
+
+/**
+ * Only the calling task can be deleted
+ */
+void vTaskDelete(TaskHandle_t task) {
+   assert(task == NULL);
+   pthread_exit(NULL);
+}
+
+void shim_wait_for_tasks() {
+   for (;;) {
+      pthread_mutex_lock(&tasks_mutex_g);
+
+      if (tasks_amount_g == 0) {
+         pthread_mutex_unlock(&tasks_mutex_g);
+         return;
+      }
+
+      pthread_t task = tasks_g[--tasks_amount_g];
+
+      pthread_mutex_unlock(&tasks_mutex_g);
+      pthread_join(task, NULL);
+   }
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+   (void) task;
+   return 0;
+}
+
+static void init_critical_section_mutex() {
+   pthread_mutexattr_t attributes;
+
+   pthread_mutexattr_init(&attributes);
+   pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+   pthread_mutex_init(&critical_section_mutex_g, &attributes);
+   pthread_mutexattr_destroy(&attributes);
+}
+
+void taskENTER_CRITICAL(void) {
+   pthread_once(&critical_section_once_g, init_critical_section_mutex);
+   pthread_mutex_lock(&critical_section_mutex_g);
+}
+
+void taskEXIT_CRITICAL(void) {
+   pthread_mutex_unlock(&critical_section_mutex_g);
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+   return calloc(1, sizeof(EventBits_t));
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t event_group) {
+   return __atomic_load_n((EventBits_t *) event_group, __ATOMIC_SEQ_CST);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t event_group, EventBits_t bits) {
+   return __atomic_or_fetch((EventBits_t *) event_group, bits, __ATOMIC_SEQ_CST);
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t event_group, EventBits_t bits) {
+   return __atomic_fetch_and((EventBits_t *) event_group, ~bits, __ATOMIC_SEQ_CST);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+   pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+
+   pthread_mutex_init(mutex, NULL);
+   return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+   (void) ticks_to_wait;
+   return pthread_mutex_lock((pthread_mutex_t *) semaphore) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+   return pthread_mutex_unlock((pthread_mutex_t *) semaphore) == 0 ? pdTRUE : pdFALSE;
+}
@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sdkconfig.h"
+
+#ifndef SHIM_FREERTOS
+#define SHIM_FREERTOS
+
+typedef uint32_t TickType_t;
+typedef uint32_t portTickType;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+
+#define portTICK_RATE_MS         (1000 / CONFIG_FREERTOS_HZ)
+#define portTICK_PERIOD_MS       portTICK_RATE_MS
+#define portMAX_DELAY            0xFFFFFFFF
+#define configMINIMAL_STACK_SIZE 768
+#define pdTRUE                   1
+#define pdFALSE                  0
+#define pdPASS                   1
+
+/**
+ * Time is simulated: the tick counter only advances in vTaskDelay(), so the timing dependent code runs
+ * deterministically and as fast as the host allows. Tasks are POSIX threads.
+ */
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack_depth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *created_task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void taskENTER_CRITICAL(void);
+void taskEXIT_CRITICAL(void);
+
+#define portENTER_CRITICAL() taskENTER_CRITICAL()
+#define portEXIT_CRITICAL()  taskEXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SHIM_DEVICE_SETTINGS
+#define SHIM_DEVICE_SETTINGS
+
+// Host build: the servers are local stand-ins, ports are chosen by the tests at run time
+extern const char shim_access_point_name[32];
+extern const char shim_access_point_password[64];
+extern unsigned short shim_server_port;
+extern unsigned short shim_server_udp_port;
+extern unsigned short shim_mqtt_broker_port;
+
+#define ACCESS_POINT_NAME     shim_access_point_name
+#define ACCESS_POINT_PASSWORD shim_access_point_password
+#define SERVER_IP_ADDRESS     "127.0.0.1"
+#define SERVER_PORT           shim_server_port
+#define SERVER_UDP_PORT       shim_server_udp_port
+#define MQTT_BROKER_PORT      shim_mqtt_broker_port
+
+// The socket timeouts are real time, so the missing responses are waited for shortly
+#define MQTT_RESPONSE_TIMEOUT_MS 200
+
+#endif
@@ -0,0 +1,50 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "FreeRTOS.h"
+
+#ifndef SHIM_DRIVER_I2C
+#define SHIM_DRIVER_I2C
+
+typedef enum {
+   I2C_NUM_0 = 0,
+   I2C_NUM_MAX
+} i2c_port_t;
+
+typedef enum {
+   I2C_MODE_MASTER = 0,
+   I2C_MODE_MAX
+} i2c_mode_t;
+
+typedef enum {
+   I2C_MASTER_WRITE = 0,
+   I2C_MASTER_READ
+} i2c_rw_t;
+
+typedef struct {
+   i2c_mode_t mode;
+   int sda_io_num;
+   int sda_pullup_en;
+   int scl_io_num;
+   int scl_pullup_en;
+   int clk_stretch_tick;
+} i2c_config_t;
+
+typedef void *i2c_cmd_handle_t;
+
+/**
+ * Command links are executed by a simulated SHT21 (see host_shims.h)
+ */
+i2c_cmd_handle_t i2c_cmd_link_create(void);
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en);
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t data_len, int ack);
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd, TickType_t ticks_to_wait);
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode);
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num);
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf);
+
+#endif
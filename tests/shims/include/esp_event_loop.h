@@ -0,0 +1,55 @@
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "lwip/ip4_addr.h"
+
+#ifndef SHIM_ESP_EVENT_LOOP
+#define SHIM_ESP_EVENT_LOOP
+
+typedef struct {
+   ip4_addr_t ip;
+   ip4_addr_t netmask;
+   ip4_addr_t gw;
+} tcpip_adapter_ip_info_t;
+
+typedef enum {
+   SYSTEM_EVENT_STA_START = 0,
+   SYSTEM_EVENT_STA_CONNECTED,
+   SYSTEM_EVENT_STA_GOT_IP,
+   SYSTEM_EVENT_STA_DISCONNECTED,
+   SYSTEM_EVENT_AP_STACONNECTED,
+   SYSTEM_EVENT_AP_STADISCONNECTED,
+   SYSTEM_EVENT_SCAN_DONE
+} system_event_id_t;
+
+typedef struct {
+   system_event_id_t event_id;
+   union {
+      struct {
+         tcpip_adapter_ip_info_t ip_info;
+      } got_ip;
+      struct {
+         uint8_t mac[6];
+         uint8_t aid;
+      } sta_connected, sta_disconnected;
+      struct {
+         uint8_t ssid[33];
+         uint8_t bssid[6];
+         uint8_t reason;
+      } disconnected;
+      struct {
+         uint32_t status;
+         uint8_t number;
+         uint8_t scan_id;
+      } scan_done;
+   } event_info;
+} system_event_t;
+
+typedef esp_err_t (*system_event_cb_t)(void *ctx, system_event_t *event);
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+
+esp_err_t esp_event_loop_init(system_event_cb_t handler, void *ctx);
+
+#endif
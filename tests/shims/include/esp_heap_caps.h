@@ -0,0 +1 @@
+// Heap capabilities aren't used, see esp_libc.h
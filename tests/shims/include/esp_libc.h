@@ -0,0 +1,17 @@
+#include <stddef.h>
+
+#ifndef SHIM_ESP_LIBC
+#define SHIM_ESP_LIBC
+
+// Heap is counted, so the benchmarks can report allocations per operation
+void *shim_malloc(size_t size);
+void *shim_zalloc(size_t size);
+void shim_free(void *pointer);
+
+#define os_malloc(size) shim_malloc(size)
+#define os_zalloc(size) shim_zalloc(size)
+#define os_free(pointer) shim_free(pointer)
+
+#define __ESP_FILE__ __FILE__
+
+#endif
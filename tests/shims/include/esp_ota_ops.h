@@ -0,0 +1,12 @@
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifndef SHIM_ESP_OTA_OPS
+#define SHIM_ESP_OTA_OPS
+
+uint8_t get_ota_partition_count(void);
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+
+#endif
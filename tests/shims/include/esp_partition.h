@@ -0,0 +1,28 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifndef SHIM_ESP_PARTITION
+#define SHIM_ESP_PARTITION
+
+#define ESP_PARTITION_TYPE_APP          0x00
+#define ESP_PARTITION_SUBTYPE_APP_OTA_0 0x10
+#define ESP_PARTITION_SUBTYPE_APP_OTA_1 0x11
+
+typedef struct {
+   int type;
+   int subtype;
+   uint32_t address;
+   uint32_t size;
+   char label[17];
+} esp_partition_t;
+
+/**
+ * The update partition is backed by a file (see host_shims.h). Like NOR flash, a write can only clear bits
+ * of the erased (0xFF) sectors.
+ */
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t start_addr, size_t size);
+
+#endif
@@ -0,0 +1,51 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "esp_err.h"
+
+#ifndef SHIM_ESP_SYSTEM
+#define SHIM_ESP_SYSTEM
+
+typedef enum {
+   ESP_RST_UNKNOWN = 0,
+   ESP_RST_POWERON,
+   ESP_RST_EXT,
+   ESP_RST_SW,
+   ESP_RST_PANIC,
+   ESP_RST_INT_WDT,
+   ESP_RST_TASK_WDT,
+   ESP_RST_WDT,
+   ESP_RST_DEEPSLEEP,
+   ESP_RST_BROWNOUT,
+   ESP_RST_SDIO
+} esp_reset_reason_t;
+
+typedef void os_timer_func_t(void *arg);
+
+typedef struct {
+   os_timer_func_t *function;
+   void *arg;
+   uint32_t period_ms;
+   bool armed;
+} os_timer_t;
+
+// RTC user memory and other peripherals are simulated by shim_peripheral_read()/write()
+uint32_t shim_peripheral_read(uintptr_t address);
+void shim_peripheral_write(uintptr_t address, uint32_t value);
+
+#define READ_PERI_REG(address)         shim_peripheral_read((uintptr_t) (address))
+#define WRITE_PERI_REG(address, value) shim_peripheral_write((uintptr_t) (address), (value))
+
+/**
+ * Ends the calling task (the restart is counted by the shim), tests check shim_get_restarts_amount().
+ */
+void esp_restart(void) __attribute__((noreturn));
+uint32_t esp_get_free_heap_size(void);
+esp_reset_reason_t esp_reset_reason(void);
+void os_timer_disarm(os_timer_t *timer);
+void os_timer_setfn(os_timer_t *timer, os_timer_func_t *function, void *arg);
+void os_timer_arm(os_timer_t *timer, uint32_t period_ms, bool repeat);
+
+#endif
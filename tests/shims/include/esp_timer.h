@@ -0,0 +1,9 @@
+#include <stdint.h>
+
+#ifndef SHIM_ESP_TIMER
+#define SHIM_ESP_TIMER
+
+// Simulated time in microseconds, see vTaskDelay()
+int64_t esp_timer_get_time(void);
+
+#endif
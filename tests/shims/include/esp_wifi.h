@@ -0,0 +1,61 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifndef SHIM_ESP_WIFI
+#define SHIM_ESP_WIFI
+
+typedef struct {
+   uint8_t ssid[32];
+   uint8_t password[64];
+   bool bssid_set;
+   uint8_t bssid[6];
+   uint8_t channel;
+} wifi_sta_config_t;
+
+typedef union {
+   wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+   int unused;
+} wifi_init_config_t;
+
+typedef enum {
+   WIFI_MODE_NULL = 0,
+   WIFI_MODE_STA
+} wifi_mode_t;
+
+typedef enum {
+   ESP_IF_WIFI_STA = 0
+} esp_interface_t;
+
+typedef struct {
+   uint8_t *ssid;
+   uint8_t *bssid;
+   uint8_t channel;
+   bool show_hidden;
+} wifi_scan_config_t;
+
+typedef struct {
+   uint8_t bssid[6];
+   uint8_t ssid[33];
+   uint8_t primary;
+   int8_t rssi;
+} wifi_ap_record_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() {0}
+#define WIFI_REASON_NO_AP_FOUND    201
+
+/**
+ * The station is "connected" to a simulated access point right after esp_wifi_connect(), the events are dispatched
+ * synchronously to the handler registered with esp_event_loop_init().
+ */
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(esp_interface_t interface, wifi_config_t *config);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info);
+
+#endif
@@ -0,0 +1,14 @@
+#include "FreeRTOS.h"
+
+#ifndef SHIM_EVENT_GROUPS
+#define SHIM_EVENT_GROUPS
+
+typedef void *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t event_group);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t event_group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t event_group, EventBits_t bits);
+
+#endif
@@ -0,0 +1,13 @@
+#include "../FreeRTOS.h"
+
+#ifndef SHIM_SEMPHR
+#define SHIM_SEMPHR
+
+/**
+ * Mutexes only, over pthread mutexes. The timeout isn't supported, the mutex is always waited for.
+ */
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif
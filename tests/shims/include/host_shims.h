@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_system.h"
+#include "esp_partition.h"
+
+#ifndef HOST_SHIMS
+#define HOST_SHIMS
+
+/**
+ * Control of the simulated hardware for the host tests and benchmarks.
+ */
+
+typedef struct {
+   unsigned int allocations;
+   unsigned int frees;
+   size_t allocated_bytes;
+} shim_heap_statistics_t;
+
+// Tasks and system
+void shim_wait_for_tasks();
+unsigned int shim_get_restarts_amount();
+void shim_set_reset_reason(esp_reset_reason_t reset_reason);
+void shim_clear_rtc_memory();
+// Calls the callback of the armed timer as if it has expired
+bool shim_fire_timer(os_timer_t *timer);
+
+// Sockets. writev() writes at most so many bytes per call, 0 - no limit
+void shim_set_max_writev_size(size_t size);
+
+// Heap
+shim_heap_statistics_t shim_get_heap_statistics();
+void shim_reset_heap_statistics();
+
+// Simulated SHT21
+typedef struct {
+   unsigned short temperature_raw;
+   unsigned short humidity_raw;
+   // Conversion time in ticks, the read address isn't acknowledged before it
+   unsigned int conversion_ticks;
+   // The checksum of the next measurements is corrupted
+   bool corrupt_checksum;
+   // The sensor doesn't answer at all
+   bool bus_error;
+   unsigned char user_register;
+   // Reads of the measurement, including not acknowledged ones
+   unsigned int measurement_reads;
+} sht21_simulator_t;
+
+sht21_simulator_t *shim_get_sht21_simulator();
+// Bit by bit CRC-8 of the SHT21 (x^8 + x^5 + x^4 + 1), the reference for the table driven one
+unsigned char shim_sht21_reference_crc8(const unsigned char *data, size_t data_len);
+
+// OTA partition, backed by a temporary file
+void shim_partition_reset(size_t size);
+const esp_partition_t *shim_get_update_partition();
+bool shim_get_boot_partition_set();
+bool shim_partition_equals(const unsigned char *image, size_t image_length);
+
+#endif
@@ -0,0 +1,2 @@
+#include <netinet/in.h>
+#include <arpa/inet.h>
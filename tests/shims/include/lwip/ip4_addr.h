@@ -0,0 +1,16 @@
+#include <stdint.h>
+
+#ifndef SHIM_LWIP_IP4_ADDR
+#define SHIM_LWIP_IP4_ADDR
+
+typedef struct {
+   uint32_t addr;
+} ip4_addr_t;
+
+char *ip4addr_ntoa(const ip4_addr_t *address);
+
+#define IP2STR(ipaddr) ((const uint8_t *) (ipaddr))[0], ((const uint8_t *) (ipaddr))[1], \
+      ((const uint8_t *) (ipaddr))[2], ((const uint8_t *) (ipaddr))[3]
+#define IPSTR "%d.%d.%d.%d"
+
+#endif
@@ -0,0 +1,5 @@
+// lwIP sockets are the host sockets
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/time.h>
@@ -0,0 +1,22 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SHIM_MBEDTLS_SHA256
+#define SHIM_MBEDTLS_SHA256
+
+// Plain C SHA-256 with the mbedtls API, so the host build has no external dependencies
+typedef struct {
+   uint32_t state[8];
+   uint64_t length;
+   unsigned char buffer[64];
+   size_t buffer_length;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context *ctx, int is224);
+int mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen);
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context *ctx, unsigned char output[32]);
+int mbedtls_sha256_ret(const unsigned char *input, size_t ilen, unsigned char output[32], int is224);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef SHIM_SDKCONFIG
+#define SHIM_SDKCONFIG
+
+#define CONFIG_ESPTOOLPY_FLASHSIZE "4MB"
+#define CONFIG_FREERTOS_HZ         100
+
+#endif
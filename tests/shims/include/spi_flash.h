@@ -0,0 +1,6 @@
+#ifndef SHIM_SPI_FLASH
+#define SHIM_SPI_FLASH
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+#endif
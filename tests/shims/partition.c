@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_ota_ops.h"
+#include "spi_flash.h"
+#include "host_shims.h"
+
+#define DEFAULT_PARTITION_SIZE (512 * 1024)
+
+static esp_partition_t update_partition_g = {
+   .type = ESP_PARTITION_TYPE_APP,
+   .subtype = ESP_PARTITION_SUBTYPE_APP_OTA_1,
+   .address = 0x110000,
+   .label = "ota_1"
+};
+static FILE *partition_file_g;
+static bool boot_partition_set_g;
+
+void shim_partition_reset(size_t size) {
+   if (partition_file_g != NULL) {
+      fclose(partition_file_g);
+   }
+   partition_file_g = tmpfile();
+   assert(partition_file_g != NULL);
+
+   // Not erased flash content, OTA has to erase every sector before it writes
+   unsigned char sector[SPI_FLASH_SEC_SIZE];
+
+   memset(sector, 0x5A, sizeof(sector));
+   for (size_t offset = 0; offset < size; offset += SPI_FLASH_SEC_SIZE) {
+      fwrite(sector, 1, SPI_FLASH_SEC_SIZE, partition_file_g);
+   }
+   update_partition_g.size = size;
+   boot_partition_set_g = false;
+}
+
+const esp_partition_t *shim_get_update_partition() {
+   return &update_partition_g;
+}
+
+bool shim_get_boot_partition_set() {
+   return boot_partition_set_g;
+}
+
+static bool is_in_partition(const esp_partition_t *partition, size_t offset, size_t size) {
+   return partition == &update_partition_g && offset <= partition->size && size <= partition->size - offset;
+}
+
+bool shim_partition_equals(const unsigned char *image, size_t image_length) {
+   unsigned char *content = malloc(image_length);
+   bool equals = esp_partition_read(&update_partition_g, 0, content, image_length) == ESP_OK &&
+         memcmp(content, image, image_length) == 0;
+
+   free(content);
+   return equals;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+   if (!is_in_partition(partition, src_offset, size)) {
+      return ESP_ERR_INVALID_SIZE;
+   }
+   fseek(partition_file_g, (long) src_offset, SEEK_SET);
+   return fread(dst, 1, size, partition_file_g) == size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+   if (!is_in_partition(partition, dst_offset, size)) {
+      return ESP_ERR_INVALID_SIZE;
+   }
+
+   unsigned char *content = malloc(size);
+   const unsigned char *source = src;
+
+   esp_partition_read(partition, dst_offset, content, size);
+   for (size_t i = 0; i < size; i++) {
+      // Bits can only be cleared, a write over not erased data is a bug
+      assert((content[i] & source[i]) == source[i]);
+      content[i] &= source[i];
+   }
+   fseek(partition_file_g, (long) dst_offset, SEEK_SET);
+   size_t written = fwrite(content, 1, size, partition_file_g);
+
+   free(content);
+   return written == size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t start_addr, size_t size) {
+   if (!is_in_partition(partition, start_addr, size) || start_addr % SPI_FLASH_SEC_SIZE != 0 ||
+         size % SPI_FLASH_SEC_SIZE != 0) {
+      return ESP_ERR_INVALID_ARG;
+   }
+
+   unsigned char sector[SPI_FLASH_SEC_SIZE];
+
+   memset(sector, 0xFF, sizeof(sector));
+   fseek(partition_file_g, (long) start_addr, SEEK_SET);
+   for (size_t offset = 0; offset < size; offset += SPI_FLASH_SEC_SIZE) {
+      fwrite(sector, 1, SPI_FLASH_SEC_SIZE, partition_file_g);
+   }
+   return ESP_OK;
+}
+
+uint8_t get_ota_partition_count(void) {
+   return 2;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from) {
+   (void) start_from;
+
+   if (partition_file_g == NULL) {
+      shim_partition_reset(DEFAULT_PARTITION_SIZE);
+   }
+   return &update_partition_g;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+   if (partition != &update_partition_g) {
+      return ESP_ERR_INVALID_ARG;
+   }
+   boot_partition_set_g = true;
+   return ESP_OK;
+}
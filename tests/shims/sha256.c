@@ -0,0 +1,123 @@
+#include <string.h>
+#include "mbedtls/sha256.h"
+
+#define ROTATE_RIGHT(value, bits) (((value) >> (bits)) | ((value) << (32 - (bits))))
+
+static const uint32_t ROUND_CONSTANTS[64] = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void process_block(mbedtls_sha256_context *ctx, const unsigned char *block) {
+   uint32_t w[64];
+   uint32_t s[8];
+
+   for (unsigned int i = 0; i < 16; i++) {
+      w[i] = ((uint32_t) block[i * 4] << 24) | ((uint32_t) block[i * 4 + 1] << 16) |
+            ((uint32_t) block[i * 4 + 2] << 8) | block[i * 4 + 3];
+   }
+   for (unsigned int i = 16; i < 64; i++) {
+      uint32_t s0 = ROTATE_RIGHT(w[i - 15], 7) ^ ROTATE_RIGHT(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = ROTATE_RIGHT(w[i - 2], 17) ^ ROTATE_RIGHT(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+   }
+
+   memcpy(s, ctx->state, sizeof(s));
+   for (unsigned int i = 0; i < 64; i++) {
+      uint32_t sum1 = ROTATE_RIGHT(s[4], 6) ^ ROTATE_RIGHT(s[4], 11) ^ ROTATE_RIGHT(s[4], 25);
+      uint32_t choice = (s[4] & s[5]) ^ (~s[4] & s[6]);
+      uint32_t temp1 = s[7] + sum1 + choice + ROUND_CONSTANTS[i] + w[i];
+      uint32_t sum0 = ROTATE_RIGHT(s[0], 2) ^ ROTATE_RIGHT(s[0], 13) ^ ROTATE_RIGHT(s[0], 22);
+      uint32_t majority = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+
+      memmove(&s[1], &s[0], 7 * sizeof(uint32_t));
+      s[4] += temp1;
+      s[0] = temp1 + sum0 + majority;
+   }
+   for (unsigned int i = 0; i < 8; i++) {
+      ctx->state[i] += s[i];
+   }
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx) {
+   memset(ctx, 0, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx) {
+   memset(ctx, 0, sizeof(mbedtls_sha256_context));
+}
+
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context *ctx, int is224) {
+   static const uint32_t INITIAL_STATE[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+   };
+
+   if (is224) {
+      return -1;
+   }
+   memcpy(ctx->state, INITIAL_STATE, sizeof(INITIAL_STATE));
+   ctx->length = 0;
+   ctx->buffer_length = 0;
+   return 0;
+}
+
+int mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen) {
+   ctx->length += ilen;
+
+   while (ilen > 0) {
+      size_t length = sizeof(ctx->buffer) - ctx->buffer_length;
+
+      if (length > ilen) {
+         length = ilen;
+      }
+      memcpy(ctx->buffer + ctx->buffer_length, input, length);
+      ctx->buffer_length += length;
+      input += length;
+      ilen -= length;
+
+      if (ctx->buffer_length == sizeof(ctx->buffer)) {
+         process_block(ctx, ctx->buffer);
+         ctx->buffer_length = 0;
+      }
+   }
+   return 0;
+}
+
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context *ctx, unsigned char output[32]) {
+   uint64_t bits = ctx->length * 8;
+   unsigned char padding[72] = {0x80};
+   size_t padding_length = (ctx->buffer_length < 56 ? 56 : 120) - ctx->buffer_length;
+
+   for (unsigned int i = 0; i < 8; i++) {
+      padding[padding_length + i] = (unsigned char) (bits >> (56 - i * 8));
+   }
+   mbedtls_sha256_update_ret(ctx, padding, padding_length + 8);
+
+   for (unsigned int i = 0; i < 8; i++) {
+      output[i * 4] = (unsigned char) (ctx->state[i] >> 24);
+      output[i * 4 + 1] = (unsigned char) (ctx->state[i] >> 16);
+      output[i * 4 + 2] = (unsigned char) (ctx->state[i] >> 8);
+      output[i * 4 + 3] = (unsigned char) ctx->state[i];
+   }
+   return 0;
+}
+
+int mbedtls_sha256_ret(const unsigned char *input, size_t ilen, unsigned char output[32], int is224) {
+   mbedtls_sha256_context ctx;
+
+   mbedtls_sha256_init(&ctx);
+   int ret = mbedtls_sha256_starts_ret(&ctx, is224);
+
+   if (ret == 0) {
+      mbedtls_sha256_update_ret(&ctx, input, ilen);
+      ret = mbedtls_sha256_finish_ret(&ctx, output);
+   }
+   mbedtls_sha256_free(&ctx);
+   return ret;
+}
@@ -0,0 +1,191 @@
+#include "driver/i2c.h"
+#include "host_shims.h"
+
+#define SHT21_SIMULATOR_ADDRESS  0x40
+#define MAX_OPERATIONS_AMOUNT    8
+#define TRIGGER_T_COMMAND        0xF3
+#define TRIGGER_RH_COMMAND       0xF5
+#define WRITE_USER_REGISTER_CMD  0xE6
+#define READ_USER_REGISTER_CMD   0xE7
+
+typedef enum {
+   OPERATION_START,
+   OPERATION_STOP,
+   OPERATION_WRITE_BYTE,
+   OPERATION_READ
+} operation_type_t;
+
+typedef struct {
+   operation_type_t type;
+   uint8_t byte;
+   uint8_t *data;
+   size_t data_len;
+} operation_t;
+
+typedef struct {
+   operation_t operations[MAX_OPERATIONS_AMOUNT];
+   unsigned int operations_amount;
+} command_link_t;
+
+static sht21_simulator_t simulator_g = {
+   .temperature_raw = 0x6A3C,  // 26.07 C
+   .humidity_raw = 0x7C82,     // 54.79 %
+   .conversion_ticks = 3,
+   .user_register = 0x02
+};
+static unsigned char pending_command_g;
+static TickType_t trigger_time_g;
+
+sht21_simulator_t *shim_get_sht21_simulator() {
+   return &simulator_g;
+}
+
+unsigned char shim_sht21_reference_crc8(const unsigned char *data, size_t data_len) {
+   unsigned char crc = 0;
+
+   for (size_t i = 0; i < data_len; i++) {
+      crc ^= data[i];
+
+      for (unsigned char bit = 0; bit < 8; bit++) {
+         crc = (crc & 0x80) ? (unsigned char) ((crc << 1) ^ 0x31) : (unsigned char) (crc << 1);
+      }
+   }
+   return crc;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void) {
+   return calloc(1, sizeof(command_link_t));
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd) {
+   free(cmd);
+}
+
+static esp_err_t add_operation(i2c_cmd_handle_t cmd, operation_t operation) {
+   command_link_t *command_link = cmd;
+
+   if (command_link == NULL || command_link->operations_amount >= MAX_OPERATIONS_AMOUNT) {
+      return ESP_ERR_INVALID_ARG;
+   }
+   command_link->operations[command_link->operations_amount++] = operation;
+   return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd) {
+   return add_operation(cmd, (operation_t) {.type = OPERATION_START});
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd) {
+   return add_operation(cmd, (operation_t) {.type = OPERATION_STOP});
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en) {
+   (void) ack_en;
+   return add_operation(cmd, (operation_t) {.type = OPERATION_WRITE_BYTE, .byte = data});
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t data_len, int ack) {
+   (void) ack;
+   return add_operation(cmd, (operation_t) {.type = OPERATION_READ, .data = data, .data_len = data_len});
+}
+
+static void put_measurement(uint8_t *data, size_t data_len, unsigned short raw) {
+   unsigned char measurement[3] = {raw >> 8, raw & 0xFF, 0};
+
+   measurement[2] = shim_sht21_reference_crc8(measurement, 2);
+   if (simulator_g.corrupt_checksum) {
+      measurement[2] ^= 0x1;
+   }
+   memcpy(data, measurement, data_len < sizeof(measurement) ? data_len : sizeof(measurement));
+}
+
+static esp_err_t execute_write(const command_link_t *command_link, unsigned int operation_index) {
+   const operation_t *command = &command_link->operations[operation_index];
+
+   if (command->type != OPERATION_WRITE_BYTE) {
+      return ESP_FAIL;
+   }
+
+   switch (command->byte) {
+      case TRIGGER_T_COMMAND:
+      case TRIGGER_RH_COMMAND:
+         trigger_time_g = xTaskGetTickCount();
+         // fall through
+      case READ_USER_REGISTER_CMD:
+         pending_command_g = command->byte;
+         return ESP_OK;
+      case WRITE_USER_REGISTER_CMD:
+         if (command[1].type != OPERATION_WRITE_BYTE) {
+            return ESP_FAIL;
+         }
+         simulator_g.user_register = command[1].byte;
+         return ESP_OK;
+      default:
+         return ESP_FAIL;
+   }
+}
+
+static esp_err_t execute_read(const operation_t *read) {
+   if (read->type != OPERATION_READ) {
+      return ESP_FAIL;
+   }
+
+   switch (pending_command_g) {
+      case TRIGGER_T_COMMAND:
+      case TRIGGER_RH_COMMAND:
+         simulator_g.measurement_reads++;
+
+         // No hold master mode: the read address isn't acknowledged during the conversion
+         if (xTaskGetTickCount() - trigger_time_g < simulator_g.conversion_ticks) {
+            return ESP_FAIL;
+         }
+         put_measurement(read->data, read->data_len, pending_command_g == TRIGGER_T_COMMAND ?
+               simulator_g.temperature_raw : simulator_g.humidity_raw);
+         break;
+      case READ_USER_REGISTER_CMD:
+         read->data[0] = simulator_g.user_register;
+         break;
+      default:
+         return ESP_FAIL;
+   }
+   pending_command_g = 0;
+   return ESP_OK;
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd, TickType_t ticks_to_wait) {
+   (void) i2c_num;
+   (void) ticks_to_wait;
+
+   const command_link_t *command_link = cmd;
+
+   if (simulator_g.bus_error) {
+      return ESP_ERR_TIMEOUT;
+   }
+   if (command_link->operations_amount < 3 || command_link->operations[0].type != OPERATION_START ||
+         command_link->operations[1].type != OPERATION_WRITE_BYTE ||
+         (command_link->operations[1].byte >> 1) != SHT21_SIMULATOR_ADDRESS) {
+      return ESP_FAIL;
+   }
+
+   if (command_link->operations[1].byte & I2C_MASTER_READ) {
+      return execute_read(&command_link->operations[2]);
+   }
+   return execute_write(command_link, 2);
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode) {
+   (void) i2c_num;
+   (void) mode;
+   return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num) {
+   (void) i2c_num;
+   return ESP_OK;
+}
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf) {
+   (void) i2c_num;
+   (void) i2c_conf;
+   return ESP_OK;
+}
@@ -0,0 +1,33 @@
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include "host_shims.h"
+
+static volatile size_t max_writev_size_g;
+
+void shim_set_max_writev_size(size_t size) {
+   max_writev_size_g = size;
+}
+
+/**
+ * Replaces the libc writev(), so the short writes of a full send buffer can be reproduced.
+ */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+   size_t max_size = max_writev_size_g;
+
+   if (max_size == 0) {
+      return syscall(SYS_writev, fd, iov, iovcnt);
+   }
+
+   struct iovec limited_iov[iovcnt];
+   int limited_iovcnt = 0;
+
+   for (size_t size = 0; limited_iovcnt < iovcnt && size < max_size; limited_iovcnt++) {
+      limited_iov[limited_iovcnt] = iov[limited_iovcnt];
+      if (limited_iov[limited_iovcnt].iov_len > max_size - size) {
+         limited_iov[limited_iovcnt].iov_len = max_size - size;
+      }
+      size += limited_iov[limited_iovcnt].iov_len;
+   }
+   return syscall(SYS_writev, fd, limited_iov, limited_iovcnt);
+}
@@ -0,0 +1,106 @@
+#include <pthread.h>
+#include <string.h>
+#include "esp_system.h"
+#include "esp_libc.h"
+#include "host_shims.h"
+
+#define RTC_MEMORY_ADDRESS 0x60001000
+#define RTC_MEMORY_BLOCKS  192
+#define FREE_HEAP_SIZE     (40 * 1024)
+
+static uint32_t rtc_memory_g[RTC_MEMORY_BLOCKS];
+static unsigned int restarts_amount_g;
+static esp_reset_reason_t reset_reason_g = ESP_RST_POWERON;
+static shim_heap_statistics_t heap_statistics_g;
+
+uint32_t shim_peripheral_read(uintptr_t address) {
+   assert(address >= RTC_MEMORY_ADDRESS && address < RTC_MEMORY_ADDRESS + sizeof(rtc_memory_g));
+   return rtc_memory_g[(address - RTC_MEMORY_ADDRESS) / 4];
+}
+
+void shim_peripheral_write(uintptr_t address, uint32_t value) {
+   assert(address >= RTC_MEMORY_ADDRESS && address < RTC_MEMORY_ADDRESS + sizeof(rtc_memory_g));
+   rtc_memory_g[(address - RTC_MEMORY_ADDRESS) / 4] = value;
+}
+
+void shim_clear_rtc_memory() {
+   memset(rtc_memory_g, 0, sizeof(rtc_memory_g));
+}
+
+void esp_restart(void) {
+   __atomic_add_fetch(&restarts_amount_g, 1, __ATOMIC_SEQ_CST);
+   pthread_exit(NULL);
+}
+
+unsigned int shim_get_restarts_amount() {
+   return __atomic_load_n(&restarts_amount_g, __ATOMIC_SEQ_CST);
+}
+
+esp_reset_reason_t esp_reset_reason(void) {
+   return reset_reason_g;
+}
+
+void shim_set_reset_reason(esp_reset_reason_t reset_reason) {
+   reset_reason_g = reset_reason;
+}
+
+uint32_t esp_get_free_heap_size(void) {
+   return FREE_HEAP_SIZE;
+}
+
+void os_timer_disarm(os_timer_t *timer) {
+   timer->armed = false;
+}
+
+void os_timer_setfn(os_timer_t *timer, os_timer_func_t *function, void *arg) {
+   timer->function = function;
+   timer->arg = arg;
+}
+
+/**
+ * Timers never expire by themselves, see shim_fire_timer()
+ */
+void os_timer_arm(os_timer_t *timer, uint32_t period_ms, bool repeat) {
+   (void) repeat;
+
+   timer->period_ms = period_ms;
+   timer->armed = true;
+}
+
+bool shim_fire_timer(os_timer_t *timer) {
+   if (!timer->armed || timer->function == NULL) {
+      return false;
+   }
+   timer->function(timer->arg);
+   return true;
+}
+
+void *shim_malloc(size_t size) {
+   __atomic_add_fetch(&heap_statistics_g.allocations, 1, __ATOMIC_SEQ_CST);
+   __atomic_add_fetch(&heap_statistics_g.allocated_bytes, size, __ATOMIC_SEQ_CST);
+   return malloc(size);
+}
+
+void *shim_zalloc(size_t size) {
+   void *pointer = shim_malloc(size);
+
+   if (pointer != NULL) {
+      memset(pointer, 0, size);
+   }
+   return pointer;
+}
+
+void shim_free(void *pointer) {
+   if (pointer != NULL) {
+      __atomic_add_fetch(&heap_statistics_g.frees, 1, __ATOMIC_SEQ_CST);
+   }
+   free(pointer);
+}
+
+shim_heap_statistics_t shim_get_heap_statistics() {
+   return heap_statistics_g;
+}
+
+void shim_reset_heap_statistics() {
+   memset(&heap_statistics_g, 0, sizeof(heap_statistics_g));
+}
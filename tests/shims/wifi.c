@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_event_loop.h"
+#include "device_settings.h"
+
+const char shim_access_point_name[32] = "host";
+const char shim_access_point_password[64] = "password";
+unsigned short shim_server_port;
+unsigned short shim_server_udp_port;
+unsigned short shim_mqtt_broker_port;
+
+static system_event_cb_t event_handler_g;
+static void *event_handler_context_g;
+
+static void dispatch_event(system_event_id_t event_id) {
+   system_event_t event;
+
+   memset(&event, 0, sizeof(event));
+   event.event_id = event_id;
+
+   if (event_id == SYSTEM_EVENT_STA_GOT_IP) {
+      // 127.0.0.1 in the network byte order
+      event.event_info.got_ip.ip_info.ip.addr = 0x0100007F;
+   }
+   if (event_handler_g != NULL) {
+      event_handler_g(event_handler_context_g, &event);
+   }
+}
+
+esp_err_t esp_event_loop_init(system_event_cb_t handler, void *ctx) {
+   event_handler_g = handler;
+   event_handler_context_g = ctx;
+   return ESP_OK;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) {
+   (void) config;
+   return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+   (void) mode;
+   return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(esp_interface_t interface, wifi_config_t *config) {
+   (void) interface;
+   (void) config;
+   return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) {
+   dispatch_event(SYSTEM_EVENT_STA_START);
+   return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void) {
+   dispatch_event(SYSTEM_EVENT_STA_CONNECTED);
+   dispatch_event(SYSTEM_EVENT_STA_GOT_IP);
+   return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info) {
+   memset(ap_info, 0, sizeof(wifi_ap_record_t));
+   memcpy(ap_info->ssid, shim_access_point_name, sizeof(shim_access_point_name));
+   ap_info->primary = 1;
+   ap_info->rssi = -50;
+   return ESP_OK;
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *address) {
+   static char address_string[16];
+   const uint8_t *octets = (const uint8_t *) &address->addr;
+
+   snprintf(address_string, sizeof(address_string), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+   return address_string;
+}
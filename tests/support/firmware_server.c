@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mbedtls/sha256.h"
+#include "firmware_server.h"
+
+void firmware_server_init(firmware_server_t *firmware_server, const unsigned char *file, size_t file_length,
+                          const unsigned char *image, size_t image_length) {
+   unsigned char sha256[32];
+
+   memset(firmware_server, 0, sizeof(firmware_server_t));
+   firmware_server->file = file;
+   firmware_server->file_length = file_length;
+   firmware_server->etag = "\"image-1\"";
+
+   mbedtls_sha256_ret(image, image_length, sha256, 0);
+   for (unsigned int i = 0; i < sizeof(sha256); i++) {
+      sprintf(firmware_server->sha256 + i * 2, "%02x", sha256[i]);
+   }
+}
+
+static void write_body(int socket_id, const unsigned char *body, size_t length, bool chunked, size_t write_size) {
+   if (!chunked) {
+      local_server_write(socket_id, body, length, write_size);
+      return;
+   }
+
+   // Chunks of different sizes, so the chunk boundaries are not aligned with anything
+   size_t chunk_length = 1;
+
+   for (size_t offset = 0; offset < length; offset += chunk_length, chunk_length = chunk_length * 3 + 7) {
+      char chunk_header[16];
+
+      if (chunk_length > length - offset) {
+         chunk_length = length - offset;
+      }
+      sprintf(chunk_header, "%zx\r\n", chunk_length);
+      local_server_write(socket_id, chunk_header, strlen(chunk_header), write_size);
+      local_server_write(socket_id, body + offset, chunk_length, write_size);
+      local_server_write(socket_id, "\r\n", 2, write_size);
+   }
+   local_server_write(socket_id, "0\r\n\r\n", 5, write_size);
+}
+
+bool firmware_server_respond(local_server_t *server, int socket_id, const char *request) {
+   firmware_server_t *firmware_server = server->context;
+   const char *range = strstr(request, "\r\nRange: bytes=");
+   size_t range_start = range == NULL ? 0 : strtoul(range + strlen("\r\nRange: bytes="), NULL, 10);
+   size_t body_length = firmware_server->file_length - range_start;
+   char headers[512];
+   int headers_length;
+
+   firmware_server->last_range_requested = range != NULL;
+   firmware_server->last_range_start = range_start;
+
+   if (range != NULL) {
+      headers_length = sprintf(headers, "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %zu-%zu/%zu\r\n",
+            range_start, firmware_server->file_length - 1, firmware_server->file_length);
+   } else {
+      headers_length = sprintf(headers, "HTTP/1.1 200 OK\r\n");
+   }
+   if (firmware_server->chunked) {
+      headers_length += sprintf(headers + headers_length, "Transfer-Encoding: chunked\r\n");
+   } else {
+      headers_length += sprintf(headers + headers_length, "Content-Length: %zu\r\n", body_length);
+   }
+   headers_length += sprintf(headers + headers_length, "ETag: %s\r\nX-Firmware-SHA256: %s\r\nConnection: close\r\n\r\n",
+         firmware_server->etag, firmware_server->sha256);
+
+   local_server_write(socket_id, headers, headers_length, firmware_server->write_size);
+
+   if (firmware_server->truncate_at > 0 && firmware_server->truncate_at < body_length) {
+      local_server_write(socket_id, firmware_server->file + range_start, firmware_server->truncate_at,
+            firmware_server->write_size);
+      firmware_server->truncate_at = 0;
+   } else {
+      write_body(socket_id, firmware_server->file + range_start, body_length, firmware_server->chunked,
+            firmware_server->write_size);
+   }
+   return false;
+}
@@ -0,0 +1,31 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include "local_server.h"
+
+#ifndef FIRMWARE_SERVER_HEADER
+#define FIRMWARE_SERVER_HEADER
+
+/**
+ * Serves the firmware file like the real server: Range requests are answered with 206, the SHA-256 of the decoded
+ * image is sent in X-Firmware-SHA256.
+ */
+typedef struct {
+   const unsigned char *file;
+   size_t file_length;
+   // Hexadecimal SHA-256 of the image written to the flash
+   char sha256[65];
+   const char *etag;
+   bool chunked;
+   // The connection is closed after so many body bytes of the next response, 0 - the whole body is sent
+   size_t truncate_at;
+   // Pieces of the response passed to send(), 0 - the whole response at once
+   size_t write_size;
+   size_t last_range_start;
+   bool last_range_requested;
+} firmware_server_t;
+
+void firmware_server_init(firmware_server_t *firmware_server, const unsigned char *file, size_t file_length,
+                          const unsigned char *image, size_t image_length);
+bool firmware_server_respond(local_server_t *server, int socket_id, const char *request);
+
+#endif
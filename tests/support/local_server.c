@@ -0,0 +1,120 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "local_server.h"
+
+static size_t get_content_length(const char *headers) {
+   const char *header = strcasestr(headers, "\r\nContent-Length:");
+
+   return header == NULL ? 0 : strtoul(header + strlen("\r\nContent-Length:"), NULL, 10);
+}
+
+/**
+ * Returns the request length or 0 if the connection has been closed
+ */
+static size_t read_request(int socket_id, char *request, size_t request_size) {
+   size_t length = 0;
+   size_t required_length = 0;
+
+   while (length < request_size - 1) {
+      ssize_t received = recv(socket_id, request + length, request_size - 1 - length, 0);
+
+      if (received <= 0) {
+         return 0;
+      }
+      length += received;
+      request[length] = '\0';
+
+      char *headers_end = strstr(request, "\r\n\r\n");
+
+      if (headers_end != NULL) {
+         required_length = headers_end + 4 - request + get_content_length(request);
+
+         if (length >= required_length) {
+            return length;
+         }
+      }
+   }
+   return 0;
+}
+
+static void *serve(void *argument) {
+   local_server_t *server = argument;
+
+   for (;;) {
+      int socket_id = accept(server->listen_socket_id, NULL, NULL);
+
+      if (socket_id < 0) {
+         return NULL;
+      }
+      __atomic_add_fetch(&server->connections, 1, __ATOMIC_SEQ_CST);
+
+      int no_delay = 1;
+
+      setsockopt(socket_id, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+      char request[LOCAL_SERVER_REQUEST_SIZE];
+      bool keep_alive = true;
+
+      while (keep_alive && read_request(socket_id, request, sizeof(request)) > 0) {
+         memcpy(server->last_request, request, sizeof(request));
+         __atomic_add_fetch(&server->requests, 1, __ATOMIC_SEQ_CST);
+         keep_alive = server->handler(server, socket_id, request);
+      }
+      close(socket_id);
+   }
+}
+
+bool local_server_start(local_server_t *server, local_server_handler_t handler, void *context) {
+   struct sockaddr_in address;
+   socklen_t address_length = sizeof(address);
+
+   memset(server, 0, sizeof(local_server_t));
+   server->handler = handler;
+   server->context = context;
+   server->listen_socket_id = socket(AF_INET, SOCK_STREAM, 0);
+
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if (server->listen_socket_id < 0 ||
+         bind(server->listen_socket_id, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+         listen(server->listen_socket_id, 4) != 0 ||
+         getsockname(server->listen_socket_id, (struct sockaddr *) &address, &address_length) != 0) {
+      return false;
+   }
+   server->port = ntohs(address.sin_port);
+   return pthread_create(&server->thread, NULL, serve, server) == 0;
+}
+
+void local_server_stop(local_server_t *server) {
+   shutdown(server->listen_socket_id, SHUT_RDWR);
+   close(server->listen_socket_id);
+   pthread_join(server->thread, NULL);
+}
+
+bool local_server_write(int socket_id, const void *data, size_t length, size_t chunk_size) {
+   const char *position = data;
+
+   if (chunk_size == 0) {
+      chunk_size = length;
+   }
+   while (length > 0) {
+      size_t piece_length = length < chunk_size ? length : chunk_size;
+      ssize_t sent = send(socket_id, position, piece_length, MSG_NOSIGNAL);
+
+      if (sent <= 0) {
+         return false;
+      }
+      position += sent;
+      length -= sent;
+   }
+   return true;
+}
@@ -0,0 +1,37 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifndef LOCAL_SERVER_HEADER
+#define LOCAL_SERVER_HEADER
+
+#define LOCAL_SERVER_REQUEST_SIZE 2048
+
+struct local_server;
+
+/**
+ * Called for every received request (headers and the body of Content-Length). The response is written into socket_id.
+ * Returns false to close the connection after the response.
+ */
+typedef bool (*local_server_handler_t)(struct local_server *server, int socket_id, const char *request);
+
+/**
+ * Stand-in for the HTTP server on 127.0.0.1, port is chosen by the system. Connections are served one by one.
+ */
+typedef struct local_server {
+   int listen_socket_id;
+   unsigned short port;
+   pthread_t thread;
+   local_server_handler_t handler;
+   void *context;
+   unsigned int connections;
+   unsigned int requests;
+   char last_request[LOCAL_SERVER_REQUEST_SIZE];
+} local_server_t;
+
+bool local_server_start(local_server_t *server, local_server_handler_t handler, void *context);
+void local_server_stop(local_server_t *server);
+// Writes the whole buffer, the pieces of chunk_size bytes (0 - at once) are sent separately
+bool local_server_write(int socket_id, const void *data, size_t length, size_t chunk_size);
+
+#endif
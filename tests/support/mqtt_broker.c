@@ -0,0 +1,376 @@
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "local_server.h"
+#include "mqtt_broker.h"
+
+#define CONNECT_PACKET     0x10
+#define CONNACK_PACKET     0x20
+#define PUBLISH_PACKET     0x30
+#define PUBACK_PACKET      0x40
+#define SUBSCRIBE_PACKET   0x80
+#define SUBACK_PACKET      0x90
+#define PINGREQ_PACKET     0xC0
+#define PINGRESP_PACKET    0xD0
+
+#define CLEAN_SESSION_FLAG 0x02
+#define DUP_FLAG           0x08
+
+static unsigned short get_u16(const unsigned char *buffer) {
+   return (buffer[0] << 8) | buffer[1];
+}
+
+static bool receive_exactly(int socket_id, unsigned char *buffer, size_t length) {
+   size_t received_bytes = 0;
+
+   while (received_bytes < length) {
+      ssize_t received = recv(socket_id, buffer + received_bytes, length - received_bytes, 0);
+
+      if (received <= 0) {
+         return false;
+      }
+      received_bytes += received;
+   }
+   return true;
+}
+
+/**
+ * Returns the packet type and flags byte or -1 if the connection is closed or the packet is too long
+ */
+static int receive_packet(int socket_id, unsigned char *packet, size_t *length) {
+   unsigned char fixed_header;
+
+   if (!receive_exactly(socket_id, &fixed_header, 1)) {
+      return -1;
+   }
+
+   *length = 0;
+   for (unsigned int shift = 0; ; shift += 7) {
+      unsigned char encoded_byte;
+
+      if (shift > 21 || !receive_exactly(socket_id, &encoded_byte, 1)) {
+         return -1;
+      }
+      *length |= (size_t) (encoded_byte & 0x7F) << shift;
+      if ((encoded_byte & 0x80) == 0) {
+         break;
+      }
+   }
+   return *length <= MQTT_BROKER_PACKET_SIZE && receive_exactly(socket_id, packet, *length) ? fixed_header : -1;
+}
+
+/**
+ * Has to be called under the mutex
+ */
+static void send_message(mqtt_broker_t *broker, const mqtt_broker_message_t *message) {
+   unsigned char packet[5 + 2 + MQTT_BROKER_TOPIC_SIZE + 2 + MQTT_BROKER_PAYLOAD_SIZE];
+   size_t topic_length = strlen(message->topic);
+   size_t remaining_length = 2 + topic_length + (message->qos > 0 ? 2 : 0) + message->payload_length;
+   size_t length = 0;
+
+   packet[length++] = PUBLISH_PACKET | (message->duplicate ? DUP_FLAG : 0) | (message->qos << 1);
+   do {
+      packet[length++] = (remaining_length & 0x7F) | (remaining_length > 0x7F ? 0x80 : 0);
+      remaining_length >>= 7;
+   } while (remaining_length > 0);
+   packet[length++] = topic_length >> 8;
+   packet[length++] = topic_length & 0xFF;
+   memcpy(packet + length, message->topic, topic_length);
+   length += topic_length;
+   if (message->qos > 0) {
+      packet[length++] = message->packet_id >> 8;
+      packet[length++] = message->packet_id & 0xFF;
+   }
+   memcpy(packet + length, message->payload, message->payload_length);
+   length += message->payload_length;
+
+   local_server_write(broker->client_socket_id, packet, length, 0);
+}
+
+static void send_packet(mqtt_broker_t *broker, const unsigned char *packet, size_t length) {
+   pthread_mutex_lock(&broker->mutex);
+   local_server_write(broker->client_socket_id, packet, length, 0);
+   pthread_mutex_unlock(&broker->mutex);
+}
+
+/**
+ * Returns false if the packet is malformed
+ */
+static bool on_connect(mqtt_broker_t *broker, int socket_id, const unsigned char *packet, size_t length) {
+   // Protocol name "MQTT", level, flags, keep alive, client id
+   if (length < 12 || memcmp(packet, "\0\4MQTT\4", 7) != 0 || 12 + (size_t) get_u16(packet + 10) > length ||
+         get_u16(packet + 10) >= MQTT_BROKER_TOPIC_SIZE) {
+      return false;
+   }
+
+   char client_id[MQTT_BROKER_TOPIC_SIZE];
+   bool clean_session = packet[7] & CLEAN_SESSION_FLAG;
+
+   memcpy(client_id, packet + 12, get_u16(packet + 10));
+   client_id[get_u16(packet + 10)] = '\0';
+
+   pthread_mutex_lock(&broker->mutex);
+   broker->session_present = !clean_session && broker->session_stored && strcmp(broker->client_id, client_id) == 0;
+   if (!broker->session_present) {
+      broker->subscription[0] = '\0';
+      broker->queue_length = 0;
+   }
+   broker->session_stored = !clean_session;
+   broker->clean_session = clean_session;
+   strcpy(broker->client_id, client_id);
+   broker->client_socket_id = socket_id;
+   broker->connections++;
+
+   const unsigned char connack_packet[] = {CONNACK_PACKET, 2, broker->session_present, 0};
+
+   local_server_write(socket_id, connack_packet, sizeof(connack_packet), 0);
+
+   // Not acknowledged messages of the stored session
+   for (unsigned int i = 0; i < broker->queue_length; i++) {
+      broker->queue[i].duplicate = true;
+      send_message(broker, &broker->queue[i]);
+   }
+   pthread_mutex_unlock(&broker->mutex);
+   return true;
+}
+
+static bool on_subscribe(mqtt_broker_t *broker, const unsigned char *packet, size_t length) {
+   // Packet id and the first topic filter with its QoS, the others are ignored
+   if (length < 5 || 5 + (size_t) get_u16(packet + 2) > length || get_u16(packet + 2) >= MQTT_BROKER_TOPIC_SIZE) {
+      return false;
+   }
+
+   unsigned short topic_length = get_u16(packet + 2);
+   unsigned char granted_qos = packet[4 + topic_length] > 1 ? 1 : packet[4 + topic_length];
+
+   pthread_mutex_lock(&broker->mutex);
+   memcpy(broker->subscription, packet + 4, topic_length);
+   broker->subscription[topic_length] = '\0';
+   broker->subscription_qos = granted_qos;
+   pthread_mutex_unlock(&broker->mutex);
+
+   const unsigned char suback_packet[] = {SUBACK_PACKET, 3, packet[0], packet[1], granted_qos};
+
+   send_packet(broker, suback_packet, sizeof(suback_packet));
+   return true;
+}
+
+static bool on_publish(mqtt_broker_t *broker, unsigned char fixed_header, const unsigned char *packet,
+                       size_t length) {
+   mqtt_broker_message_t message;
+
+   memset(&message, 0, sizeof(message));
+   message.qos = (fixed_header >> 1) & 0x03;
+   message.duplicate = fixed_header & DUP_FLAG;
+
+   size_t payload_position = 2 + (length >= 2 ? get_u16(packet) : 0) + (message.qos > 0 ? 2 : 0);
+
+   if (length < 2 || get_u16(packet) >= MQTT_BROKER_TOPIC_SIZE || payload_position > length ||
+         length - payload_position > MQTT_BROKER_PAYLOAD_SIZE) {
+      return false;
+   }
+
+   memcpy(message.topic, packet + 2, get_u16(packet));
+   if (message.qos > 0) {
+      message.packet_id = get_u16(packet + payload_position - 2);
+   }
+   message.payload_length = length - payload_position;
+   memcpy(message.payload, packet + payload_position, message.payload_length);
+
+   pthread_mutex_lock(&broker->mutex);
+   broker->publishes++;
+   broker->last_message = message;
+   bool drop_puback = broker->drop_pubacks;
+   pthread_mutex_unlock(&broker->mutex);
+
+   if (message.qos > 0 && !drop_puback) {
+      const unsigned char puback_packet[] = {PUBACK_PACKET, 2, message.packet_id >> 8, message.packet_id & 0xFF};
+
+      send_packet(broker, puback_packet, sizeof(puback_packet));
+   }
+   return true;
+}
+
+static bool on_puback(mqtt_broker_t *broker, const unsigned char *packet, size_t length) {
+   if (length != 2) {
+      return false;
+   }
+
+   pthread_mutex_lock(&broker->mutex);
+   broker->pubacks++;
+   for (unsigned int i = 0; i < broker->queue_length; i++) {
+      if (broker->queue[i].packet_id == get_u16(packet)) {
+         broker->queue_length--;
+         memmove(&broker->queue[i], &broker->queue[i + 1], (broker->queue_length - i) * sizeof(broker->queue[0]));
+         break;
+      }
+   }
+   pthread_mutex_unlock(&broker->mutex);
+   return true;
+}
+
+/**
+ * Returns false to close the connection
+ */
+static bool handle_packet(mqtt_broker_t *broker, int socket_id, int fixed_header, const unsigned char *packet,
+                          size_t length) {
+   // The first packet has to be CONNECT. client_socket_id is changed only by this thread
+   if (broker->client_socket_id != socket_id) {
+      return (fixed_header & 0xF0) == CONNECT_PACKET && on_connect(broker, socket_id, packet, length);
+   }
+
+   switch (fixed_header & 0xF0) {
+      case PUBLISH_PACKET:
+         return on_publish(broker, fixed_header, packet, length);
+      case PUBACK_PACKET:
+         return on_puback(broker, packet, length);
+      case SUBSCRIBE_PACKET:
+         return on_subscribe(broker, packet, length);
+      case PINGREQ_PACKET: {
+         const unsigned char pingresp_packet[] = {PINGRESP_PACKET, 0};
+
+         pthread_mutex_lock(&broker->mutex);
+         broker->pings++;
+         pthread_mutex_unlock(&broker->mutex);
+         send_packet(broker, pingresp_packet, sizeof(pingresp_packet));
+         return true;
+      }
+      default:
+         // DISCONNECT or not supported
+         return false;
+   }
+}
+
+static void *serve(void *argument) {
+   mqtt_broker_t *broker = argument;
+   unsigned char packet[MQTT_BROKER_PACKET_SIZE];
+
+   for (;;) {
+      int socket_id = accept(broker->listen_socket_id, NULL, NULL);
+
+      if (socket_id < 0) {
+         return NULL;
+      }
+
+      int no_delay = 1;
+      size_t length;
+      int fixed_header;
+
+      setsockopt(socket_id, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+      while ((fixed_header = receive_packet(socket_id, packet, &length)) >= 0 &&
+            handle_packet(broker, socket_id, fixed_header, packet, length)) {
+      }
+
+      pthread_mutex_lock(&broker->mutex);
+      broker->client_socket_id = -1;
+      pthread_mutex_unlock(&broker->mutex);
+      close(socket_id);
+   }
+}
+
+bool mqtt_broker_start(mqtt_broker_t *broker) {
+   struct sockaddr_in address;
+   socklen_t address_length = sizeof(address);
+
+   memset(broker, 0, sizeof(mqtt_broker_t));
+   broker->client_socket_id = -1;
+   pthread_mutex_init(&broker->mutex, NULL);
+   broker->listen_socket_id = socket(AF_INET, SOCK_STREAM, 0);
+
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if (broker->listen_socket_id < 0 ||
+         bind(broker->listen_socket_id, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+         listen(broker->listen_socket_id, 4) != 0 ||
+         getsockname(broker->listen_socket_id, (struct sockaddr *) &address, &address_length) != 0) {
+      return false;
+   }
+   broker->port = ntohs(address.sin_port);
+   return pthread_create(&broker->thread, NULL, serve, broker) == 0;
+}
+
+void mqtt_broker_stop(mqtt_broker_t *broker) {
+   mqtt_broker_drop_connection(broker);
+   shutdown(broker->listen_socket_id, SHUT_RDWR);
+   close(broker->listen_socket_id);
+   pthread_join(broker->thread, NULL);
+   pthread_mutex_destroy(&broker->mutex);
+}
+
+bool mqtt_broker_publish(mqtt_broker_t *broker, const char *topic, const char *payload, unsigned char qos) {
+   mqtt_broker_message_t message;
+
+   memset(&message, 0, sizeof(message));
+   if (strlen(topic) >= MQTT_BROKER_TOPIC_SIZE || strlen(payload) > MQTT_BROKER_PAYLOAD_SIZE) {
+      return false;
+   }
+   strcpy(message.topic, topic);
+   message.payload_length = strlen(payload);
+   memcpy(message.payload, payload, message.payload_length);
+
+   pthread_mutex_lock(&broker->mutex);
+   // The QoS is downgraded to the subscribed one
+   message.qos = qos < broker->subscription_qos ? qos : broker->subscription_qos;
+
+   bool published = strcmp(broker->subscription, topic) == 0 &&
+         (message.qos == 0 || broker->queue_length < MQTT_BROKER_QUEUE_SIZE);
+
+   if (published && message.qos > 0) {
+      // 0 isn't allowed
+      broker->packet_id = broker->packet_id == 0xFFFF ? 1 : broker->packet_id + 1;
+      message.packet_id = broker->packet_id;
+      broker->queue[broker->queue_length++] = message;
+   }
+   // QoS 0 messages are lost while the client is disconnected
+   if (published && broker->client_socket_id >= 0) {
+      send_message(broker, &message);
+   }
+   pthread_mutex_unlock(&broker->mutex);
+   return published;
+}
+
+void mqtt_broker_drop_connection(mqtt_broker_t *broker) {
+   pthread_mutex_lock(&broker->mutex);
+   if (broker->client_socket_id >= 0) {
+      shutdown(broker->client_socket_id, SHUT_RDWR);
+   }
+   pthread_mutex_unlock(&broker->mutex);
+}
+
+void mqtt_broker_set_drop_pubacks(mqtt_broker_t *broker, bool drop_pubacks) {
+   pthread_mutex_lock(&broker->mutex);
+   broker->drop_pubacks = drop_pubacks;
+   pthread_mutex_unlock(&broker->mutex);
+}
+
+mqtt_broker_statistics_t mqtt_broker_get_statistics(mqtt_broker_t *broker) {
+   mqtt_broker_statistics_t statistics;
+
+   pthread_mutex_lock(&broker->mutex);
+   statistics.connected = broker->client_socket_id >= 0;
+   statistics.connections = broker->connections;
+   statistics.clean_session = broker->clean_session;
+   statistics.session_present = broker->session_present;
+   strcpy(statistics.client_id, broker->client_id);
+   strcpy(statistics.subscription, broker->subscription);
+   statistics.subscription_qos = broker->subscription_qos;
+   statistics.publishes = broker->publishes;
+   statistics.pubacks = broker->pubacks;
+   statistics.unacknowledged = broker->queue_length;
+   statistics.pings = broker->pings;
+   pthread_mutex_unlock(&broker->mutex);
+   return statistics;
+}
+
+mqtt_broker_message_t mqtt_broker_get_last_message(mqtt_broker_t *broker) {
+   pthread_mutex_lock(&broker->mutex);
+   mqtt_broker_message_t message = broker->last_message;
+   pthread_mutex_unlock(&broker->mutex);
+   return message;
+}
@@ -0,0 +1,82 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifndef MQTT_BROKER_HEADER
+#define MQTT_BROKER_HEADER
+
+#define MQTT_BROKER_PACKET_SIZE  512
+#define MQTT_BROKER_TOPIC_SIZE   64
+#define MQTT_BROKER_PAYLOAD_SIZE 256
+// Not acknowledged QoS 1 messages to the client
+#define MQTT_BROKER_QUEUE_SIZE   4
+
+typedef struct {
+   char topic[MQTT_BROKER_TOPIC_SIZE];
+   unsigned char payload[MQTT_BROKER_PAYLOAD_SIZE];
+   size_t payload_length;
+   unsigned char qos;
+   bool duplicate;
+   unsigned short packet_id;
+} mqtt_broker_message_t;
+
+/**
+ * Stand-in for the MQTT 3.1.1 broker on 127.0.0.1, port is chosen by the system. One client at a time with one
+ * subscription (exact topic, no wildcards), QoS 0 and 1. The session of the client which doesn't ask for a clean
+ * one is kept over the connections: the subscription and the not acknowledged QoS 1 messages, which are sent again
+ * with the DUP flag after the reconnection.
+ */
+typedef struct {
+   int listen_socket_id;
+   unsigned short port;
+   pthread_t thread;
+   pthread_mutex_t mutex;
+   // -1 while no client is connected
+   int client_socket_id;
+   // The PUBLISH packets of the client aren't acknowledged
+   bool drop_pubacks;
+   bool session_stored;
+   char client_id[MQTT_BROKER_TOPIC_SIZE];
+   char subscription[MQTT_BROKER_TOPIC_SIZE];
+   unsigned char subscription_qos;
+   unsigned short packet_id;
+   mqtt_broker_message_t queue[MQTT_BROKER_QUEUE_SIZE];
+   unsigned int queue_length;
+   // Statistics, read them with mqtt_broker_get_statistics()
+   unsigned int connections;
+   bool clean_session;
+   bool session_present;
+   unsigned int publishes;
+   unsigned int pubacks;
+   unsigned int pings;
+   mqtt_broker_message_t last_message;
+} mqtt_broker_t;
+
+typedef struct {
+   bool connected;
+   unsigned int connections;
+   // Of the last CONNECT and its CONNACK
+   bool clean_session;
+   bool session_present;
+   char client_id[MQTT_BROKER_TOPIC_SIZE];
+   char subscription[MQTT_BROKER_TOPIC_SIZE];
+   unsigned char subscription_qos;
+   // Received PUBLISH packets, duplicates included
+   unsigned int publishes;
+   // Received PUBACK packets and QoS 1 messages still waiting for them
+   unsigned int pubacks;
+   unsigned int unacknowledged;
+   unsigned int pings;
+} mqtt_broker_statistics_t;
+
+bool mqtt_broker_start(mqtt_broker_t *broker);
+void mqtt_broker_stop(mqtt_broker_t *broker);
+// Returns false if the topic isn't subscribed or the queue is full. QoS 1 messages are queued until acknowledged
+bool mqtt_broker_publish(mqtt_broker_t *broker, const char *topic, const char *payload, unsigned char qos);
+// Closes the connection without DISCONNECT, as on a network failure
+void mqtt_broker_drop_connection(mqtt_broker_t *broker);
+void mqtt_broker_set_drop_pubacks(mqtt_broker_t *broker, bool drop_pubacks);
+mqtt_broker_statistics_t mqtt_broker_get_statistics(mqtt_broker_t *broker);
+mqtt_broker_message_t mqtt_broker_get_last_message(mqtt_broker_t *broker);
+
+#endif
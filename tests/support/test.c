@@ -0,0 +1,3 @@
+#include "test.h"
+
+unsigned int test_failures_g;
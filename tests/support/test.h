@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifndef TEST_HEADER
+#define TEST_HEADER
+
+/**
+ * Minimal test helpers: failed checks are reported and counted, the test binary returns the result of TEST_RESULT().
+ */
+extern unsigned int test_failures_g;
+
+#define CHECK(condition) do { \
+   if (!(condition)) { \
+      test_failures_g++; \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+   } \
+} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+   long long expected_value = (long long) (expected); \
+   long long actual_value = (long long) (actual); \
+   if (expected_value != actual_value) { \
+      test_failures_g++; \
+      fprintf(stderr, "%s:%d: %s == %lld expected, %lld found\n", __FILE__, __LINE__, #actual, expected_value, \
+            actual_value); \
+   } \
+} while (0)
+
+#define CHECK_STRING(expected, actual) do { \
+   const char *expected_string = (expected); \
+   const char *actual_string = (actual); \
+   if (actual_string == NULL || strcmp(expected_string, actual_string) != 0) { \
+      test_failures_g++; \
+      fprintf(stderr, "%s:%d: %s == \"%s\" expected, \"%s\" found\n", __FILE__, __LINE__, #actual, expected_string, \
+            actual_string == NULL ? "(null)" : actual_string); \
+   } \
+} while (0)
+
+#define TEST_RESULT() (printf("%s: %s\n", __FILE__, test_failures_g == 0 ? "OK" : "FAILED"), test_failures_g == 0 ? 0 : 1)
+
+#endif
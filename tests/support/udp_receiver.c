@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "udp_receiver.h"
+
+#define DATAGRAM_BUFFER_SIZE 1500
+// The receiving thread checks whether the receiver is stopped so often
+#define RECEIVE_TIMEOUT_US   50000
+
+static void on_status_datagram(udp_receiver_t *receiver, unsigned int sequence, const status_record_t *record) {
+   receiver->received++;
+   receiver->last_record = *record;
+
+   if (!receiver->sequence_started) {
+      receiver->sequence_started = true;
+      receiver->first_sequence = sequence;
+      receiver->last_sequence = sequence;
+   }
+   if (sequence - receiver->first_sequence >= UDP_RECEIVER_MAX_SEQUENCES) {
+      return;
+   }
+
+   unsigned int index = sequence - receiver->first_sequence;
+
+   if (receiver->received_sequences[index / 8] & (1 << (index % 8))) {
+      receiver->duplicates++;
+   }
+   receiver->received_sequences[index / 8] |= 1 << (index % 8);
+   if (sequence > receiver->last_sequence) {
+      receiver->last_sequence = sequence;
+   }
+}
+
+static void *receive(void *argument) {
+   udp_receiver_t *receiver = argument;
+   unsigned char datagram[DATAGRAM_BUFFER_SIZE];
+   char strings[sizeof(receiver->last_record_strings)];
+
+   while (!__atomic_load_n(&receiver->stopping, __ATOMIC_SEQ_CST)) {
+      struct sockaddr_in source_address;
+      socklen_t source_address_length = sizeof(source_address);
+      ssize_t length = recvfrom(receiver->socket_id, datagram, sizeof(datagram), 0,
+            (struct sockaddr *) &source_address, &source_address_length);
+
+      if (length <= 0) {
+         continue;
+      }
+
+      unsigned int sequence;
+      status_record_t record;
+
+      pthread_mutex_lock(&receiver->mutex);
+      if (receiver->drop_percent > 0 && (unsigned int) rand_r(&receiver->random_seed) % 100 < receiver->drop_percent) {
+         receiver->dropped++;
+         pthread_mutex_unlock(&receiver->mutex);
+         continue;
+      }
+      if (!decode_status_datagram(datagram, length, &sequence, &record, strings, sizeof(strings))) {
+         receiver->invalid++;
+         pthread_mutex_unlock(&receiver->mutex);
+         continue;
+      }
+
+      // The strings of the last record are kept in the receiver
+      memcpy(receiver->last_record_strings, strings, sizeof(strings));
+      const char **string_fields[] = {&record.device_name, &record.build_timestamp, &record.reset_reason,
+            &record.system_restart_reason, &record.boot_timeline};
+
+      for (unsigned int i = 0; i < sizeof(string_fields) / sizeof(string_fields[0]); i++) {
+         if (*string_fields[i] != NULL) {
+            *string_fields[i] = receiver->last_record_strings + (*string_fields[i] - strings);
+         }
+      }
+      on_status_datagram(receiver, sequence, &record);
+
+      unsigned char reply[STATUS_DATAGRAM_REPLY_SIZE];
+      unsigned short reply_length = encode_status_datagram_reply(sequence, receiver->commands, reply);
+      pthread_mutex_unlock(&receiver->mutex);
+
+      sendto(receiver->socket_id, reply, reply_length, 0, (struct sockaddr *) &source_address, source_address_length);
+   }
+   return NULL;
+}
+
+bool udp_receiver_start(udp_receiver_t *receiver, unsigned int drop_percent, unsigned int random_seed) {
+   struct sockaddr_in address;
+   socklen_t address_length = sizeof(address);
+   struct timeval receive_timeout = {0, RECEIVE_TIMEOUT_US};
+
+   memset(receiver, 0, sizeof(udp_receiver_t));
+   receiver->drop_percent = drop_percent;
+   receiver->random_seed = random_seed;
+   pthread_mutex_init(&receiver->mutex, NULL);
+   receiver->socket_id = socket(AF_INET, SOCK_DGRAM, 0);
+
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if (receiver->socket_id < 0 ||
+         bind(receiver->socket_id, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+         getsockname(receiver->socket_id, (struct sockaddr *) &address, &address_length) != 0 ||
+         setsockopt(receiver->socket_id, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout)) != 0) {
+      return false;
+   }
+   receiver->port = ntohs(address.sin_port);
+   return pthread_create(&receiver->thread, NULL, receive, receiver) == 0;
+}
+
+void udp_receiver_stop(udp_receiver_t *receiver) {
+   __atomic_store_n(&receiver->stopping, true, __ATOMIC_SEQ_CST);
+   pthread_join(receiver->thread, NULL);
+   close(receiver->socket_id);
+   pthread_mutex_destroy(&receiver->mutex);
+}
+
+void udp_receiver_set_drop_percent(udp_receiver_t *receiver, unsigned int drop_percent) {
+   pthread_mutex_lock(&receiver->mutex);
+   receiver->drop_percent = drop_percent;
+   pthread_mutex_unlock(&receiver->mutex);
+}
+
+udp_receiver_statistics_t udp_receiver_get_statistics(udp_receiver_t *receiver) {
+   udp_receiver_statistics_t statistics;
+
+   pthread_mutex_lock(&receiver->mutex);
+   statistics.received = receiver->received;
+   statistics.dropped = receiver->dropped;
+   statistics.invalid = receiver->invalid;
+   statistics.duplicates = receiver->duplicates;
+   statistics.lost = 0;
+   if (receiver->sequence_started) {
+      unsigned int tracked = receiver->last_sequence - receiver->first_sequence + 1;
+
+      for (unsigned int i = 0; i < tracked && i < UDP_RECEIVER_MAX_SEQUENCES; i++) {
+         statistics.lost += !(receiver->received_sequences[i / 8] & (1 << (i % 8)));
+      }
+   }
+   pthread_mutex_unlock(&receiver->mutex);
+   return statistics;
+}
+
+status_record_t udp_receiver_get_last_record(udp_receiver_t *receiver) {
+   pthread_mutex_lock(&receiver->mutex);
+   status_record_t record = receiver->last_record;
+   pthread_mutex_unlock(&receiver->mutex);
+   return record;
+}
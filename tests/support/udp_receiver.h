@@ -0,0 +1,55 @@
+#include <stdbool.h>
+#include <pthread.h>
+#include "status_record.h"
+
+#ifndef UDP_RECEIVER_HEADER
+#define UDP_RECEIVER_HEADER
+
+// Sequence numbers from the first received one, which are tracked for duplicates and losses
+#define UDP_RECEIVER_MAX_SEQUENCES 4096
+
+/**
+ * Stand-in for the status datagram collector on 127.0.0.1, port is chosen by the system. Every valid status
+ * datagram is answered with the reply carrying "commands". Loss is simulated by dropping drop_percent of the received
+ * datagrams before they are counted, the collector detects them by the gaps in the sequence numbers.
+ */
+typedef struct {
+   int socket_id;
+   unsigned short port;
+   pthread_t thread;
+   bool stopping;
+   unsigned char commands;
+   unsigned int drop_percent;
+   unsigned int random_seed;
+   pthread_mutex_t mutex;
+   // Statistics, read them with udp_receiver_get_statistics()
+   unsigned int received;
+   unsigned int dropped;
+   unsigned int invalid;
+   unsigned int duplicates;
+   bool sequence_started;
+   unsigned int first_sequence;
+   unsigned int last_sequence;
+   unsigned char received_sequences[UDP_RECEIVER_MAX_SEQUENCES / 8];
+   status_record_t last_record;
+   char last_record_strings[5 * (STATUS_RECORD_MAX_STRING_SIZE + 1)];
+} udp_receiver_t;
+
+typedef struct {
+   // Valid status datagrams, duplicates included
+   unsigned int received;
+   unsigned int dropped;
+   unsigned int invalid;
+   unsigned int duplicates;
+   // Sequence numbers between the first and the last received one, which never arrived
+   unsigned int lost;
+} udp_receiver_statistics_t;
+
+bool udp_receiver_start(udp_receiver_t *receiver, unsigned int drop_percent, unsigned int random_seed);
+void udp_receiver_stop(udp_receiver_t *receiver);
+void udp_receiver_set_drop_percent(udp_receiver_t *receiver, unsigned int drop_percent);
+udp_receiver_statistics_t udp_receiver_get_statistics(udp_receiver_t *receiver);
+// Copy of the last received record, the strings point into the receiver
+status_record_t udp_receiver_get_last_record(udp_receiver_t *receiver);
+
+#endif
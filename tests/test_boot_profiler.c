@@ -0,0 +1,61 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "boot_profiler.h"
+#include "host_shims.h"
+#include "test.h"
+
+/**
+ * The phase times are kept for the whole run, so the tests follow one boot.
+ */
+static void test_timeline() {
+   char timeline[BOOT_PROFILER_TIMELINE_MAX_LENGTH];
+
+   CHECK_EQUAL(0, boot_profiler_format_timeline(timeline, sizeof(timeline)));
+   CHECK_STRING("", timeline);
+
+   // The phase reached at 0 ms is still marked as reached
+   boot_profiler_mark(BOOT_PHASE_START);
+   CHECK_EQUAL(1, boot_profiler_get_time(BOOT_PHASE_START));
+
+   vTaskDelay(9);
+   boot_profiler_mark(BOOT_PHASE_PINS);
+   vTaskDelay(1);
+   boot_profiler_mark(BOOT_PHASE_UART);
+   vTaskDelay(200);
+   boot_profiler_mark(BOOT_PHASE_GOT_IP);
+
+   CHECK_EQUAL(90, boot_profiler_get_time(BOOT_PHASE_PINS));
+   CHECK_EQUAL(0, boot_profiler_get_time(BOOT_PHASE_WIFI_START));
+   CHECK_EQUAL(strlen("start:1,pins:90,uart:100,ip:2100"), boot_profiler_format_timeline(timeline, sizeof(timeline)));
+   CHECK_STRING("start:1,pins:90,uart:100,ip:2100", timeline);
+}
+
+static void test_only_first_mark_is_kept() {
+   unsigned int time_ms = boot_profiler_get_time(BOOT_PHASE_FIRST_SENSOR_READ);
+
+   CHECK_EQUAL(0, time_ms);
+   boot_profiler_mark(BOOT_PHASE_FIRST_SENSOR_READ);
+   time_ms = boot_profiler_get_time(BOOT_PHASE_FIRST_SENSOR_READ);
+   vTaskDelay(100);
+   boot_profiler_mark(BOOT_PHASE_FIRST_SENSOR_READ);
+   CHECK_EQUAL(time_ms, boot_profiler_get_time(BOOT_PHASE_FIRST_SENSOR_READ));
+}
+
+static void test_small_buffer() {
+   char timeline[20];
+
+   // "start:1,pins:90" fits, ",uart:100" doesn't, the next phases are skipped
+   CHECK_EQUAL(15, boot_profiler_format_timeline(timeline, sizeof(timeline)));
+   CHECK_STRING("start:1,pins:90", timeline);
+
+   CHECK_EQUAL(0, boot_profiler_format_timeline(timeline, 5));
+   CHECK_STRING("", timeline);
+}
+
+int main() {
+   test_timeline();
+   test_only_first_mark_is_kept();
+   test_small_buffer();
+   return TEST_RESULT();
+}
@@ -0,0 +1,71 @@
+#include <string.h>
+#include "utils.h"
+#include "deep_sleep_state.h"
+#include "host_shims.h"
+#include "test.h"
+
+#define RTC_ADDRESS 179
+
+static void test_save_and_load() {
+   deep_sleep_state_t state = {
+      .access_point_channel = 6,
+      .access_point_bssid = {1, 2, 3, 4, 5, 6},
+      .wakes_amount = 12345,
+      .device_time = 987654,
+      .awake_time_ms = 1234,
+      .previous_cycle_awake_time_ms = 5678,
+      .first_report_confirmed = true,
+      .reset_reason = ESP_RST_BROWNOUT
+   };
+   deep_sleep_state_t loaded_state;
+
+   shim_clear_rtc_memory();
+   CHECK(!deep_sleep_state_load(&loaded_state, RTC_ADDRESS));
+   CHECK_EQUAL(0, loaded_state.wakes_amount);
+
+   deep_sleep_state_save(&state, RTC_ADDRESS);
+   CHECK(deep_sleep_state_load(&loaded_state, RTC_ADDRESS));
+   CHECK_EQUAL(6, loaded_state.access_point_channel);
+   CHECK(memcmp(state.access_point_bssid, loaded_state.access_point_bssid, 6) == 0);
+   CHECK_EQUAL(12345, loaded_state.wakes_amount);
+   CHECK_EQUAL(987654, loaded_state.device_time);
+   // 10 ms units
+   CHECK_EQUAL(1230, loaded_state.awake_time_ms);
+   CHECK_EQUAL(5670, loaded_state.previous_cycle_awake_time_ms);
+   CHECK(loaded_state.first_report_confirmed);
+   CHECK_EQUAL(ESP_RST_BROWNOUT, loaded_state.reset_reason);
+
+   state.awake_time_ms = 0xFFFFFFFF;
+   deep_sleep_state_save(&state, RTC_ADDRESS);
+   CHECK(deep_sleep_state_load(&loaded_state, RTC_ADDRESS));
+   CHECK_EQUAL(0xFFFF * 10, loaded_state.awake_time_ms);
+
+   state.first_report_confirmed = false;
+   deep_sleep_state_save(&state, RTC_ADDRESS);
+   CHECK(deep_sleep_state_load(&loaded_state, RTC_ADDRESS));
+   CHECK(!loaded_state.first_report_confirmed);
+}
+
+static void test_corrupted_state_is_rejected() {
+   deep_sleep_state_t state = {.wakes_amount = 1};
+   unsigned int block;
+
+   // The flags are covered by the CRC
+   deep_sleep_state_save(&state, RTC_ADDRESS);
+   rtc_mem_read(RTC_ADDRESS, &block, 4);
+   block ^= DEEP_SLEEP_STATE_FIRST_REPORT_CONFIRMED_FLAG << 24;
+   rtc_mem_write(RTC_ADDRESS, &block, 4);
+   CHECK(!deep_sleep_state_load(&state, RTC_ADDRESS));
+
+   deep_sleep_state_save(&state, RTC_ADDRESS);
+   rtc_mem_read(RTC_ADDRESS + 3, &block, 4);
+   block ^= 0x100;
+   rtc_mem_write(RTC_ADDRESS + 3, &block, 4);
+   CHECK(!deep_sleep_state_load(&state, RTC_ADDRESS));
+}
+
+int main() {
+   test_save_and_load();
+   test_corrupted_state_is_rejected();
+   return TEST_RESULT();
+}
@@ -0,0 +1,375 @@
+#include <stdlib.h>
+#include <string.h>
+#include "http_response_parser.h"
+#include "test.h"
+
+#define BODY_BUFFER_SIZE 512
+
+typedef struct {
+   char body[BODY_BUFFER_SIZE];
+   size_t body_length;
+   size_t input_length;
+} body_t;
+
+typedef struct {
+   http_parser_state_t state;
+   unsigned short status_code;
+   bool content_length_present;
+   bool chunked;
+   bool connection_close;
+   unsigned int content_length;
+   bool content_range_present;
+   unsigned int range_start;
+   unsigned int range_total;
+   unsigned int etag_hash;
+   unsigned char sha256_digits;
+   unsigned char sha256[HTTP_RESPONSE_PARSER_SHA256_SIZE];
+   size_t consumed;
+   body_t body;
+} parse_result_t;
+
+typedef struct {
+   const char *response;
+   http_parser_state_t state;
+   unsigned short status_code;
+   const char *body;
+   // Bytes after the end of the response, which aren't consumed
+   size_t extra_bytes;
+} response_case_t;
+
+static const response_case_t RESPONSES[] = {
+   {"HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 31\r\n\r\n"
+         "{\"statusCode\":\"OK\",\"update\":no}", HTTP_PARSER_DONE, 200, "{\"statusCode\":\"OK\",\"update\":no}", 0},
+   {"HTTP/1.1 200 OK\r\ncontent-length:2\r\n\r\nokHTTP/1.1", HTTP_PARSER_DONE, 200, "ok", 8},
+   {"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nWiki\r\n5;name=value\r\npedia\r\nE\r\n in\r\n\r\nchunks."
+         "\r\n0\r\nExpires: never\r\n\r\n", HTTP_PARSER_DONE, 200, "Wikipedia in\r\n\r\nchunks.", 0},
+   {"HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 201 Created\r\nCONTENT-LENGTH: 3\r\n\r\nnew", HTTP_PARSER_DONE, 201, "new",
+         0},
+   {"HTTP/1.1 204 No Content\r\nContent-Length: 10\r\n\r\n", HTTP_PARSER_DONE, 204, "", 0},
+   {"HTTP/1.0 200 OK\nConnection: close\n\nbody until close", HTTP_PARSER_BODY_UNTIL_CLOSE, 200, "body until close",
+         0},
+   {"HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n", HTTP_PARSER_DONE, 500, "", 0},
+   {"HTTP/1.1 2x0 OK\r\n\r\n", HTTP_PARSER_ERROR, 0, "", 0},
+   {"HTTP/1.1 200 OK\r\nContent-Length: 1a\r\n\r\n", HTTP_PARSER_ERROR, 200, "", 0},
+   {"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nz\r\n", HTTP_PARSER_ERROR, 200, "", 0},
+   {"ICY 200 OK\r\nContent-Length: 2\r\n\r\nok", HTTP_PARSER_ERROR, 0, "", 0},
+   {"http/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok", HTTP_PARSER_ERROR, 0, "", 0},
+   {"HTTP/1.1 200 OK\r\nContent-Length: \t 2 \r\n\r\nok", HTTP_PARSER_DONE, 200, "ok", 0},
+   {"HTTP/1.1 200 OK\r\nContent-Length: 1 2\r\n\r\nok", HTTP_PARSER_ERROR, 200, "", 0},
+   {"HTTP/1.1 200 OK\r\nTransfer-Encoding: notchunked\r\nContent-Length: 2\r\n\r\nok", HTTP_PARSER_DONE, 200, "ok",
+         0},
+   {"HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip ,  Chunked \r\n\r\n2\r\nok\r\n0\r\n\r\n", HTTP_PARSER_DONE, 200,
+         "ok", 0},
+   {"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked, gzip\r\n\r\n2\r\nok", HTTP_PARSER_BODY_UNTIL_CLOSE, 200,
+         "2\r\nok", 0}
+};
+
+#define FIRMWARE_SHA256 "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08"
+
+/**
+ * Firmware responses as nginx, Apache and a small embedded server send them
+ */
+static const char *FIRMWARE_RESPONSES[] = {
+   "HTTP/1.1 200 OK\r\nServer: nginx/1.18.0 (Ubuntu)\r\nDate: Sat, 17 Oct 2026 10:00:00 GMT\r\n"
+         "Content-Type: application/octet-stream\r\nContent-Length: 8\r\n"
+         "Last-Modified: Fri, 16 Oct 2026 08:00:00 GMT\r\nConnection: keep-alive\r\n"
+         "ETag: \"6a1f3c00-2e800\"\r\nX-Firmware-SHA256: " FIRMWARE_SHA256 "\r\nAccept-Ranges: bytes\r\n\r\n"
+         "\xE9\x03\x02\x20\x01\x02\x10\x40",
+   "HTTP/1.1 206 Partial Content\r\nServer: nginx/1.18.0 (Ubuntu)\r\nDate: Sat, 17 Oct 2026 10:00:00 GMT\r\n"
+         "Content-Type: application/octet-stream\r\nContent-Length: 4\r\n"
+         "ETag: \"6a1f3c00-2e800\"\r\nX-Firmware-SHA256: " FIRMWARE_SHA256 "\r\n"
+         "Content-Range: bytes 4096-4099/190464\r\n\r\n\x01\x10\x40\x02",
+   "HTTP/1.1 206 Partial Content\r\nDate: Sat, 17 Oct 2026 10:00:00 GMT\r\nServer: Apache/2.4.57 (Debian)\r\n"
+         "Last-Modified: Fri, 16 Oct 2026 08:00:00 GMT\r\nETag: \"6a1f3c00-2e800\"\r\nAccept-Ranges: bytes\r\n"
+         "x-firmware-sha256: " FIRMWARE_SHA256 "\r\nContent-Range: bytes 190460-190463/190464\r\n"
+         "Keep-Alive: timeout=5, max=100\r\nConnection: Keep-Alive\r\nTransfer-Encoding: chunked\r\n"
+         "Content-Type: application/octet-stream\r\n\r\n4\r\nabcd\r\n0\r\n\r\n",
+   "HTTP/1.0 200 OK\r\ncontent-type: application/octet-stream\r\netag: \"6a1f3c00-2e800\"\r\n"
+         "x-firmware-sha256: " FIRMWARE_SHA256 "\r\nconnection: close\r\n\r\nfirmware until close",
+   "HTTP/1.1 304 Not Modified\r\nServer: nginx/1.18.0 (Ubuntu)\r\nETag: \"6a1f3c00-2e800\"\r\n"
+         "Connection: close\r\n\r\n"
+};
+
+static void on_body(http_response_parser_t *parser, const char *data, size_t length) {
+   body_t *body = parser->context;
+
+   // The body points into the input
+   CHECK(length <= body->input_length);
+   if (body->body_length + length < BODY_BUFFER_SIZE) {
+      memcpy(body->body + body->body_length, data, length);
+   }
+   body->body_length += length;
+}
+
+/**
+ * The response is passed in pieces, which end at the split offsets
+ */
+static void parse(const char *response, size_t length, const size_t splits[], unsigned int splits_amount,
+                  parse_result_t *result) {
+   http_response_parser_t parser;
+   size_t offset = 0;
+
+   memset(result, 0, sizeof(parse_result_t));
+   result->body.input_length = length;
+   http_response_parser_init(&parser, on_body, &result->body);
+
+   for (unsigned int i = 0; i <= splits_amount; i++) {
+      size_t end = i < splits_amount ? splits[i] : length;
+      size_t consumed = http_response_parser_execute(&parser, response + offset, end - offset);
+
+      CHECK(consumed <= end - offset);
+      result->consumed += consumed;
+      if (consumed < end - offset) {
+         // The response has ended, the rest isn't passed again
+         CHECK(http_response_parser_is_done(&parser) || http_response_parser_is_error(&parser));
+         break;
+      }
+      offset = end;
+   }
+
+   result->state = parser.state;
+   result->status_code = parser.status_code;
+   result->content_length_present = parser.content_length_present;
+   result->chunked = parser.chunked;
+   result->connection_close = parser.connection_close;
+   result->content_length = parser.content_length;
+   result->content_range_present = parser.content_range_present;
+   result->range_start = parser.range_start;
+   result->range_total = parser.range_total;
+   result->etag_hash = parser.etag_hash;
+   result->sha256_digits = parser.sha256_digits;
+   memcpy(result->sha256, parser.sha256, sizeof(result->sha256));
+   result->body.body[result->body.body_length < BODY_BUFFER_SIZE ? result->body.body_length : 0] = '\0';
+}
+
+static bool results_equal(const parse_result_t *expected, const parse_result_t *actual) {
+   return expected->state == actual->state && expected->status_code == actual->status_code &&
+         expected->content_length_present == actual->content_length_present && expected->chunked == actual->chunked &&
+         expected->connection_close == actual->connection_close &&
+         expected->content_length == actual->content_length &&
+         expected->content_range_present == actual->content_range_present &&
+         expected->range_start == actual->range_start && expected->range_total == actual->range_total &&
+         expected->etag_hash == actual->etag_hash && expected->sha256_digits == actual->sha256_digits &&
+         memcmp(expected->sha256, actual->sha256, sizeof(expected->sha256)) == 0 &&
+         (expected->state == HTTP_PARSER_ERROR || (expected->consumed == actual->consumed &&
+         expected->body.body_length == actual->body.body_length &&
+         strcmp(expected->body.body, actual->body.body) == 0));
+}
+
+static void test_responses() {
+   for (unsigned int i = 0; i < sizeof(RESPONSES) / sizeof(RESPONSES[0]); i++) {
+      const response_case_t *response_case = &RESPONSES[i];
+      size_t length = strlen(response_case->response);
+      parse_result_t result;
+
+      parse(response_case->response, length, NULL, 0, &result);
+      CHECK_EQUAL(response_case->state, result.state);
+      if (response_case->state != HTTP_PARSER_ERROR) {
+         CHECK_EQUAL(response_case->status_code, result.status_code);
+         CHECK_STRING(response_case->body, result.body.body);
+         CHECK_EQUAL(length - response_case->extra_bytes, result.consumed);
+      }
+   }
+}
+
+/**
+ * Every response is split at every pair of byte offsets, also into single bytes. The result must not depend on
+ * the split.
+ */
+static void test_splits() {
+   for (unsigned int i = 0; i < sizeof(RESPONSES) / sizeof(RESPONSES[0]); i++) {
+      const char *response = RESPONSES[i].response;
+      size_t length = strlen(response);
+      size_t splits[BODY_BUFFER_SIZE];
+      parse_result_t expected;
+      parse_result_t result;
+      unsigned int mismatches = 0;
+
+      parse(response, length, NULL, 0, &expected);
+
+      for (size_t first = 0; first <= length; first++) {
+         for (size_t second = first; second <= length; second++) {
+            splits[0] = first;
+            splits[1] = second;
+            parse(response, length, splits, 2, &result);
+            mismatches += !results_equal(&expected, &result);
+         }
+      }
+
+      for (size_t j = 0; j < length; j++) {
+         splits[j] = j + 1;
+      }
+      parse(response, length, splits, length, &result);
+      mismatches += !results_equal(&expected, &result);
+
+      if (mismatches > 0) {
+         fprintf(stderr, "Response %u: %u splits give a different result\n", i, mismatches);
+      }
+      CHECK_EQUAL(0, mismatches);
+   }
+}
+
+/**
+ * Mutated responses, parsed whole and byte by byte. The parser must stay consistent (AddressSanitizer catches
+ * out of bounds accesses with SANITIZE=1).
+ */
+static void test_mutations() {
+   static const char MUTATION_CHARACTERS[] = "\r\n :;0123456789abcdefxyzHTP/-*";
+   char response[BODY_BUFFER_SIZE];
+   size_t splits[BODY_BUFFER_SIZE];
+   unsigned int mismatches = 0;
+
+   srand(4);
+   for (unsigned int iteration = 0; iteration < 20000; iteration++) {
+      const char *original = RESPONSES[iteration % (sizeof(RESPONSES) / sizeof(RESPONSES[0]))].response;
+      size_t length = strlen(original);
+      parse_result_t expected;
+      parse_result_t result;
+
+      memcpy(response, original, length);
+      for (unsigned int mutations = 1 + rand() % 4; mutations > 0; mutations--) {
+         response[rand() % length] = rand() % 2 ? MUTATION_CHARACTERS[rand() % (sizeof(MUTATION_CHARACTERS) - 1)] :
+               (char) rand();
+      }
+
+      parse(response, length, NULL, 0, &expected);
+      for (size_t j = 0; j < length; j++) {
+         splits[j] = j + 1;
+      }
+      parse(response, length, splits, length, &result);
+      mismatches += !results_equal(&expected, &result);
+
+      if (expected.state != HTTP_PARSER_ERROR) {
+         CHECK(expected.body.body_length <= length);
+      }
+   }
+   CHECK_EQUAL(0, mismatches);
+}
+
+static unsigned int split_mismatches(const char *response, size_t length, const parse_result_t *expected) {
+   size_t splits[BODY_BUFFER_SIZE];
+   parse_result_t result;
+   unsigned int mismatches = 0;
+
+   for (size_t offset = 0; offset <= length; offset++) {
+      splits[0] = offset;
+      parse(response, length, splits, 1, &result);
+      mismatches += !results_equal(expected, &result);
+   }
+
+   for (size_t j = 0; j < length; j++) {
+      splits[j] = j + 1;
+   }
+   parse(response, length, splits, length, &result);
+   mismatches += !results_equal(expected, &result);
+   return mismatches;
+}
+
+/**
+ * The firmware headers must be the same however the response is split
+ */
+static void test_firmware_responses() {
+   unsigned int etag_hash = 0;
+
+   for (unsigned int i = 0; i < sizeof(FIRMWARE_RESPONSES) / sizeof(FIRMWARE_RESPONSES[0]); i++) {
+      const char *response = FIRMWARE_RESPONSES[i];
+      size_t length = strlen(response);
+      parse_result_t expected;
+
+      parse(response, length, NULL, 0, &expected);
+      CHECK(expected.state == HTTP_PARSER_DONE || expected.state == HTTP_PARSER_BODY_UNTIL_CLOSE);
+      CHECK(expected.etag_hash != 0);
+      if (etag_hash == 0) {
+         etag_hash = expected.etag_hash;
+      }
+      CHECK_EQUAL(etag_hash, expected.etag_hash);
+
+      if (expected.status_code != 304) {
+         CHECK_EQUAL(HTTP_RESPONSE_PARSER_SHA256_SIZE * 2, expected.sha256_digits);
+         CHECK_EQUAL(0x9f, expected.sha256[0]);
+         CHECK_EQUAL(0x08, expected.sha256[HTTP_RESPONSE_PARSER_SHA256_SIZE - 1]);
+      }
+      CHECK_EQUAL(expected.status_code == 206, expected.content_range_present);
+      if (expected.status_code == 206) {
+         CHECK_EQUAL(190464, expected.range_total);
+      }
+
+      unsigned int mismatches = split_mismatches(response, length, &expected);
+
+      if (mismatches > 0) {
+         fprintf(stderr, "Firmware response %u: %u splits give a different result\n", i, mismatches);
+      }
+      CHECK_EQUAL(0, mismatches);
+   }
+
+   parse_result_t result;
+
+   parse(FIRMWARE_RESPONSES[1], strlen(FIRMWARE_RESPONSES[1]), NULL, 0, &result);
+   CHECK_EQUAL(4096, result.range_start);
+   CHECK_STRING("\x01\x10\x40\x02", result.body.body);
+   parse(FIRMWARE_RESPONSES[2], strlen(FIRMWARE_RESPONSES[2]), NULL, 0, &result);
+   CHECK_EQUAL(190460, result.range_start);
+   CHECK(result.chunked);
+   CHECK_STRING("abcd", result.body.body);
+}
+
+static void test_header_values() {
+   parse_result_t result;
+   const char *response = "HTTP/1.1 200 OK\r\nConnection: keep-alive, Close\r\nContent-Length: 0\r\n\r\n";
+
+   parse(response, strlen(response), NULL, 0, &result);
+   CHECK(result.connection_close);
+
+   response = "HTTP/1.1 200 OK\r\nConnection: closed\r\nContent-Length: 0\r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &result);
+   CHECK(!result.connection_close);
+
+   response = "HTTP/1.1 200 OK\r\nConnection: clo se\r\nContent-Length: 0\r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &result);
+   CHECK(!result.connection_close);
+
+   // Only the surrounding whitespace of the value is trimmed
+   parse_result_t spaced;
+
+   response = "HTTP/1.1 304 Not Modified\r\nETag: \"6a1f3c00-2e800\"\r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &result);
+   response = "HTTP/1.1 304 Not Modified\r\nETag:\t \"6a1f3c00-2e800\" \r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &spaced);
+   CHECK_EQUAL(result.etag_hash, spaced.etag_hash);
+   response = "HTTP/1.1 304 Not Modified\r\nETag: \"6a1f3c00 2e800\"\r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &spaced);
+   CHECK(result.etag_hash != spaced.etag_hash);
+
+   response = "HTTP/1.1 200 OK\r\nX-Firmware-SHA256: " FIRMWARE_SHA256 " \r\nContent-Length: 0\r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &result);
+   CHECK_EQUAL(HTTP_RESPONSE_PARSER_SHA256_SIZE * 2, result.sha256_digits);
+   response = "HTTP/1.1 200 OK\r\nX-Firmware-SHA256: 9f86 d081\r\nContent-Length: 0\r\n\r\n";
+   parse(response, strlen(response), NULL, 0, &result);
+   CHECK_EQUAL(0xFF, result.sha256_digits);
+}
+
+static void test_finish() {
+   http_response_parser_t parser;
+   const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort";
+
+   http_response_parser_init(&parser, NULL, NULL);
+   http_response_parser_execute(&parser, response, strlen(response));
+   // The connection has been closed before the end of the body
+   CHECK(!http_response_parser_finish(&parser));
+
+   response = "HTTP/1.1 200 OK\r\n\r\nuntil close";
+   http_response_parser_init(&parser, NULL, NULL);
+   http_response_parser_execute(&parser, response, strlen(response));
+   CHECK(!http_response_parser_is_done(&parser));
+   CHECK(http_response_parser_finish(&parser));
+}
+
+int main() {
+   test_responses();
+   test_splits();
+   test_mutations();
+   test_firmware_responses();
+   test_header_values();
+   test_finish();
+   return TEST_RESULT();
+}
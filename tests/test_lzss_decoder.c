@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+#include "lzss_decoder.h"
+#include "lzss_encoder.h"
+#include "test.h"
+
+#define MAX_IMAGE_LENGTH (5 * LZSS_BLOCK_SIZE + 1234)
+
+typedef struct {
+   unsigned char image[MAX_IMAGE_LENGTH];
+   size_t length;
+   unsigned int blocks;
+   // Position to resume from after the second block
+   unsigned int resume_input_position;
+   unsigned int resume_decoded_length;
+} decoded_image_t;
+
+static unsigned char image_g[MAX_IMAGE_LENGTH];
+static unsigned char packed_g[LZSS_ENCODED_BOUND(MAX_IMAGE_LENGTH)];
+static unsigned char block_g[LZSS_BLOCK_SIZE];
+
+static void on_block(lzss_decoder_t *decoder, const unsigned char *data, size_t length) {
+   decoded_image_t *decoded_image = decoder->context;
+
+   // Every block but the last one fills a flash sector
+   CHECK(length > 0 && length <= LZSS_BLOCK_SIZE);
+   if (decoded_image->length + length <= MAX_IMAGE_LENGTH) {
+      memcpy(decoded_image->image + decoded_image->length, data, length);
+   }
+   decoded_image->length += length;
+   decoded_image->blocks++;
+   if (decoded_image->blocks == 2) {
+      decoded_image->resume_input_position = decoder->input_position;
+      decoded_image->resume_decoded_length = decoder->decoded_length;
+   }
+}
+
+static bool decode(lzss_decoder_t *decoder, const unsigned char *packed, size_t packed_length, size_t chunk_size) {
+   for (size_t offset = 0; offset < packed_length; offset += chunk_size) {
+      size_t length = packed_length - offset < chunk_size ? packed_length - offset : chunk_size;
+
+      if (lzss_decoder_execute(decoder, packed + offset, length) != length) {
+         return false;
+      }
+   }
+   return lzss_decoder_is_complete(decoder);
+}
+
+/**
+ * Firmware like data: repeated instruction patterns, strings and not compressible constants
+ */
+static void fill_image(size_t length, unsigned int kind) {
+   static const char TEXT[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n{\"deviceName\":\"<1>\",";
+
+   for (size_t i = 0; i < length; i++) {
+      switch (kind) {
+         case 0:
+            image_g[i] = rand();
+            break;
+         case 1:
+            image_g[i] = 0;
+            break;
+         case 2:
+            image_g[i] = TEXT[i % (sizeof(TEXT) - 1)];
+            break;
+         default:
+            image_g[i] = (i / 64) % 3 == 0 ? rand() : (unsigned char) (i * 7 + (i >> 5));
+            break;
+      }
+   }
+}
+
+static void test_round_trip() {
+   static const size_t LENGTHS[] = {1, 2, 100, LZSS_BLOCK_SIZE - 1, LZSS_BLOCK_SIZE, LZSS_BLOCK_SIZE + 1,
+         MAX_IMAGE_LENGTH};
+   static const size_t CHUNK_SIZES[] = {1, 7, 1460, LZSS_ENCODED_BOUND(MAX_IMAGE_LENGTH)};
+   static decoded_image_t decoded_image;
+
+   srand(24);
+   for (unsigned int kind = 0; kind < 4; kind++) {
+      for (unsigned int i = 0; i < sizeof(LENGTHS) / sizeof(LENGTHS[0]); i++) {
+         size_t length = LENGTHS[i];
+
+         fill_image(length, kind);
+         size_t packed_length = lzss_encode(image_g, length, packed_g);
+
+         CHECK(packed_length <= LZSS_ENCODED_BOUND(length));
+         if (kind == 1 || kind == 2) {
+            CHECK(length < LZSS_BLOCK_SIZE || packed_length < length / 4);
+         }
+
+         for (unsigned int j = 0; j < sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]); j++) {
+            lzss_decoder_t decoder;
+
+            memset(&decoded_image, 0, sizeof(decoded_image));
+            lzss_decoder_init(&decoder, block_g, on_block, &decoded_image);
+            CHECK(decode(&decoder, packed_g, packed_length, CHUNK_SIZES[j]));
+            CHECK_EQUAL(length, decoded_image.length);
+            CHECK(memcmp(image_g, decoded_image.image, length) == 0);
+            CHECK_EQUAL((length + LZSS_BLOCK_SIZE - 1) / LZSS_BLOCK_SIZE, decoded_image.blocks);
+         }
+      }
+   }
+}
+
+/**
+ * Decoding is continued from the third block, as after an interrupted download
+ */
+static void test_resume() {
+   static decoded_image_t decoded_image;
+   static decoded_image_t resumed_image;
+   lzss_decoder_t decoder;
+
+   fill_image(MAX_IMAGE_LENGTH, 3);
+   size_t packed_length = lzss_encode(image_g, MAX_IMAGE_LENGTH, packed_g);
+
+   memset(&decoded_image, 0, sizeof(decoded_image));
+   lzss_decoder_init(&decoder, block_g, on_block, &decoded_image);
+   CHECK(decode(&decoder, packed_g, packed_length, 536));
+   CHECK_EQUAL(2 * LZSS_BLOCK_SIZE, decoded_image.resume_decoded_length);
+
+   memset(&resumed_image, 0, sizeof(resumed_image));
+   lzss_decoder_init(&decoder, block_g, on_block, &resumed_image);
+   lzss_decoder_resume(&decoder, decoded_image.resume_input_position, decoded_image.resume_decoded_length);
+   CHECK(decode(&decoder, packed_g + decoded_image.resume_input_position,
+         packed_length - decoded_image.resume_input_position, 100));
+   CHECK_EQUAL(MAX_IMAGE_LENGTH - 2 * LZSS_BLOCK_SIZE, resumed_image.length);
+   CHECK(memcmp(image_g + 2 * LZSS_BLOCK_SIZE, resumed_image.image, resumed_image.length) == 0);
+   CHECK_EQUAL(packed_length, decoder.input_position);
+}
+
+static void test_corrupted_files() {
+   static decoded_image_t decoded_image;
+   lzss_decoder_t decoder;
+
+   fill_image(2 * LZSS_BLOCK_SIZE, 2);
+   size_t packed_length = lzss_encode(image_g, 2 * LZSS_BLOCK_SIZE, packed_g);
+
+   // Truncated file
+   lzss_decoder_init(&decoder, block_g, NULL, NULL);
+   CHECK(!decode(&decoder, packed_g, packed_length - 1, packed_length));
+   CHECK(!lzss_decoder_is_error(&decoder));
+
+   // Wrong magic
+   packed_g[0] = 'X';
+   lzss_decoder_init(&decoder, block_g, NULL, NULL);
+   CHECK(!decode(&decoder, packed_g, packed_length, packed_length));
+   CHECK(lzss_decoder_is_error(&decoder));
+   packed_g[0] = LZSS_MAGIC[0];
+
+   // The first match refers before the start of the block
+   packed_g[LZSS_FILE_HEADER_SIZE + LZSS_BLOCK_HEADER_SIZE] = 0x00;
+   lzss_decoder_init(&decoder, block_g, NULL, NULL);
+   CHECK(!decode(&decoder, packed_g, packed_length, packed_length));
+   CHECK(lzss_decoder_is_error(&decoder));
+
+   // Image longer than in the file header
+   lzss_encode(image_g, 2 * LZSS_BLOCK_SIZE, packed_g);
+   packed_g[5] = (LZSS_BLOCK_SIZE >> 8) & 0xFF;
+   memset(&decoded_image, 0, sizeof(decoded_image));
+   lzss_decoder_init(&decoder, block_g, on_block, &decoded_image);
+   CHECK(!decode(&decoder, packed_g, packed_length, packed_length));
+   CHECK(lzss_decoder_is_error(&decoder));
+   CHECK_EQUAL(LZSS_BLOCK_SIZE, decoded_image.length);
+
+   // Not the last block is shorter than LZSS_BLOCK_SIZE: two stored blocks of 10 and 5 bytes
+   static const unsigned char SHORT_BLOCKS[] = {'L', 'Z', 'S', '1', 15, 0, 0, 0,
+         10, 0x80, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+         5, 0x80, 'a', 'b', 'c', 'd', 'e'};
+
+   memset(&decoded_image, 0, sizeof(decoded_image));
+   lzss_decoder_init(&decoder, block_g, on_block, &decoded_image);
+   CHECK(!decode(&decoder, SHORT_BLOCKS, sizeof(SHORT_BLOCKS), 1));
+   CHECK(lzss_decoder_is_error(&decoder));
+   CHECK_EQUAL(1, decoded_image.blocks);
+
+   // The same without the image length after resuming
+   memset(&decoded_image, 0, sizeof(decoded_image));
+   lzss_decoder_init(&decoder, block_g, on_block, &decoded_image);
+   lzss_decoder_resume(&decoder, LZSS_FILE_HEADER_SIZE, 0);
+   CHECK(!decode(&decoder, SHORT_BLOCKS + LZSS_FILE_HEADER_SIZE, sizeof(SHORT_BLOCKS) - LZSS_FILE_HEADER_SIZE,
+         sizeof(SHORT_BLOCKS)));
+   CHECK(lzss_decoder_is_error(&decoder));
+   CHECK_EQUAL(1, decoded_image.blocks);
+}
+
+int main() {
+   test_round_trip();
+   test_resume();
+   test_corrupted_files();
+   return TEST_RESULT();
+}
@@ -0,0 +1,237 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "mqtt_client.h"
+#include "ota.h"
+#include "firmware_server.h"
+#include "mqtt_broker.h"
+#include "host_shims.h"
+#include "test.h"
+
+// The topics and the command as in user_main.h
+#define DEVICE_NAME    "Bedroom"
+#define STATUS_TOPIC   "esp8266/" DEVICE_NAME "/status"
+#define COMMAND_TOPIC  "esp8266/" DEVICE_NAME "/command"
+#define UPDATE_FIRMWARE "\"updateFirmware\":true"
+
+#define IMAGE_LENGTH (2 * SPI_FLASH_SEC_SIZE + 100)
+// The broker handles the packets in its own thread
+#define WAIT_TIMEOUT_MS 1000
+
+#define WAIT_FOR(condition) do { \
+   for (unsigned int wait_ms = 0; !(condition) && wait_ms < WAIT_TIMEOUT_MS; wait_ms++) { \
+      usleep(1000); \
+   } \
+} while (0)
+
+static unsigned char image_g[IMAGE_LENGTH];
+static unsigned int messages_amount_g;
+static char last_topic_g[MQTT_BROKER_TOPIC_SIZE];
+static bool update_firmware_requested_g;
+
+static void on_wifi_event() {
+}
+
+/**
+ * Checks the topic and the command as on_mqtt_message() in user_main.c does
+ */
+static void on_message(const char *topic, unsigned short topic_length, const unsigned char *payload,
+                       unsigned short payload_length) {
+   char command[MQTT_BROKER_PAYLOAD_SIZE + 1];
+
+   messages_amount_g++;
+   memcpy(last_topic_g, topic, topic_length);
+   last_topic_g[topic_length] = '\0';
+   memcpy(command, payload, payload_length);
+   command[payload_length] = '\0';
+
+   if (strcmp(last_topic_g, COMMAND_TOPIC) == 0 && strstr(command, UPDATE_FIRMWARE) != NULL) {
+      update_firmware_requested_g = true;
+   }
+}
+
+/**
+ * Processes the incoming packets as mqtt_task in user_main.c does until the next message is handled
+ */
+static bool process_next_message() {
+   unsigned int messages_amount = messages_amount_g;
+
+   for (unsigned int i = 0; i < WAIT_TIMEOUT_MS / 10 && messages_amount_g == messages_amount; i++) {
+      if (!mqtt_process(10)) {
+         return false;
+      }
+   }
+   return messages_amount_g != messages_amount;
+}
+
+static void test_connect(mqtt_broker_t *broker) {
+   CHECK(!mqtt_is_connected());
+   CHECK(mqtt_connect(DEVICE_NAME, on_message));
+   CHECK(mqtt_is_connected());
+
+   mqtt_broker_statistics_t statistics = mqtt_broker_get_statistics(broker);
+
+   CHECK_EQUAL(1, statistics.connections);
+   CHECK_STRING(DEVICE_NAME, statistics.client_id);
+   // The broker keeps the session, so the commands published while the device is offline aren't lost
+   CHECK(!statistics.clean_session);
+   CHECK(!statistics.session_present);
+}
+
+static void test_subscribe(mqtt_broker_t *broker) {
+   CHECK(mqtt_subscribe(COMMAND_TOPIC, MQTT_QOS_AT_LEAST_ONCE));
+
+   mqtt_broker_statistics_t statistics = mqtt_broker_get_statistics(broker);
+
+   CHECK_STRING(COMMAND_TOPIC, statistics.subscription);
+   CHECK_EQUAL(MQTT_QOS_AT_LEAST_ONCE, statistics.subscription_qos);
+}
+
+static void test_publish(mqtt_broker_t *broker) {
+   static const char STATUS[] = "{\"temperature\":26.07,\"humidity\":54.79}";
+   unsigned int publishes = mqtt_broker_get_statistics(broker).publishes;
+
+   CHECK(mqtt_publish(STATUS_TOPIC, (const unsigned char *) STATUS, strlen(STATUS), MQTT_QOS_AT_MOST_ONCE));
+   // Nothing is acknowledged with QoS 0
+   WAIT_FOR(mqtt_broker_get_statistics(broker).publishes == publishes + 1);
+   CHECK_EQUAL(publishes + 1, mqtt_broker_get_statistics(broker).publishes);
+
+   mqtt_broker_message_t message = mqtt_broker_get_last_message(broker);
+
+   CHECK_STRING(STATUS_TOPIC, message.topic);
+   CHECK_EQUAL(strlen(STATUS), message.payload_length);
+   CHECK(memcmp(STATUS, message.payload, message.payload_length) == 0);
+   CHECK_EQUAL(MQTT_QOS_AT_MOST_ONCE, message.qos);
+
+   // PUBACK is received only after the broker has got the message
+   CHECK(mqtt_publish(STATUS_TOPIC, (const unsigned char *) STATUS, strlen(STATUS), MQTT_QOS_AT_LEAST_ONCE));
+   CHECK_EQUAL(publishes + 2, mqtt_broker_get_statistics(broker).publishes);
+
+   message = mqtt_broker_get_last_message(broker);
+   CHECK_EQUAL(MQTT_QOS_AT_LEAST_ONCE, message.qos);
+   CHECK(message.packet_id != 0);
+   CHECK(mqtt_is_connected());
+}
+
+/**
+ * Without PUBACK the connection is closed, the caller publishes the message again after the reconnection
+ */
+static void test_puback_timeout(mqtt_broker_t *broker) {
+   static const char STATUS[] = "{\"temperature\":26.10}";
+   unsigned int publishes = mqtt_broker_get_statistics(broker).publishes;
+
+   mqtt_broker_set_drop_pubacks(broker, true);
+   CHECK(!mqtt_publish(STATUS_TOPIC, (const unsigned char *) STATUS, strlen(STATUS), MQTT_QOS_AT_LEAST_ONCE));
+   CHECK(!mqtt_is_connected());
+   CHECK(!mqtt_publish(STATUS_TOPIC, (const unsigned char *) STATUS, strlen(STATUS), MQTT_QOS_AT_LEAST_ONCE));
+   mqtt_broker_set_drop_pubacks(broker, false);
+
+   CHECK(mqtt_connect(DEVICE_NAME, on_message));
+   CHECK(mqtt_broker_get_statistics(broker).session_present);
+   CHECK(mqtt_publish(STATUS_TOPIC, (const unsigned char *) STATUS, strlen(STATUS), MQTT_QOS_AT_LEAST_ONCE));
+
+   // At least once: the broker has got the message twice
+   CHECK_EQUAL(publishes + 2, mqtt_broker_get_statistics(broker).publishes);
+   CHECK(memcmp(STATUS, mqtt_broker_get_last_message(broker).payload, strlen(STATUS)) == 0);
+}
+
+static void test_command(mqtt_broker_t *broker) {
+   messages_amount_g = 0;
+
+   // Other devices' commands aren't received
+   CHECK(!mqtt_broker_publish(broker, "esp8266/Kitchen/command", "{" UPDATE_FIRMWARE "}", MQTT_QOS_AT_LEAST_ONCE));
+
+   CHECK(mqtt_broker_publish(broker, COMMAND_TOPIC, "{\"updateFirmware\":false}", MQTT_QOS_AT_LEAST_ONCE));
+   CHECK(process_next_message());
+   CHECK_STRING(COMMAND_TOPIC, last_topic_g);
+   CHECK(!update_firmware_requested_g);
+   WAIT_FOR(mqtt_broker_get_statistics(broker).unacknowledged == 0);
+   CHECK_EQUAL(0, mqtt_broker_get_statistics(broker).unacknowledged);
+
+   // The command published while the device is disconnected is delivered after the reconnection
+   mqtt_disconnect();
+   WAIT_FOR(!mqtt_broker_get_statistics(broker).connected);
+   CHECK(mqtt_broker_publish(broker, COMMAND_TOPIC, "{" UPDATE_FIRMWARE "}", MQTT_QOS_AT_LEAST_ONCE));
+   CHECK_EQUAL(1, mqtt_broker_get_statistics(broker).unacknowledged);
+
+   CHECK(mqtt_connect(DEVICE_NAME, on_message));
+   CHECK(process_next_message());
+   CHECK(update_firmware_requested_g);
+   CHECK_EQUAL(2, messages_amount_g);
+   WAIT_FOR(mqtt_broker_get_statistics(broker).unacknowledged == 0);
+   CHECK_EQUAL(0, mqtt_broker_get_statistics(broker).unacknowledged);
+}
+
+/**
+ * mqtt_task disconnects and starts the update, the image is downloaded from the HTTP server
+ */
+static void test_command_starts_update() {
+   local_server_t server;
+   firmware_server_t firmware_server;
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   CHECK(update_firmware_requested_g);
+   update_firmware_requested_g = false;
+
+   firmware_server_init(&firmware_server, image_g, IMAGE_LENGTH, image_g, IMAGE_LENGTH);
+   CHECK(local_server_start(&server, firmware_server_respond, &firmware_server));
+   shim_server_port = server.port;
+   shim_partition_reset(4 * SPI_FLASH_SEC_SIZE);
+
+   mqtt_disconnect();
+   update_firmware();
+   shim_wait_for_tasks();
+
+   CHECK_EQUAL(restarts_amount + 1, shim_get_restarts_amount());
+   CHECK(shim_partition_equals(image_g, IMAGE_LENGTH));
+   local_server_stop(&server);
+}
+
+static void test_reconnect_after_broker_drop(mqtt_broker_t *broker) {
+   unsigned int connections = mqtt_broker_get_statistics(broker).connections;
+
+   CHECK(mqtt_connect(DEVICE_NAME, on_message));
+   CHECK(mqtt_process(10));
+
+   mqtt_broker_drop_connection(broker);
+   WAIT_FOR(!mqtt_process(10));
+   CHECK(!mqtt_is_connected());
+
+   CHECK(mqtt_connect(DEVICE_NAME, on_message));
+   CHECK_EQUAL(connections + 2, mqtt_broker_get_statistics(broker).connections);
+   CHECK(mqtt_broker_get_statistics(broker).session_present);
+
+   // The subscription is kept in the session
+   messages_amount_g = 0;
+   CHECK(mqtt_broker_publish(broker, COMMAND_TOPIC, "{}", MQTT_QOS_AT_LEAST_ONCE));
+   CHECK(process_next_message());
+   CHECK_EQUAL(1, messages_amount_g);
+   CHECK(!update_firmware_requested_g);
+
+   mqtt_disconnect();
+   CHECK(!mqtt_is_connected());
+}
+
+int main() {
+   mqtt_broker_t broker;
+
+   srand(1);
+   for (unsigned int i = 0; i < IMAGE_LENGTH; i++) {
+      image_g[i] = rand();
+   }
+
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+   CHECK(mqtt_broker_start(&broker));
+   shim_mqtt_broker_port = broker.port;
+
+   test_connect(&broker);
+   test_subscribe(&broker);
+   test_publish(&broker);
+   test_puback_timeout(&broker);
+   test_command(&broker);
+   test_command_starts_update();
+   test_reconnect_after_broker_drop(&broker);
+
+   mqtt_broker_stop(&broker);
+   return TEST_RESULT();
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "number_formatter.h"
+#include "test.h"
+
+static void test_against_snprintf() {
+   static const int VALUES[] = {0, 1, -1, 9, 10, -10, 99, 100, 12345, -12345, INT_MAX, INT_MIN};
+   char buffer[16];
+   char expected[16];
+
+   for (unsigned int i = 0; i < sizeof(VALUES) / sizeof(VALUES[0]); i++) {
+      snprintf(expected, sizeof(expected), "%d", VALUES[i]);
+      CHECK_EQUAL(strlen(expected), format_signed(buffer, sizeof(buffer), VALUES[i]));
+      CHECK_STRING(expected, buffer);
+
+      snprintf(expected, sizeof(expected), "%u", (unsigned int) VALUES[i]);
+      CHECK_EQUAL(strlen(expected), format_unsigned(buffer, sizeof(buffer), (unsigned int) VALUES[i]));
+      CHECK_STRING(expected, buffer);
+   }
+}
+
+static void test_fixed_point() {
+   char buffer[16];
+
+   CHECK_EQUAL(5, format_fixed_point(buffer, sizeof(buffer), 2105, 2));
+   CHECK_STRING("21.05", buffer);
+   CHECK_EQUAL(5, format_fixed_point(buffer, sizeof(buffer), -5, 2));
+   CHECK_STRING("-0.05", buffer);
+   CHECK_EQUAL(4, format_fixed_point(buffer, sizeof(buffer), 0, 2));
+   CHECK_STRING("0.00", buffer);
+   CHECK_EQUAL(3, format_fixed_point(buffer, sizeof(buffer), 123, 0));
+   CHECK_STRING("123", buffer);
+   CHECK_EQUAL(12, format_fixed_point(buffer, sizeof(buffer), INT_MIN, 3));
+   CHECK_STRING("-2147483.648", buffer);
+}
+
+static void test_small_buffers() {
+   char buffer[8];
+
+   CHECK_EQUAL(0, format_unsigned(buffer, 3, 123));
+   CHECK_STRING("", buffer);
+   CHECK_EQUAL(3, format_unsigned(buffer, 4, 123));
+   CHECK_EQUAL(0, format_signed(buffer, 4, -123));
+   CHECK_STRING("", buffer);
+   CHECK_EQUAL(0, format_signed(buffer, 1, -1));
+   CHECK_EQUAL(0, format_fixed_point(buffer, 5, 2105, 2));
+   CHECK_STRING("", buffer);
+   CHECK_EQUAL(5, format_fixed_point(buffer, 6, 2105, 2));
+   CHECK_EQUAL(0, format_unsigned(buffer, 0, 1));
+}
+
+int main() {
+   test_against_snprintf();
+   test_fixed_point();
+   test_small_buffers();
+   return TEST_RESULT();
+}
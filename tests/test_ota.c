@@ -0,0 +1,131 @@
+#include <string.h>
+#include "ota.h"
+#include "firmware_server.h"
+#include "host_shims.h"
+#include "test.h"
+
+#define IMAGE_LENGTH (3 * SPI_FLASH_SEC_SIZE + 1234)
+
+static unsigned char image_g[IMAGE_LENGTH];
+
+static void on_wifi_event() {
+}
+
+static bool has_checkpoint() {
+   unsigned int checkpoint[OTA_CHECKPOINT_BLOCKS];
+
+   rtc_mem_read(OTA_CHECKPOINT_RTC_ADDRESS, checkpoint, sizeof(checkpoint));
+   return (checkpoint[0] & 0xFF) == OTA_CHECKPOINT_MAGIC;
+}
+
+static void run_update() {
+   update_firmware();
+   shim_wait_for_tasks();
+}
+
+static void test_sha256_shim() {
+   unsigned char sha256[32];
+   static const unsigned char ABC_SHA256[] = {
+      0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+      0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+   };
+
+   mbedtls_sha256_ret((const unsigned char *) "abc", 3, sha256, 0);
+   CHECK(memcmp(ABC_SHA256, sha256, sizeof(sha256)) == 0);
+}
+
+static void test_update(firmware_server_t *firmware_server, bool chunked, size_t write_size) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->chunked = chunked;
+   firmware_server->write_size = write_size;
+   run_update();
+   firmware_server->chunked = false;
+   firmware_server->write_size = 0;
+
+   CHECK_EQUAL(restarts_amount + 1, shim_get_restarts_amount());
+   CHECK(!firmware_server->last_range_requested);
+   CHECK(shim_get_boot_partition_set());
+   CHECK(shim_partition_equals(image_g, IMAGE_LENGTH));
+   CHECK(!has_checkpoint());
+}
+
+static void test_wrong_sha256_is_rejected(firmware_server_t *firmware_server) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   char sha256_digit = firmware_server->sha256[0];
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->sha256[0] = sha256_digit == '0' ? '1' : '0';
+   run_update();
+   firmware_server->sha256[0] = sha256_digit;
+
+   CHECK_EQUAL(restarts_amount, shim_get_restarts_amount());
+   CHECK(!shim_get_boot_partition_set());
+   CHECK(!has_checkpoint());
+}
+
+static void test_interrupted_download_is_resumed(firmware_server_t *firmware_server) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->truncate_at = 2 * SPI_FLASH_SEC_SIZE + 100;
+   run_update();
+
+   CHECK_EQUAL(restarts_amount, shim_get_restarts_amount());
+   CHECK(has_checkpoint());
+
+   run_update();
+
+   CHECK(firmware_server->last_range_requested);
+   CHECK_EQUAL(2 * SPI_FLASH_SEC_SIZE, firmware_server->last_range_start);
+   CHECK_EQUAL(restarts_amount + 1, shim_get_restarts_amount());
+   CHECK(shim_get_boot_partition_set());
+   CHECK(shim_partition_equals(image_g, IMAGE_LENGTH));
+   CHECK(!has_checkpoint());
+}
+
+static void test_changed_image_is_downloaded_again(firmware_server_t *firmware_server) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->truncate_at = SPI_FLASH_SEC_SIZE + 1;
+   run_update();
+   CHECK(has_checkpoint());
+
+   firmware_server->etag = "\"image-2\"";
+   run_update();
+   firmware_server->etag = "\"image-1\"";
+
+   CHECK(!firmware_server->last_range_requested);
+   CHECK_EQUAL(restarts_amount + 1, shim_get_restarts_amount());
+   CHECK(shim_partition_equals(image_g, IMAGE_LENGTH));
+}
+
+int main() {
+   local_server_t server;
+   firmware_server_t firmware_server;
+
+   srand(1);
+   for (unsigned int i = 0; i < IMAGE_LENGTH; i++) {
+      image_g[i] = rand();
+   }
+   test_sha256_shim();
+
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+   firmware_server_init(&firmware_server, image_g, IMAGE_LENGTH, image_g, IMAGE_LENGTH);
+   CHECK(local_server_start(&server, firmware_server_respond, &firmware_server));
+   shim_server_port = server.port;
+
+   test_update(&firmware_server, false, 0);
+   test_update(&firmware_server, false, 7);
+   test_update(&firmware_server, true, 0);
+   test_update(&firmware_server, true, 1);
+   test_wrong_sha256_is_rejected(&firmware_server);
+   test_interrupted_download_is_resumed(&firmware_server);
+   test_changed_image_is_downloaded_again(&firmware_server);
+
+   local_server_stop(&server);
+   return TEST_RESULT();
+}
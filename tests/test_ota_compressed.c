@@ -0,0 +1,105 @@
+#include <string.h>
+#include "ota.h"
+#include "firmware_server.h"
+#include "host_shims.h"
+#include "lzss_encoder.h"
+#include "test.h"
+
+#define IMAGE_LENGTH (5 * SPI_FLASH_SEC_SIZE + 1234)
+
+static unsigned char image_g[IMAGE_LENGTH];
+static unsigned char packed_g[LZSS_ENCODED_BOUND(IMAGE_LENGTH)];
+
+static void on_wifi_event() {
+}
+
+static bool has_checkpoint() {
+   unsigned int checkpoint[OTA_CHECKPOINT_BLOCKS];
+
+   rtc_mem_read(OTA_CHECKPOINT_RTC_ADDRESS, checkpoint, sizeof(checkpoint));
+   return (checkpoint[0] & 0xFF) == OTA_CHECKPOINT_MAGIC;
+}
+
+static void run_update() {
+   update_firmware();
+   shim_wait_for_tasks();
+}
+
+static void test_update(firmware_server_t *firmware_server, bool chunked, size_t write_size) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->chunked = chunked;
+   firmware_server->write_size = write_size;
+   run_update();
+   firmware_server->chunked = false;
+   firmware_server->write_size = 0;
+
+   CHECK_EQUAL(restarts_amount + 1, shim_get_restarts_amount());
+   CHECK(shim_get_boot_partition_set());
+   CHECK(shim_partition_equals(image_g, IMAGE_LENGTH));
+   CHECK(!has_checkpoint());
+}
+
+static void test_wrong_sha256_is_rejected(firmware_server_t *firmware_server) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+   char sha256_digit = firmware_server->sha256[0];
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->sha256[0] = sha256_digit == '0' ? '1' : '0';
+   run_update();
+   firmware_server->sha256[0] = sha256_digit;
+
+   CHECK_EQUAL(restarts_amount, shim_get_restarts_amount());
+   CHECK(!shim_get_boot_partition_set());
+}
+
+/**
+ * The download is resumed from the start of the block which follows the last written one
+ */
+static void test_interrupted_download_is_resumed(firmware_server_t *firmware_server, size_t packed_length) {
+   unsigned int restarts_amount = shim_get_restarts_amount();
+
+   shim_partition_reset(8 * SPI_FLASH_SEC_SIZE);
+   firmware_server->truncate_at = packed_length / 2;
+   run_update();
+
+   CHECK_EQUAL(restarts_amount, shim_get_restarts_amount());
+   CHECK(has_checkpoint());
+
+   run_update();
+
+   CHECK(firmware_server->last_range_requested);
+   CHECK(firmware_server->last_range_start > LZSS_FILE_HEADER_SIZE);
+   CHECK(firmware_server->last_range_start <= packed_length / 2);
+   CHECK_EQUAL(restarts_amount + 1, shim_get_restarts_amount());
+   CHECK(shim_partition_equals(image_g, IMAGE_LENGTH));
+   CHECK(!has_checkpoint());
+}
+
+int main() {
+   local_server_t server;
+   firmware_server_t firmware_server;
+
+   // Half of every sector compresses
+   srand(1);
+   for (unsigned int i = 0; i < IMAGE_LENGTH; i++) {
+      image_g[i] = (i / 2048) % 2 ? rand() : (unsigned char) (i / 16);
+   }
+   size_t packed_length = lzss_encode(image_g, IMAGE_LENGTH, packed_g);
+
+   CHECK(packed_length < IMAGE_LENGTH * 3 / 4);
+
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+   firmware_server_init(&firmware_server, packed_g, packed_length, image_g, IMAGE_LENGTH);
+   CHECK(local_server_start(&server, firmware_server_respond, &firmware_server));
+   shim_server_port = server.port;
+
+   test_update(&firmware_server, false, 0);
+   test_update(&firmware_server, true, 7);
+   test_wrong_sha256_is_rejected(&firmware_server);
+   test_interrupted_download_is_resumed(&firmware_server, packed_length);
+
+   local_server_stop(&server);
+   return TEST_RESULT();
+}
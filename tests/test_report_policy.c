@@ -0,0 +1,104 @@
+#include <string.h>
+#include "status_record.h"
+#include "report_policy.h"
+#include "test.h"
+
+static const report_policy_config_t CONFIG = {
+   .temperature_deadband = 20,
+   .humidity_deadband = 100,
+   .light_deadband = 50,
+   .heartbeat_interval_ms = 60000
+};
+
+static void test_reasons() {
+   report_policy_t policy;
+   status_record_t record;
+   report_policy_values_t values;
+
+   memset(&record, 0, sizeof(record));
+   memset(&values, 0, sizeof(values));
+   values.temperature = 2100;
+   values.humidity = 5000;
+   report_policy_init(&policy, &CONFIG);
+
+   CHECK_EQUAL(REPORT_REASON_FIRST_REPORT, report_policy_evaluate(&policy, &record, &values, 0));
+   // Not sent reports are evaluated again
+   CHECK_EQUAL(REPORT_REASON_FIRST_REPORT, report_policy_evaluate(&policy, &record, &values, 1000));
+   report_policy_on_sent(&policy, &record, &values, 1000);
+
+   values.temperature += CONFIG.temperature_deadband;
+   CHECK_EQUAL(REPORT_REASON_NONE, report_policy_evaluate(&policy, &record, &values, 2000));
+   values.temperature++;
+   CHECK_EQUAL(REPORT_REASON_CHANGE, report_policy_evaluate(&policy, &record, &values, 3000));
+   report_policy_on_sent(&policy, &record, &values, 3000);
+
+   record.errors_counter++;
+   CHECK_EQUAL(REPORT_REASON_ERRORS, report_policy_evaluate(&policy, &record, &values, 4000));
+   report_policy_on_sent(&policy, &record, &values, 4000);
+
+   CHECK_EQUAL(REPORT_REASON_NONE,
+         report_policy_evaluate(&policy, &record, &values, 4000 + CONFIG.heartbeat_interval_ms - 1));
+   CHECK_EQUAL(REPORT_REASON_HEARTBEAT,
+         report_policy_evaluate(&policy, &record, &values, 4000 + CONFIG.heartbeat_interval_ms));
+
+   // Light is compared only when present
+   report_policy_on_sent(&policy, &record, &values, 70000);
+   values.light = 1000;
+   CHECK_EQUAL(REPORT_REASON_NONE, report_policy_evaluate(&policy, &record, &values, 71000));
+   values.light_present = true;
+   CHECK_EQUAL(REPORT_REASON_CHANGE, report_policy_evaluate(&policy, &record, &values, 72000));
+
+   CHECK_EQUAL(2, policy.statistics.first_reports);
+   CHECK_EQUAL(2, policy.statistics.change_reports);
+   CHECK_EQUAL(1, policy.statistics.errors_reports);
+   CHECK_EQUAL(1, policy.statistics.heartbeat_reports);
+   CHECK_EQUAL(3, policy.statistics.suppressed_reports);
+}
+
+/**
+ * The record carries the interval means, which lag behind a change, so only the values are compared.
+ */
+static void test_record_values_are_ignored() {
+   report_policy_t policy;
+   status_record_t record;
+   report_policy_values_t values;
+
+   memset(&record, 0, sizeof(record));
+   memset(&values, 0, sizeof(values));
+   report_policy_init(&policy, &CONFIG);
+   report_policy_on_sent(&policy, &record, &values, 0);
+
+   record.temperature = 1000;
+   record.humidity = 1000;
+   record.light = 1000;
+   record.light_present = true;
+   CHECK_EQUAL(REPORT_REASON_NONE, report_policy_evaluate(&policy, &record, &values, 1000));
+
+   values.temperature = CONFIG.temperature_deadband + 1;
+   CHECK_EQUAL(REPORT_REASON_CHANGE, report_policy_evaluate(&policy, &record, &values, 2000));
+   report_policy_on_sent(&policy, &record, &values, 2000);
+   CHECK_EQUAL(CONFIG.temperature_deadband + 1, policy.last_temperature);
+   CHECK_EQUAL(REPORT_REASON_NONE, report_policy_evaluate(&policy, &record, &values, 3000));
+}
+
+static void test_time_overflow() {
+   report_policy_t policy;
+   status_record_t record;
+   report_policy_values_t values;
+
+   memset(&record, 0, sizeof(record));
+   memset(&values, 0, sizeof(values));
+   report_policy_init(&policy, &CONFIG);
+   report_policy_on_sent(&policy, &record, &values, 0xFFFFFFFF - 1000);
+
+   CHECK_EQUAL(REPORT_REASON_NONE, report_policy_evaluate(&policy, &record, &values, 1000));
+   CHECK_EQUAL(REPORT_REASON_HEARTBEAT,
+         report_policy_evaluate(&policy, &record, &values, CONFIG.heartbeat_interval_ms));
+}
+
+int main() {
+   test_reasons();
+   test_record_values_are_ignored();
+   test_time_overflow();
+   return TEST_RESULT();
+}
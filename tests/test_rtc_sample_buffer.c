@@ -0,0 +1,82 @@
+#include <string.h>
+#include "utils.h"
+#include "rtc_sample_buffer.h"
+#include "host_shims.h"
+#include "test.h"
+
+#define RTC_ADDRESS 66
+#define CAPACITY    5
+
+static sample_record_t make_sample(unsigned int time) {
+   sample_record_t sample = {.time = time, .temperature = (short) (2000 + time), .humidity = (short) (5000 - time)};
+
+   return sample;
+}
+
+static void test_push_and_read() {
+   rtc_sample_buffer_t buffer;
+   sample_record_t samples[CAPACITY];
+   unsigned int end_sequence;
+
+   shim_clear_rtc_memory();
+   CHECK(!rtc_sample_buffer_init(&buffer, RTC_ADDRESS, CAPACITY));
+   CHECK_EQUAL(0, rtc_sample_buffer_read(&buffer, samples, CAPACITY, &end_sequence));
+
+   for (unsigned int time = 1; time <= CAPACITY + 2; time++) {
+      sample_record_t sample = make_sample(time);
+
+      rtc_sample_buffer_push(&buffer, &sample);
+   }
+
+   // The buffer survives the restart, the oldest samples have been overwritten
+   CHECK(rtc_sample_buffer_init(&buffer, RTC_ADDRESS, CAPACITY));
+   CHECK_EQUAL(CAPACITY, rtc_sample_buffer_read(&buffer, samples, CAPACITY, &end_sequence));
+   CHECK_EQUAL(3, samples[0].time);
+   CHECK_EQUAL(2003, samples[0].temperature);
+   CHECK_EQUAL(CAPACITY + 2, samples[CAPACITY - 1].time);
+   CHECK_EQUAL(4998 - CAPACITY, samples[CAPACITY - 1].humidity);
+
+   CHECK_EQUAL(2, rtc_sample_buffer_read(&buffer, samples, 2, &end_sequence));
+   rtc_sample_buffer_remove(&buffer, end_sequence);
+   CHECK_EQUAL(CAPACITY - 2, rtc_sample_buffer_read(&buffer, samples, CAPACITY, &end_sequence));
+   CHECK_EQUAL(5, samples[0].time);
+}
+
+static void test_corrupted_sample_is_skipped() {
+   rtc_sample_buffer_t buffer;
+   sample_record_t samples[CAPACITY];
+   unsigned int end_sequence;
+   unsigned int block;
+
+   shim_clear_rtc_memory();
+   rtc_sample_buffer_init(&buffer, RTC_ADDRESS, CAPACITY);
+   for (unsigned int time = 1; time <= 3; time++) {
+      sample_record_t sample = make_sample(time);
+
+      rtc_sample_buffer_push(&buffer, &sample);
+   }
+
+   // Temperature of the second sample
+   unsigned int address = RTC_ADDRESS + RTC_SAMPLE_BUFFER_HEADER_BLOCKS + RTC_SAMPLE_BUFFER_SAMPLE_BLOCKS + 1;
+
+   rtc_mem_read(address, &block, 4);
+   block ^= 0x1;
+   rtc_mem_write(address, &block, 4);
+
+   CHECK_EQUAL(2, rtc_sample_buffer_read(&buffer, samples, CAPACITY, &end_sequence));
+   CHECK_EQUAL(1, samples[0].time);
+   CHECK_EQUAL(3, samples[1].time);
+
+   // Corrupted header clears the buffer
+   rtc_mem_read(RTC_ADDRESS + 1, &block, 4);
+   block ^= 0x1;
+   rtc_mem_write(RTC_ADDRESS + 1, &block, 4);
+   CHECK(!rtc_sample_buffer_init(&buffer, RTC_ADDRESS, CAPACITY));
+   CHECK_EQUAL(0, rtc_sample_buffer_read(&buffer, samples, CAPACITY, &end_sequence));
+}
+
+int main() {
+   test_push_and_read();
+   test_corrupted_sample_is_skipped();
+   return TEST_RESULT();
+}
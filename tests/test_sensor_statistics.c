@@ -0,0 +1,168 @@
+#include <math.h>
+#include <stdlib.h>
+#include "sensor_statistics.h"
+#include "test.h"
+
+static void test_median_filter() {
+   median_filter_t filter;
+   int filtered_value;
+
+   median_filter_init(&filter, -4000, 12500, 500);
+
+   CHECK(!median_filter_get_value(&filter, &filtered_value));
+   CHECK(median_filter_add(&filter, 2000, &filtered_value));
+   CHECK_EQUAL(2000, filtered_value);
+   CHECK(median_filter_add(&filter, 2100, &filtered_value));
+   CHECK_EQUAL(2000, filtered_value);
+   CHECK(median_filter_add(&filter, 2050, &filtered_value));
+   CHECK_EQUAL(2050, filtered_value);
+
+   // Out of range values and spikes
+   CHECK(!median_filter_add(&filter, -10000, &filtered_value));
+   CHECK(!median_filter_add(&filter, 3000, &filtered_value));
+   // The last filtered value is kept while values are rejected
+   CHECK(median_filter_get_value(&filter, &filtered_value));
+   CHECK_EQUAL(2050, filtered_value);
+   CHECK(median_filter_add(&filter, 2060, &filtered_value));
+
+   // Step change is accepted after MEDIAN_FILTER_SIZE values in a row
+   CHECK(!median_filter_add(&filter, 4000, &filtered_value));
+   CHECK(!median_filter_add(&filter, 4000, &filtered_value));
+   CHECK(median_filter_add(&filter, 4000, &filtered_value));
+   CHECK_EQUAL(4000, filtered_value);
+}
+
+static void test_running_statistics() {
+   static const int VALUES[] = {2105, 2110, 2098, 2120, 2101, 2087, 2133, 2109};
+   running_statistics_t statistics;
+   double sum = 0;
+   double squares_sum = 0;
+   unsigned int amount = sizeof(VALUES) / sizeof(VALUES[0]);
+
+   running_statistics_reset(&statistics);
+   CHECK_EQUAL(0, running_statistics_get_standard_deviation(&statistics));
+
+   for (unsigned int i = 0; i < amount; i++) {
+      running_statistics_add(&statistics, VALUES[i]);
+      sum += VALUES[i];
+   }
+   double mean = sum / amount;
+
+   for (unsigned int i = 0; i < amount; i++) {
+      squares_sum += (VALUES[i] - mean) * (VALUES[i] - mean);
+   }
+
+   CHECK_EQUAL(amount, statistics.count);
+   CHECK_EQUAL(2087, statistics.min);
+   CHECK_EQUAL(2133, statistics.max);
+   CHECK_EQUAL(lround(mean), running_statistics_get_mean(&statistics));
+   CHECK_EQUAL(lround(sqrt(squares_sum / (amount - 1))), running_statistics_get_standard_deviation(&statistics));
+}
+
+/**
+ * The fixed point statistics against double precision on random series: slow drifts with noise, steps and the widest
+ * range of values
+ */
+static void test_running_statistics_precision() {
+   static const unsigned int AMOUNTS[] = {2, 3, 10, 60, 360, 5000};
+   unsigned int mean_errors = 0;
+   unsigned int deviation_errors = 0;
+
+   srand(17);
+   for (unsigned int series = 0; series < 300; series++) {
+      unsigned int amount = AMOUNTS[series % (sizeof(AMOUNTS) / sizeof(AMOUNTS[0]))];
+      running_statistics_t statistics;
+      double sum = 0;
+      double squares_sum = 0;
+      int *values = malloc(amount * sizeof(int));
+
+      running_statistics_reset(&statistics);
+      for (unsigned int i = 0; i < amount; i++) {
+         switch (series % 3) {
+            case 0:
+               values[i] = -1500 + (int) (i * 3) + rand() % 41 - 20;
+               break;
+            case 1:
+               values[i] = (i * 4 / amount) % 2 ? 2600 + rand() % 7 : -2600 - rand() % 7;
+               break;
+            default:
+               values[i] = rand() % 2 ? -4000 : 12500;
+               break;
+         }
+         running_statistics_add(&statistics, values[i]);
+         sum += values[i];
+      }
+
+      double mean = sum / amount;
+
+      for (unsigned int i = 0; i < amount; i++) {
+         squares_sum += (values[i] - mean) * (values[i] - mean);
+      }
+      free(values);
+
+      mean_errors += labs(lround(mean) - running_statistics_get_mean(&statistics)) > 1;
+      deviation_errors += labs(lround(sqrt(squares_sum / (amount - 1))) -
+            (long) running_statistics_get_standard_deviation(&statistics)) > 1;
+   }
+   CHECK_EQUAL(0, mean_errors);
+   CHECK_EQUAL(0, deviation_errors);
+}
+
+static void test_sensor_statistics() {
+   sensor_statistics_t sensor_statistics;
+
+   sensor_statistics_init(&sensor_statistics, -4000, 12500, 500);
+   CHECK(sensor_statistics_add(&sensor_statistics, 2000));
+   CHECK(!sensor_statistics_add(&sensor_statistics, -10000));
+   CHECK(sensor_statistics_add(&sensor_statistics, 2010));
+   // Failed reading
+   CHECK(!sensor_statistics_reject(&sensor_statistics));
+   CHECK_EQUAL(2, sensor_statistics.statistics.count);
+   CHECK_EQUAL(2, sensor_statistics.rejected_amount);
+
+   sensor_statistics_reset(&sensor_statistics);
+   CHECK_EQUAL(0, sensor_statistics.statistics.count);
+   CHECK_EQUAL(0, sensor_statistics.rejected_amount);
+   // The filter keeps its values
+   CHECK(!sensor_statistics_add(&sensor_statistics, 5000));
+}
+
+/**
+ * Days of samples without a report: the counts stop at the maximum, the statistics stay valid
+ */
+static void test_saturated_counts() {
+   running_statistics_t statistics;
+   sensor_statistics_t sensor_statistics;
+
+   running_statistics_reset(&statistics);
+   for (unsigned int i = 0; i < 3 * SENSOR_STATISTICS_MAX_COUNT; i++) {
+      running_statistics_add(&statistics, i % 2 == 0 ? 1990 : 2010);
+
+      if (i == SENSOR_STATISTICS_MAX_COUNT - 1 || i == 3 * SENSOR_STATISTICS_MAX_COUNT - 1) {
+         CHECK_EQUAL(SENSOR_STATISTICS_MAX_COUNT, statistics.count);
+         CHECK_EQUAL(2000, running_statistics_get_mean(&statistics));
+         CHECK_EQUAL(10, running_statistics_get_standard_deviation(&statistics));
+      }
+   }
+   CHECK_EQUAL(1990, statistics.min);
+   CHECK_EQUAL(2010, statistics.max);
+
+   running_statistics_add(&statistics, 3000);
+   CHECK_EQUAL(SENSOR_STATISTICS_MAX_COUNT, statistics.count);
+   CHECK_EQUAL(3000, statistics.max);
+
+   sensor_statistics_init(&sensor_statistics, -4000, 12500, 500);
+   for (unsigned int i = 0; i < SENSOR_STATISTICS_MAX_COUNT + 10; i++) {
+      sensor_statistics_reject(&sensor_statistics);
+   }
+   CHECK_EQUAL(SENSOR_STATISTICS_MAX_COUNT, sensor_statistics.rejected_amount);
+}
+
+int main() {
+   test_median_filter();
+   test_running_statistics();
+   test_running_statistics_precision();
+   test_sensor_statistics();
+   test_saturated_counts();
+   return TEST_RESULT();
+}
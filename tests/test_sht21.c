@@ -0,0 +1,134 @@
+#include <string.h>
+#include "sht21.h"
+#include "host_shims.h"
+#include "test.h"
+
+static void test_measurements() {
+   int temperature;
+   int humidity;
+   unsigned short temperature_raw;
+
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature_centi(&temperature, &temperature_raw));
+   CHECK_EQUAL(2607, temperature);
+   CHECK_EQUAL(0x6A3C, temperature_raw);
+   CHECK_EQUAL(ESP_OK, sht21_get_humidity_centi(&humidity));
+   CHECK_EQUAL(5479, humidity);
+
+   float temperature_float;
+   float humidity_float;
+
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature(&temperature_float, &temperature_raw));
+   CHECK(temperature_float > 26.06F && temperature_float < 26.08F);
+   CHECK_EQUAL(ESP_OK, sht21_get_humidity(&humidity_float));
+   CHECK(humidity_float > 54.78F && humidity_float < 54.80F);
+}
+
+static void test_errors() {
+   sht21_simulator_t *simulator = shim_get_sht21_simulator();
+   int temperature;
+   unsigned short temperature_raw;
+
+   simulator->corrupt_checksum = true;
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature_centi(&temperature, &temperature_raw));
+   CHECK_EQUAL(SHT21_CRC_ERROR_CENTI, temperature);
+   simulator->corrupt_checksum = false;
+
+   // Humidity data (status bit 1 is set) isn't taken as temperature
+   unsigned short temperature_data = simulator->temperature_raw;
+
+   simulator->temperature_raw = simulator->humidity_raw;
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature_centi(&temperature, &temperature_raw));
+   CHECK_EQUAL(SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR_CENTI, temperature);
+   simulator->temperature_raw = temperature_data;
+
+   unsigned short timeouts = sht21_get_conversion_time_histogram()->timeouts;
+
+   simulator->bus_error = true;
+   CHECK(sht21_get_temperature_centi(&temperature, &temperature_raw) != ESP_OK);
+   simulator->bus_error = false;
+
+   // The conversion never ends
+   simulator->conversion_ticks = 1000;
+   CHECK(sht21_get_temperature_centi(&temperature, &temperature_raw) != ESP_OK);
+   CHECK_EQUAL(timeouts + 1, sht21_get_conversion_time_histogram()->timeouts);
+   simulator->conversion_ticks = 3;
+}
+
+static void test_resolution() {
+   sht21_simulator_t *simulator = shim_get_sht21_simulator();
+   unsigned char user_register;
+
+   CHECK_EQUAL(ESP_OK, sht21_set_resolution(SHT21_RESOLUTION_RH11_T11));
+   CHECK_EQUAL(SHT21_RESOLUTION_RH11_T11, sht21_get_resolution());
+   // Reserved bits are kept
+   CHECK_EQUAL(0x83, simulator->user_register);
+   CHECK_EQUAL(ESP_OK, sht21_read_user_register(&user_register));
+   CHECK_EQUAL(0x83, user_register);
+
+   // 11 bit temperature is measured within 11 ms, the lower 5 bits are cleared
+   int temperature;
+   unsigned short temperature_raw;
+
+   simulator->conversion_ticks = 1;
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature_centi(&temperature, &temperature_raw));
+   CHECK_EQUAL(((17572 * 0x6A20 + 0x8000) >> 16) - 4685, temperature);
+   simulator->conversion_ticks = 3;
+
+   CHECK_EQUAL(ESP_OK, sht21_set_resolution(SHT21_RESOLUTION_RH12_T14));
+   CHECK_EQUAL(0x02, simulator->user_register);
+}
+
+static void test_conversion_time_histogram() {
+   sht21_simulator_t *simulator = shim_get_sht21_simulator();
+   sht21_conversion_time_histogram_t histogram = *sht21_get_conversion_time_histogram();
+   int humidity;
+
+   CHECK_EQUAL(ESP_OK, sht21_get_humidity_centi(&humidity));
+   unsigned int index;
+
+   for (index = 0; index < SHT21_CONVERSION_TIME_HISTOGRAM_SIZE; index++) {
+      if (sht21_get_conversion_time_histogram()->humidity[index] != histogram.humidity[index]) {
+         break;
+      }
+   }
+   CHECK(index < SHT21_CONVERSION_TIME_HISTOGRAM_SIZE);
+   CHECK(index >= simulator->conversion_ticks);
+   CHECK_EQUAL(histogram.humidity[index] + 1, sht21_get_conversion_time_histogram()->humidity[index]);
+}
+
+static void test_polling_backoff() {
+   sht21_simulator_t *simulator = shim_get_sht21_simulator();
+   int temperature;
+   unsigned short temperature_raw;
+
+   // The typical 14 bit conversion (66 ms) is read at once
+   simulator->conversion_ticks = 66 / portTICK_RATE_MS;
+   simulator->measurement_reads = 0;
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature_centi(&temperature, &temperature_raw));
+   CHECK_EQUAL(1, simulator->measurement_reads);
+
+   // The maximum one (85 ms) is polled after 1, then 2 ticks instead of every tick from the trigger
+   TickType_t trigger_time = xTaskGetTickCount();
+
+   simulator->conversion_ticks = 85 / portTICK_RATE_MS;
+   simulator->measurement_reads = 0;
+   CHECK_EQUAL(ESP_OK, sht21_get_temperature_centi(&temperature, &temperature_raw));
+   CHECK_EQUAL(3, simulator->measurement_reads);
+   CHECK(xTaskGetTickCount() - trigger_time <= simulator->conversion_ticks + SHT21_MAX_POLLING_INTERVAL);
+
+   // The last poll is at the timeout, not after it
+   trigger_time = xTaskGetTickCount();
+   simulator->conversion_ticks = 1000;
+   CHECK(sht21_get_temperature_centi(&temperature, &temperature_raw) != ESP_OK);
+   CHECK_EQUAL(100 / portTICK_RATE_MS, xTaskGetTickCount() - trigger_time);
+   simulator->conversion_ticks = 3;
+}
+
+int main() {
+   test_measurements();
+   test_errors();
+   test_resolution();
+   test_conversion_time_histogram();
+   test_polling_backoff();
+   return TEST_RESULT();
+}
@@ -0,0 +1,70 @@
+#include <math.h>
+#include "test.h"
+// Conversions are static, so they are tested in this translation unit
+#include "../components/sht21/sht21.c"
+
+static const SHT21_Resolution RESOLUTIONS[] = {
+   SHT21_RESOLUTION_RH12_T14, SHT21_RESOLUTION_RH8_T12, SHT21_RESOLUTION_RH10_T13, SHT21_RESOLUTION_RH11_T11
+};
+
+/**
+ * Integer results in hundredths are within 0.01 of the float formula over all the raw codes. The float formula
+ * divides by 0xFFFF, the integer one by 2^16 as the datasheet does, the difference is below 0.003.
+ */
+static void test_equivalence_with_float() {
+   double max_temperature_difference = 0;
+   double max_humidity_difference = 0;
+
+   for (unsigned int r = 0; r < sizeof(RESOLUTIONS) / sizeof(RESOLUTIONS[0]); r++) {
+      resolution_g = RESOLUTIONS[r];
+
+      for (unsigned int data = 1; data <= 0xFFFF; data++) {
+         unsigned char checksum = sht21_calculate_crc(data);
+
+         if (data & 0x2) {
+            float humidity = sht21_calculate_humidity(data, checksum);
+            int humidity_centi = sht21_calculate_humidity_centi(data, checksum);
+
+            max_humidity_difference = fmax(max_humidity_difference, fabs(humidity_centi - humidity * 100.0));
+         } else {
+            float temperature = sht21_calculate_temperature(data, checksum);
+            int temperature_centi = sht21_calculate_temperature_centi(data, checksum);
+
+            max_temperature_difference = fmax(max_temperature_difference,
+                  fabs(temperature_centi - temperature * 100.0));
+         }
+      }
+   }
+   printf("Max difference from the float conversion, hundredths. Temperature: %.3f, humidity: %.3f\n",
+         max_temperature_difference, max_humidity_difference);
+   CHECK(max_temperature_difference <= 1.0);
+   CHECK(max_humidity_difference <= 1.0);
+   resolution_g = SHT21_RESOLUTION_RH12_T14;
+}
+
+static void test_errors_are_the_same() {
+   CHECK_EQUAL(SHT21_CRC_ERROR_CENTI, sht21_calculate_temperature_centi(0x6A3C, sht21_calculate_crc(0x6A3C) ^ 1));
+   CHECK_EQUAL((int) (SHT21_CRC_ERROR * 100), SHT21_CRC_ERROR_CENTI);
+   CHECK_EQUAL(SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR_CENTI,
+         sht21_calculate_temperature_centi(0x7C82, sht21_calculate_crc(0x7C82)));
+   CHECK_EQUAL((int) (SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR * 100), SHT21_NOT_TEMPERATURE_MEASUREMENT_ERROR_CENTI);
+   CHECK_EQUAL(SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR_CENTI,
+         sht21_calculate_humidity_centi(0x6A3C, sht21_calculate_crc(0x6A3C)));
+   CHECK_EQUAL((int) (SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR * 100), SHT21_NOT_HUMIDITY_MEASUREMENT_ERROR_CENTI);
+   CHECK_EQUAL(0, sht21_calculate_humidity_centi(0, sht21_calculate_crc(0)));
+}
+
+static void test_range_ends() {
+   // Status bits are cleared, so 0xFFFC is the maximum
+   CHECK_EQUAL(12886, sht21_calculate_temperature_centi(0xFFFC, sht21_calculate_crc(0xFFFC)));
+   CHECK_EQUAL(-4685, sht21_calculate_temperature_centi(0x0001, sht21_calculate_crc(0x0001)));
+   CHECK_EQUAL(11899, sht21_calculate_humidity_centi(0xFFFE, sht21_calculate_crc(0xFFFE)));
+   CHECK_EQUAL(-600, sht21_calculate_humidity_centi(0x0002, sht21_calculate_crc(0x0002)));
+}
+
+int main() {
+   test_equivalence_with_float();
+   test_errors_are_the_same();
+   test_range_ends();
+   return TEST_RESULT();
+}
@@ -0,0 +1,47 @@
+#include <stdlib.h>
+#include "test.h"
+#include "host_shims.h"
+// The frame CRC is static, so it's tested in this translation unit
+#include "../components/sht21/sht21.c"
+
+static void test_all_frames() {
+   unsigned int mismatches = 0;
+
+   for (unsigned int data = 0; data <= 0xFFFF; data++) {
+      unsigned char frame[2] = {data >> 8, data & 0xFF};
+
+      if (sht21_calculate_crc(data) != shim_sht21_reference_crc8(frame, sizeof(frame))) {
+         mismatches++;
+      }
+   }
+   CHECK_EQUAL(0, mismatches);
+}
+
+static void test_datasheet_example() {
+   // SHT21 datasheet, CRC checksum example: 0x683A -> 0x7C
+   static const unsigned char FRAME[] = {0x68, 0x3A};
+
+   CHECK_EQUAL(0x7C, sht21_calculate_crc(0x683A));
+   CHECK_EQUAL(0x7C, sht21_calculate_crc8(FRAME, sizeof(FRAME)));
+   // The checksum appended to the data gives 0
+   CHECK_EQUAL(0, sht21_calculate_crc8((const unsigned char []) {0x68, 0x3A, 0x7C}, 3));
+}
+
+static void test_byte_streams() {
+   unsigned char data[64];
+
+   srand(10);
+   for (unsigned int length = 0; length <= sizeof(data); length++) {
+      for (unsigned int i = 0; i < length; i++) {
+         data[i] = rand();
+      }
+      CHECK_EQUAL(shim_sht21_reference_crc8(data, length), sht21_calculate_crc8(data, length));
+   }
+}
+
+int main() {
+   test_all_frames();
+   test_datasheet_example();
+   test_byte_streams();
+   return TEST_RESULT();
+}
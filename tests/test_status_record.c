@@ -0,0 +1,197 @@
+#include <string.h>
+#include "status_record.h"
+#include "test.h"
+
+static status_record_t make_record(bool first_report) {
+   status_record_t record = {
+      .signal_strength = -67,
+      .errors_counter = 0x0102,
+      .pending_connection_errors_counter = 3,
+      .uptime = 0x04050607,
+      .free_heap_space = 0x08090A0B,
+      .temperature = -1234,
+      .temperature_min = -1300,
+      .temperature_max = -1200,
+      .temperature_deviation = 17,
+      .temperature_raw = 0x6A3C,
+      .humidity = 5479,
+      .humidity_min = 5400,
+      .humidity_max = 5500,
+      .humidity_deviation = 25,
+      .samples_amount = 30,
+      .rejected_samples_amount = 2,
+      .suppressed_reports = 0x11223344,
+      .awake_time = 0x00ABCDEF,
+      .first_report = first_report,
+      .device_name = "dev1",
+      .build_timestamp = "Oct 17 2026 10:00:00",
+      .reset_reason = "POWERON",
+      .system_restart_reason = "",
+      .boot_timeline = "wifi:120,ip:850"
+   };
+   return record;
+}
+
+/**
+ * The layout is fixed by the collector, so the periodic record is compared byte by byte. The fixed part is 46 bytes
+ * (STATUS_RECORD_VERSION 5), the periodic record with a 4 character device name is 51 bytes.
+ */
+static void test_layout() {
+   static const unsigned char EXPECTED[] = {
+      0x05, 0x00, 0xBD, 0x02, 0x01, 0x03, 0x07, 0x06, 0x05, 0x04, 0x0B, 0x0A, 0x09, 0x08, 0x2E, 0xFB,
+      0x3C, 0x6A, 0x67, 0x15, 0x00, 0x00, 0x44, 0x33, 0x22, 0x11, 0xEC, 0xFA, 0x50, 0xFB, 0x11, 0x00,
+      0x18, 0x15, 0x7C, 0x15, 0x19, 0x00, 0x1E, 0x00, 0x02, 0x00, 0xEF, 0xCD, 0xAB, 0x00, 0x04, 'd',
+      'e', 'v', '1'
+   };
+   status_record_t record = make_record(false);
+   unsigned char buffer[128];
+
+   CHECK_EQUAL(5, STATUS_RECORD_VERSION);
+   CHECK_EQUAL(46, STATUS_RECORD_FIXED_PART_SIZE);
+   CHECK_EQUAL(sizeof(EXPECTED), get_status_record_encoded_length(&record));
+   CHECK_EQUAL(sizeof(EXPECTED), encode_status_record(&record, buffer, sizeof(buffer)));
+   CHECK(memcmp(EXPECTED, buffer, sizeof(EXPECTED)) == 0);
+
+   // Light is sent only when present
+   record.light = 0x1234;
+   encode_status_record(&record, buffer, sizeof(buffer));
+   CHECK_EQUAL(0, buffer[20] | buffer[21]);
+   record.light_present = true;
+   encode_status_record(&record, buffer, sizeof(buffer));
+   CHECK_EQUAL(0x1234, buffer[20] | (buffer[21] << 8));
+   CHECK_EQUAL(STATUS_RECORD_LIGHT_PRESENT_FLAG, buffer[1]);
+}
+
+static void check_records_equal(const status_record_t *expected, const status_record_t *actual) {
+   CHECK_EQUAL(expected->signal_strength, actual->signal_strength);
+   CHECK_EQUAL(expected->errors_counter, actual->errors_counter);
+   CHECK_EQUAL(expected->pending_connection_errors_counter, actual->pending_connection_errors_counter);
+   CHECK_EQUAL(expected->uptime, actual->uptime);
+   CHECK_EQUAL(expected->free_heap_space, actual->free_heap_space);
+   CHECK_EQUAL(expected->temperature, actual->temperature);
+   CHECK_EQUAL(expected->temperature_min, actual->temperature_min);
+   CHECK_EQUAL(expected->temperature_max, actual->temperature_max);
+   CHECK_EQUAL(expected->temperature_deviation, actual->temperature_deviation);
+   CHECK_EQUAL(expected->temperature_raw, actual->temperature_raw);
+   CHECK_EQUAL(expected->humidity, actual->humidity);
+   CHECK_EQUAL(expected->humidity_min, actual->humidity_min);
+   CHECK_EQUAL(expected->humidity_max, actual->humidity_max);
+   CHECK_EQUAL(expected->humidity_deviation, actual->humidity_deviation);
+   CHECK_EQUAL(expected->samples_amount, actual->samples_amount);
+   CHECK_EQUAL(expected->rejected_samples_amount, actual->rejected_samples_amount);
+   CHECK_EQUAL(expected->light_present, actual->light_present);
+   CHECK_EQUAL(expected->light, actual->light);
+   CHECK_EQUAL(expected->suppressed_reports, actual->suppressed_reports);
+   CHECK_EQUAL(expected->awake_time, actual->awake_time);
+   CHECK_EQUAL(expected->first_report, actual->first_report);
+   CHECK_STRING(expected->device_name, actual->device_name);
+
+   if (expected->first_report) {
+      CHECK_STRING(expected->build_timestamp, actual->build_timestamp);
+      CHECK_STRING(expected->reset_reason, actual->reset_reason);
+      CHECK_STRING(expected->system_restart_reason, actual->system_restart_reason);
+      CHECK_STRING(expected->boot_timeline, actual->boot_timeline);
+   } else {
+      CHECK(actual->build_timestamp == NULL);
+      CHECK(actual->boot_timeline == NULL);
+   }
+}
+
+static void test_round_trip() {
+   for (unsigned int first_report = 0; first_report < 2; first_report++) {
+      status_record_t record = make_record(first_report);
+      status_record_t decoded_record;
+      unsigned char buffer[256];
+      char strings[256];
+
+      record.light_present = true;
+      record.light = 512;
+
+      unsigned short length = encode_status_record(&record, buffer, sizeof(buffer));
+
+      CHECK(length > STATUS_RECORD_FIXED_PART_SIZE);
+      CHECK(decode_status_record(buffer, length, &decoded_record, strings, sizeof(strings)));
+      check_records_equal(&record, &decoded_record);
+
+      // Truncated and extended records are rejected
+      CHECK(!decode_status_record(buffer, length - 1, &decoded_record, strings, sizeof(strings)));
+      CHECK(!decode_status_record(buffer, length + 1, &decoded_record, strings, sizeof(strings)));
+      CHECK(!decode_status_record(buffer, STATUS_RECORD_FIXED_PART_SIZE - 1, &decoded_record, strings,
+            sizeof(strings)));
+      CHECK_EQUAL(0, encode_status_record(&record, buffer, length - 1));
+
+      buffer[0]++;
+      CHECK(!decode_status_record(buffer, length, &decoded_record, strings, sizeof(strings)));
+   }
+}
+
+static void test_long_strings_are_truncated() {
+   char long_name[400];
+   status_record_t record = make_record(false);
+   status_record_t decoded_record;
+   unsigned char buffer[512];
+   char strings[512];
+
+   memset(long_name, 'n', sizeof(long_name) - 1);
+   long_name[sizeof(long_name) - 1] = '\0';
+   record.device_name = long_name;
+
+   unsigned short length = encode_status_record(&record, buffer, sizeof(buffer));
+
+   CHECK_EQUAL(STATUS_RECORD_FIXED_PART_SIZE + 1 + STATUS_RECORD_MAX_STRING_SIZE, length);
+   CHECK(decode_status_record(buffer, length, &decoded_record, strings, sizeof(strings)));
+   CHECK_EQUAL(STATUS_RECORD_MAX_STRING_SIZE, strlen(decoded_record.device_name));
+}
+
+static void test_datagrams() {
+   status_record_t record = make_record(true);
+   status_record_t decoded_record;
+   unsigned char buffer[256];
+   char strings[256];
+   unsigned int sequence;
+   unsigned char commands;
+
+   unsigned short length = encode_status_datagram(&record, 0xCAFE0001, buffer, sizeof(buffer));
+
+   CHECK_EQUAL(STATUS_DATAGRAM_HEADER_SIZE + get_status_record_encoded_length(&record), length);
+   CHECK(decode_status_datagram(buffer, length, &sequence, &decoded_record, strings, sizeof(strings)));
+   CHECK_EQUAL(0xCAFE0001, sequence);
+   check_records_equal(&record, &decoded_record);
+
+   CHECK_EQUAL(STATUS_DATAGRAM_REPLY_SIZE,
+         encode_status_datagram_reply(0xCAFE0001, STATUS_DATAGRAM_UPDATE_FIRMWARE_COMMAND, buffer));
+   CHECK(decode_status_datagram_reply(buffer, STATUS_DATAGRAM_REPLY_SIZE, 0xCAFE0001, &commands));
+   CHECK_EQUAL(STATUS_DATAGRAM_UPDATE_FIRMWARE_COMMAND, commands);
+   // Stale reply
+   CHECK(!decode_status_datagram_reply(buffer, STATUS_DATAGRAM_REPLY_SIZE, 0xCAFE0002, &commands));
+}
+
+static void test_sample_batch() {
+   sample_record_t samples[3] = {{100, -500, 4000}, {130, 2100, 5000}, {160, 2105, 5012}};
+   sample_record_t decoded_samples[3];
+   unsigned char buffer[64];
+   char device_name[16];
+   unsigned int current_time;
+   unsigned char samples_amount;
+
+   unsigned short length = encode_sample_batch(samples, 3, 170, "dev1", buffer, sizeof(buffer));
+
+   CHECK_EQUAL(SAMPLE_BATCH_FIXED_PART_SIZE + 3 * SAMPLE_BATCH_ENTRY_SIZE + 5, length);
+   CHECK(decode_sample_batch(buffer, length, &current_time, decoded_samples, 3, &samples_amount, device_name,
+         sizeof(device_name)));
+   CHECK_EQUAL(170, current_time);
+   CHECK_EQUAL(3, samples_amount);
+   CHECK(memcmp(samples, decoded_samples, sizeof(samples)) == 0);
+   CHECK_STRING("dev1", device_name);
+   CHECK(!decode_sample_batch(buffer, length, &current_time, decoded_samples, 2, &samples_amount, device_name,
+         sizeof(device_name)));
+}
+
+int main() {
+   test_layout();
+   test_round_trip();
+   test_long_strings_are_truncated();
+   test_datagrams();
+   test_sample_batch();
+   return TEST_RESULT();
+}
@@ -0,0 +1,77 @@
+#include <string.h>
+#include "template_renderer.h"
+#include "test.h"
+
+static unsigned short render(const char *template, const char *parameters[], char *buffer,
+                             unsigned short buffer_size) {
+   compiled_template_t compiled_template;
+   unsigned short parameters_lengths[TEMPLATE_MAX_PARAMETERS];
+
+   if (!compile_template(template, &compiled_template)) {
+      return 0xFFFF;
+   }
+   unsigned short length = get_rendered_template_length(&compiled_template, parameters, parameters_lengths);
+   unsigned short rendered_length = render_template(&compiled_template, parameters, parameters_lengths, buffer,
+         buffer_size);
+
+   CHECK(rendered_length == 0 || rendered_length == length);
+   return rendered_length;
+}
+
+static void test_parameters_are_substituted() {
+   const char *parameters[] = {"first", "", NULL, "10"};
+   char buffer[64];
+
+   CHECK_EQUAL(14, render("a <1>|<2>|<3>|<4> b", parameters, buffer, sizeof(buffer)));
+   CHECK_STRING("a first|||10 b", buffer);
+   CHECK_EQUAL(10, render("<1><1>", parameters, buffer, sizeof(buffer)));
+   CHECK_STRING("firstfirst", buffer);
+   CHECK_EQUAL(7, render("literal", parameters, buffer, sizeof(buffer)));
+   CHECK_STRING("literal", buffer);
+}
+
+static void test_malformed_templates_are_rejected() {
+   compiled_template_t compiled_template;
+
+   CHECK(!compile_template("a > b", &compiled_template));
+   CHECK(!compile_template("<0>", &compiled_template));
+   CHECK(!compile_template("<1", &compiled_template));
+   CHECK(!compile_template("<a>", &compiled_template));
+   CHECK(!compile_template("<123>", &compiled_template));
+   CHECK(!compile_template("<29>", &compiled_template));
+   CHECK(compile_template("<28>", &compiled_template));
+   CHECK_EQUAL(28, compiled_template.parameters_amount);
+   CHECK(compile_template("", &compiled_template));
+   CHECK_EQUAL(0, compiled_template.segments_amount);
+}
+
+static void test_buffer_size_is_checked() {
+   const char *parameters[] = {"12345"};
+   char buffer[8];
+
+   CHECK_EQUAL(7, render("<1>ab", parameters, buffer, 8));
+   CHECK_STRING("12345ab", buffer);
+   CHECK_EQUAL(0, render("<1>ab", parameters, buffer, 7));
+   CHECK_EQUAL(0, render("<1>", parameters, buffer, 5));
+}
+
+static void test_segments_limit() {
+   compiled_template_t compiled_template;
+   char template[TEMPLATE_MAX_SEGMENTS * 4 + 8] = "";
+
+   for (unsigned int i = 0; i < TEMPLATE_MAX_SEGMENTS / 2; i++) {
+      strcat(template, "a<1>");
+   }
+   CHECK(compile_template(template, &compiled_template));
+   CHECK_EQUAL(TEMPLATE_MAX_SEGMENTS, compiled_template.segments_amount);
+   strcat(template, "a");
+   CHECK(!compile_template(template, &compiled_template));
+}
+
+int main() {
+   test_parameters_are_substituted();
+   test_malformed_templates_are_rejected();
+   test_buffer_size_is_checked();
+   test_segments_limit();
+   return TEST_RESULT();
+}
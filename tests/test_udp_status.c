@@ -0,0 +1,104 @@
+#include <string.h>
+#include "utils.h"
+#include "status_record.h"
+#include "udp_receiver.h"
+#include "host_shims.h"
+#include "test.h"
+
+#define REPLY_TIMEOUT_MS 20
+
+static status_record_t record_g = {
+   .signal_strength = -67,
+   .uptime = 3600,
+   .free_heap_space = 38000,
+   .temperature = 2607,
+   .humidity = 5479,
+   .samples_amount = 60,
+   .device_name = "Bedroom"
+};
+
+static void on_wifi_event() {
+}
+
+/**
+ * Sends the status as send_status_info_datagram() in user_main.c does. Returns true if the reply confirms it.
+ */
+static bool send_status(unsigned int sequence, unsigned char *commands) {
+   unsigned char datagram[STATUS_DATAGRAM_HEADER_SIZE + STATUS_RECORD_FIXED_PART_SIZE + 256];
+   unsigned short datagram_length = encode_status_datagram(&record_g, sequence, datagram, sizeof(datagram));
+   unsigned char reply[STATUS_DATAGRAM_REPLY_SIZE];
+   int reply_length = send_datagram(datagram, datagram_length, reply, sizeof(reply), REPLY_TIMEOUT_MS);
+
+   CHECK(reply_length >= 0);
+   return reply_length > 0 && decode_status_datagram_reply(reply, reply_length, sequence, commands);
+}
+
+static void test_replies(udp_receiver_t *receiver) {
+   unsigned char commands = 0xFF;
+
+   CHECK(send_status(0, &commands));
+   CHECK_EQUAL(0, commands);
+
+   receiver->commands = STATUS_DATAGRAM_UPDATE_FIRMWARE_COMMAND;
+   CHECK(send_status(1, &commands));
+   CHECK_EQUAL(STATUS_DATAGRAM_UPDATE_FIRMWARE_COMMAND, commands);
+   receiver->commands = 0;
+
+   status_record_t record = udp_receiver_get_last_record(receiver);
+
+   CHECK_EQUAL(2607, record.temperature);
+   CHECK_EQUAL(60, record.samples_amount);
+   CHECK_STRING("Bedroom", record.device_name);
+}
+
+/**
+ * The collector finds the lost and repeated datagrams by their sequence numbers
+ */
+static void test_loss_detection(udp_receiver_t *receiver) {
+   unsigned char commands;
+
+   // Sequence 2 is never sent, 3 is sent twice
+   CHECK(send_status(3, &commands));
+   CHECK(send_status(3, &commands));
+   CHECK(send_status(4, &commands));
+
+   udp_receiver_statistics_t statistics = udp_receiver_get_statistics(receiver);
+
+   CHECK_EQUAL(5, statistics.received);
+   CHECK_EQUAL(1, statistics.lost);
+   CHECK_EQUAL(1, statistics.duplicates);
+   CHECK_EQUAL(0, statistics.invalid);
+
+   // A dropped datagram isn't confirmed, the device waits for the reply timeout only
+   udp_receiver_set_drop_percent(receiver, 100);
+   CHECK(!send_status(5, &commands));
+   udp_receiver_set_drop_percent(receiver, 0);
+   CHECK(send_status(6, &commands));
+
+   statistics = udp_receiver_get_statistics(receiver);
+   CHECK_EQUAL(1, statistics.dropped);
+   CHECK_EQUAL(2, statistics.lost);
+}
+
+static void test_invalid_datagram() {
+   unsigned char datagram[] = {STATUS_DATAGRAM_TYPE, 7, 0, 0, 0, STATUS_RECORD_VERSION + 1};
+   unsigned char reply[STATUS_DATAGRAM_REPLY_SIZE];
+
+   CHECK_EQUAL(0, send_datagram(datagram, sizeof(datagram), reply, sizeof(reply), REPLY_TIMEOUT_MS));
+}
+
+int main() {
+   udp_receiver_t receiver;
+
+   CHECK(udp_receiver_start(&receiver, 0, 14));
+   shim_server_udp_port = receiver.port;
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+
+   test_replies(&receiver);
+   test_loss_detection(&receiver);
+   test_invalid_datagram();
+   CHECK_EQUAL(1, udp_receiver_get_statistics(&receiver).invalid);
+
+   udp_receiver_stop(&receiver);
+   return TEST_RESULT();
+}
@@ -0,0 +1,161 @@
+#include <string.h>
+#include "utils.h"
+#include "local_server.h"
+#include "host_shims.h"
+#include "test.h"
+
+static const char RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+static const char CLOSED_RESPONSE[] = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 6\r\n\r\nclosed";
+
+static void on_wifi_event() {
+}
+
+static bool respond(local_server_t *server, int socket_id, const char *request) {
+   bool close_connection = strstr(request, "/close") != NULL;
+   bool *drop_next_request = (bool *) server->context;
+
+   if (drop_next_request != NULL && *drop_next_request) {
+      // The idle connection is closed by the server right when the request arrives
+      *drop_next_request = false;
+      return false;
+   }
+   if (close_connection) {
+      local_server_write(socket_id, CLOSED_RESPONSE, strlen(CLOSED_RESPONSE), 0);
+   } else {
+      // Byte by byte, so the parser gets the response in many recv() calls
+      local_server_write(socket_id, RESPONSE, strlen(RESPONSE), 1);
+   }
+   return !close_connection;
+}
+
+static void test_string_helpers() {
+   const char *parameters[] = {"x", "yz", NULL};
+   char *result = set_string_parameters("<2>-<1>!", parameters);
+
+   CHECK_STRING("yz-x!", result);
+   free(result);
+   CHECK(set_string_parameters("<1", parameters) == NULL);
+
+   CHECK(compare_strings("abc", "abc"));
+   CHECK(!compare_strings("abc", "abd"));
+   CHECK(!compare_strings("abc", "ab"));
+
+   char *heap_string = put_flash_string_into_heap("flash", 0);
+
+   CHECK_STRING("flash", heap_string);
+   free(heap_string);
+}
+
+static void test_rtc_memory() {
+   unsigned int written[3] = {0x12345678, 0, 0xFFFFFFFF};
+   unsigned int read[3];
+
+   rtc_mem_write(189, written, sizeof(written));
+   rtc_mem_read(189, read, sizeof(read));
+   CHECK(memcmp(written, read, sizeof(written)) == 0);
+}
+
+static void test_requests(local_server_t *server) {
+   for (unsigned int i = 0; i < 3; i++) {
+      char *response = send_request("GET / HTTP/1.1\r\n\r\n", 64, 0);
+
+      CHECK_STRING("ok", response);
+      free(response);
+   }
+   CHECK_EQUAL(1, server->connections);
+   CHECK_EQUAL(2, get_http_connection_statistics().reused_connections);
+
+   char *response = send_request("GET /close HTTP/1.1\r\n\r\n", 64, 0);
+
+   CHECK_STRING("closed", response);
+   free(response);
+
+   response = send_request("GET / HTTP/1.1\r\n\r\n", 64, 0);
+   CHECK_STRING("ok", response);
+   free(response);
+   CHECK_EQUAL(2, server->connections);
+   close_http_server_connection();
+}
+
+static void test_long_body_is_truncated(local_server_t *server) {
+   (void) server;
+
+   char *response = send_request("GET / HTTP/1.1\r\n\r\n", 2, 0);
+
+   CHECK_STRING("o", response);
+   free(response);
+   close_http_server_connection();
+}
+
+static void test_dropped_connection_is_retried(local_server_t *server) {
+   char *response = send_request("GET / HTTP/1.1\r\n\r\n", 64, 0);
+
+   CHECK_STRING("ok", response);
+   free(response);
+
+   unsigned int connections = server->connections;
+   unsigned int requests = server->requests;
+   unsigned int reconnections = get_http_connection_statistics().reconnections;
+   bool *drop_next_request = (bool *) server->context;
+
+   *drop_next_request = true;
+   response = send_request("GET / HTTP/1.1\r\n\r\n", 64, 0);
+   CHECK_STRING("ok", response);
+   free(response);
+   CHECK_EQUAL(connections + 1, server->connections);
+   CHECK_EQUAL(requests + 2, server->requests);
+   CHECK_EQUAL(reconnections + 1, get_http_connection_statistics().reconnections);
+
+   // A new connection dropped by the server isn't retried
+   close_http_server_connection();
+   *drop_next_request = true;
+   CHECK(send_request("GET / HTTP/1.1\r\n\r\n", 64, 0) == NULL);
+   CHECK_EQUAL(requests + 3, server->requests);
+   close_http_server_connection();
+}
+
+/**
+ * writev() writes only a part of the request, the rest has to be written by further calls
+ */
+static void test_short_writes_are_continued(local_server_t *server) {
+   static const char EXPECTED_REQUEST[] = "POST / HTTP/1.1\r\nContent-Length: 13\r\n\r\n{\"status\":1}\n";
+   static const char *const FRAGMENTS[] = {"POST / HTTP/1.1\r\n", "Content-Length: 13\r\n\r\n", "", "{\"status\":1}\n"};
+   struct iovec fragments[sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0])];
+
+   for (unsigned int i = 0; i < sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]); i++) {
+      fragments[i].iov_base = (void *) FRAGMENTS[i];
+      fragments[i].iov_len = strlen(FRAGMENTS[i]);
+   }
+
+   for (size_t max_writev_size = 1; max_writev_size <= 20; max_writev_size += 3) {
+      shim_set_max_writev_size(max_writev_size);
+      char *response = send_request_fragments(fragments, sizeof(fragments) / sizeof(fragments[0]), 64, 0);
+      shim_set_max_writev_size(0);
+
+      CHECK_STRING("ok", response);
+      CHECK_STRING(EXPECTED_REQUEST, server->last_request);
+      free(response);
+   }
+   close_http_server_connection();
+}
+
+int main() {
+   local_server_t server;
+
+   test_string_helpers();
+   test_rtc_memory();
+
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+   CHECK(is_connected_to_wifi());
+
+   bool drop_next_request = false;
+
+   CHECK(local_server_start(&server, respond, &drop_next_request));
+   shim_server_port = server.port;
+   test_requests(&server);
+   test_long_body_is_truncated(&server);
+   test_dropped_connection_is_retried(&server);
+   test_short_writes_are_continued(&server);
+   local_server_stop(&server);
+   return TEST_RESULT();
+}
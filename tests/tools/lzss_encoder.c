@@ -0,0 +1,113 @@
+#include <string.h>
+#include "lzss_encoder.h"
+
+#define MAX_MATCH_LENGTH  (LZSS_MIN_MATCH_LENGTH + 0x0F)
+#define MAX_DISTANCE      LZSS_BLOCK_SIZE
+#define HASH_SIZE         4096
+#define MAX_CHAIN_LENGTH  128
+#define NO_POSITION       0xFFFF
+
+static unsigned int hash_position(const unsigned char *data) {
+   return ((data[0] << 8) ^ (data[1] << 4) ^ data[2]) & (HASH_SIZE - 1);
+}
+
+static void write_u16(unsigned char *output, unsigned int value) {
+   output[0] = value & 0xFF;
+   output[1] = (value >> 8) & 0xFF;
+}
+
+/**
+ * Compresses one block, the positions are within the block. Returns the payload length.
+ */
+static size_t encode_block(const unsigned char *block, size_t block_length, unsigned char *payload) {
+   static unsigned short head[HASH_SIZE];
+   static unsigned short previous[LZSS_BLOCK_SIZE];
+   size_t payload_length = 0;
+   size_t flags_position = 0;
+   unsigned char items_amount = 8;
+
+   memset(head, 0xFF, sizeof(head));
+
+   for (size_t position = 0; position < block_length;) {
+      size_t best_length = 0;
+      size_t best_distance = 0;
+
+      if (position + LZSS_MIN_MATCH_LENGTH <= block_length) {
+         size_t max_length = block_length - position < MAX_MATCH_LENGTH ? block_length - position : MAX_MATCH_LENGTH;
+         unsigned short candidate = head[hash_position(block + position)];
+
+         for (unsigned int chain = 0; candidate != NO_POSITION && chain < MAX_CHAIN_LENGTH; chain++) {
+            size_t length = 0;
+
+            while (length < max_length && block[candidate + length] == block[position + length]) {
+               length++;
+            }
+            if (length > best_length) {
+               best_length = length;
+               best_distance = position - candidate;
+               if (length == max_length) {
+                  break;
+               }
+            }
+            candidate = previous[candidate];
+         }
+      }
+
+      if (items_amount == 8) {
+         flags_position = payload_length++;
+         payload[flags_position] = 0;
+         items_amount = 0;
+      }
+
+      size_t item_length;
+
+      if (best_length >= LZSS_MIN_MATCH_LENGTH) {
+         unsigned int distance = best_distance - 1;
+
+         payload[payload_length++] = distance & 0xFF;
+         payload[payload_length++] = ((distance >> 8) << 4) | (best_length - LZSS_MIN_MATCH_LENGTH);
+         item_length = best_length;
+      } else {
+         payload[flags_position] |= 1 << items_amount;
+         payload[payload_length++] = block[position];
+         item_length = 1;
+      }
+      items_amount++;
+
+      for (size_t end = position + item_length; position < end; position++) {
+         if (position + LZSS_MIN_MATCH_LENGTH <= block_length) {
+            unsigned int hash = hash_position(block + position);
+
+            previous[position] = head[hash];
+            head[hash] = position;
+         }
+      }
+   }
+   return payload_length;
+}
+
+size_t lzss_encode(const unsigned char *image, size_t image_length, unsigned char *output) {
+   // Worst case of a block: a flags byte per 8 literals
+   static unsigned char payload[LZSS_BLOCK_SIZE + LZSS_BLOCK_SIZE / 8 + 1];
+   size_t output_length = LZSS_FILE_HEADER_SIZE;
+
+   memcpy(output, LZSS_MAGIC, 4);
+   write_u16(output + 4, image_length & 0xFFFF);
+   write_u16(output + 6, image_length >> 16);
+
+   for (size_t offset = 0; offset < image_length; offset += LZSS_BLOCK_SIZE) {
+      size_t block_length = image_length - offset < LZSS_BLOCK_SIZE ? image_length - offset : LZSS_BLOCK_SIZE;
+      size_t payload_length = encode_block(image + offset, block_length, payload);
+
+      if (payload_length < block_length) {
+         write_u16(output + output_length, payload_length);
+         memcpy(output + output_length + LZSS_BLOCK_HEADER_SIZE, payload, payload_length);
+      } else {
+         payload_length = block_length;
+         write_u16(output + output_length, payload_length | LZSS_STORED_BLOCK_FLAG);
+         memcpy(output + output_length + LZSS_BLOCK_HEADER_SIZE, image + offset, payload_length);
+      }
+      output_length += LZSS_BLOCK_HEADER_SIZE + payload_length;
+   }
+   return output_length;
+}
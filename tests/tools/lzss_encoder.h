@@ -0,0 +1,19 @@
+#include <stddef.h>
+#include "lzss_decoder.h"
+
+#ifndef LZSS_ENCODER_HEADER
+#define LZSS_ENCODER_HEADER
+
+// Every block is stored, if it doesn't compress
+#define LZSS_ENCODED_BOUND(image_length) (LZSS_FILE_HEADER_SIZE + (image_length) + \
+      ((image_length) / LZSS_BLOCK_SIZE + 1) * LZSS_BLOCK_HEADER_SIZE)
+
+/**
+ * Packs the image into the LZS1 format of lzss_decoder.h. Matches are searched greedily in the current block, a block
+ * which doesn't get shorter is stored.
+ *
+ * Returns the length of the packed file, "output" must have LZSS_ENCODED_BOUND(image_length) bytes.
+ */
+size_t lzss_encode(const unsigned char *image, size_t image_length, unsigned char *output);
+
+#endif
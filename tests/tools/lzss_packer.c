@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "lzss_encoder.h"
+
+/**
+ * Packs the firmware for the USE_COMPRESSED_FIRMWARE update:
+ *
+ *   lzss_packer build/ESP8266_temp_and_humidity.bin firmware.bin.lzs
+ *
+ * The server also needs X-Firmware-SHA256 of the original (not packed) image.
+ */
+int main(int argc, char *argv[]) {
+   if (argc != 3) {
+      fprintf(stderr, "Usage: %s <firmware.bin> <firmware.bin.lzs>\n", argv[0]);
+      return 2;
+   }
+
+   FILE *input = fopen(argv[1], "rb");
+
+   if (input == NULL) {
+      perror(argv[1]);
+      return 1;
+   }
+   fseek(input, 0, SEEK_END);
+   long image_length = ftell(input);
+   fseek(input, 0, SEEK_SET);
+
+   unsigned char *image = malloc(image_length > 0 ? image_length : 1);
+   unsigned char *packed = malloc(LZSS_ENCODED_BOUND((size_t) image_length));
+
+   if (image_length <= 0 || image == NULL || packed == NULL ||
+         fread(image, 1, image_length, input) != (size_t) image_length) {
+      fprintf(stderr, "%s can't be read\n", argv[1]);
+      fclose(input);
+      return 1;
+   }
+   fclose(input);
+
+   size_t packed_length = lzss_encode(image, image_length, packed);
+   FILE *output = fopen(argv[2], "wb");
+
+   if (output == NULL || fwrite(packed, 1, packed_length, output) != packed_length) {
+      perror(argv[2]);
+      return 1;
+   }
+   fclose(output);
+
+   printf("%s: %ld -> %zu bytes (%.1f%%)\n", argv[2], image_length, packed_length,
+         packed_length * 100.0 / image_length);
+   free(image);
+   free(packed);
+   return 0;
+}
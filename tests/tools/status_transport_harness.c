@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+#include "status_record.h"
+#include "local_server.h"
+#include "udp_receiver.h"
+#include "host_shims.h"
+
+#define REPORTS_AMOUNT            500
+#define REPLY_TIMEOUT_MS          50
+#define MAX_RESULTS               8
+
+/**
+ * Compares the HTTP POST status report with the UDP datagram (USE_UDP_STATUS_REPORTS) over the loopback:
+ *
+ *   status_transport_harness [results file]
+ *
+ * Latency is measured from the start of sending to the server's response or reply. HTTP runs with a new connection
+ * per report and with the kept alive one. UDP runs with the receiver dropping 0, 5 and 20 percent of the datagrams:
+ * the device sees a lost datagram as an unconfirmed report after REPLY_TIMEOUT_MS, the collector as a gap in the
+ * sequence numbers. The loopback doesn't lose TCP segments, so the retransmission cost of HTTP isn't included.
+ */
+
+typedef struct {
+   char name[48];
+   unsigned int reports;
+   unsigned int confirmed;
+   unsigned int lost_detected;
+   double bytes_per_report;
+   double latency_mean_us;
+   double latency_p50_us;
+   double latency_p99_us;
+   double latency_max_us;
+} transport_result_t;
+
+static const char STATUS_PAYLOAD[] = "{\"gain\":\"-67\",\"deviceName\":\"Bedroom\",\"errors\":0,"
+      "\"pendingConnectionErrors\":0,\"uptime\":3600,\"buildTimestamp\":\"\",\"freeHeapSpace\":38000,"
+      "\"resetReason\":\"\",\"systemRestartReason\":\"\",\"temperature\":26.07,\"temperatureRaw\":27196,"
+      "\"humidity\":54.79,\"light\":null}";
+static const char KEEP_ALIVE_RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 19\r\n"
+      "\r\n{\"statusCode\":\"OK\"}";
+static const char CLOSE_RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 19\r\n"
+      "Connection: close\r\n\r\n{\"statusCode\":\"OK\"}";
+
+static status_record_t record_g = {
+   .signal_strength = -67,
+   .uptime = 3600,
+   .free_heap_space = 38000,
+   .temperature = 2607,
+   .temperature_raw = 27196,
+   .humidity = 5479,
+   .samples_amount = 60,
+   .device_name = "Bedroom"
+};
+
+static transport_result_t results_g[MAX_RESULTS];
+static unsigned int results_amount_g;
+
+static void on_wifi_event() {
+}
+
+static bool respond(local_server_t *server, int socket_id, const char *request) {
+   bool keep_alive = *(bool *) server->context;
+   const char *response = keep_alive ? KEEP_ALIVE_RESPONSE : CLOSE_RESPONSE;
+
+   (void) request;
+   local_server_write(socket_id, response, strlen(response), 0);
+   return keep_alive;
+}
+
+static double get_time_us() {
+   struct timespec time;
+
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000.0 + time.tv_nsec / 1000.0;
+}
+
+static int compare_latencies(const void *latency1, const void *latency2) {
+   double difference = *(const double *) latency1 - *(const double *) latency2;
+
+   return difference < 0 ? -1 : difference > 0;
+}
+
+static transport_result_t *add_result(const char *name, double latencies_us[], unsigned int reports) {
+   transport_result_t *result = &results_g[results_amount_g++];
+   double total_us = 0;
+
+   memset(result, 0, sizeof(transport_result_t));
+   snprintf(result->name, sizeof(result->name), "%s", name);
+   result->reports = reports;
+
+   for (unsigned int i = 0; i < reports; i++) {
+      total_us += latencies_us[i];
+   }
+   qsort(latencies_us, reports, sizeof(double), compare_latencies);
+   result->latency_mean_us = total_us / reports;
+   result->latency_p50_us = latencies_us[reports / 2];
+   result->latency_p99_us = latencies_us[reports * 99 / 100];
+   result->latency_max_us = latencies_us[reports - 1];
+   return result;
+}
+
+static void run_http(bool keep_alive) {
+   static double latencies_us[REPORTS_AMOUNT];
+   char request[1024];
+   unsigned int confirmed = 0;
+   int request_length = snprintf(request, sizeof(request), "POST /server/esp8266/statusInfo HTTP/1.1\r\n"
+         "Content-Length: %zu\r\nHost: 127.0.0.1\r\nUser-Agent: ESP8266\r\nContent-Type: application/json\r\n"
+         "Connection: keep-alive\r\n\r\n%s", strlen(STATUS_PAYLOAD), STATUS_PAYLOAD);
+
+   for (unsigned int i = 0; i < REPORTS_AMOUNT; i++) {
+      double start_us = get_time_us();
+      char *response = send_request(request, 64, 0);
+
+      latencies_us[i] = get_time_us() - start_us;
+      confirmed += response != NULL && strstr(response, "\"OK\"") != NULL;
+      free(response);
+   }
+   close_http_server_connection();
+
+   transport_result_t *result = add_result(keep_alive ? "http/keep_alive" : "http/connection_per_report",
+         latencies_us, REPORTS_AMOUNT);
+
+   result->confirmed = confirmed;
+   result->bytes_per_report = request_length + strlen(keep_alive ? KEEP_ALIVE_RESPONSE : CLOSE_RESPONSE);
+}
+
+static void run_udp(udp_receiver_t *receiver, unsigned int drop_percent, unsigned int *sequence) {
+   static double latencies_us[REPORTS_AMOUNT];
+   unsigned char datagram[STATUS_DATAGRAM_HEADER_SIZE + STATUS_RECORD_FIXED_PART_SIZE + 256];
+   unsigned char reply[STATUS_DATAGRAM_REPLY_SIZE];
+   unsigned int confirmed = 0;
+   unsigned short datagram_length = 0;
+   char name[48];
+   udp_receiver_statistics_t statistics_before = udp_receiver_get_statistics(receiver);
+
+   udp_receiver_set_drop_percent(receiver, drop_percent);
+   for (unsigned int i = 0; i < REPORTS_AMOUNT; i++) {
+      unsigned int current_sequence = (*sequence)++;
+      unsigned char commands;
+      double start_us = get_time_us();
+
+      datagram_length = encode_status_datagram(&record_g, current_sequence, datagram, sizeof(datagram));
+      int reply_length = send_datagram(datagram, datagram_length, reply, sizeof(reply), REPLY_TIMEOUT_MS);
+
+      latencies_us[i] = get_time_us() - start_us;
+      confirmed += reply_length > 0 && decode_status_datagram_reply(reply, reply_length, current_sequence, &commands);
+   }
+   // A datagram is detected as lost, when a later one arrives
+   udp_receiver_set_drop_percent(receiver, 0);
+   send_datagram(datagram, encode_status_datagram(&record_g, (*sequence)++, datagram, sizeof(datagram)), reply,
+         sizeof(reply), REPLY_TIMEOUT_MS);
+
+   snprintf(name, sizeof(name), "udp/drop=%u%%", drop_percent);
+   transport_result_t *result = add_result(name, latencies_us, REPORTS_AMOUNT);
+
+   result->confirmed = confirmed;
+   result->lost_detected = udp_receiver_get_statistics(receiver).lost - statistics_before.lost;
+   result->bytes_per_report = datagram_length + STATUS_DATAGRAM_REPLY_SIZE;
+}
+
+static bool write_results(const char *file_name) {
+   FILE *file = fopen(file_name, "w");
+
+   if (file == NULL) {
+      return false;
+   }
+   fprintf(file, "{\"reports\":[\n");
+   for (unsigned int i = 0; i < results_amount_g; i++) {
+      const transport_result_t *result = &results_g[i];
+
+      fprintf(file, "  {\"name\":\"%s\",\"reports\":%u,\"confirmed\":%u,\"lost_detected\":%u,"
+            "\"bytes_per_report\":%.0f,\"latency_mean_us\":%.1f,\"latency_p50_us\":%.1f,\"latency_p99_us\":%.1f,"
+            "\"latency_max_us\":%.1f}%s\n", result->name, result->reports, result->confirmed, result->lost_detected,
+            result->bytes_per_report, result->latency_mean_us, result->latency_p50_us, result->latency_p99_us,
+            result->latency_max_us, i + 1 < results_amount_g ? "," : "");
+   }
+   fprintf(file, "]}\n");
+   return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[]) {
+   static const unsigned int DROP_PERCENTS[] = {0, 5, 20};
+   local_server_t server;
+   udp_receiver_t receiver;
+   bool keep_alive = false;
+   unsigned int sequence = 0;
+
+   wifi_init_sta(on_wifi_event, on_wifi_event, on_wifi_event);
+   if (!local_server_start(&server, respond, &keep_alive) || !udp_receiver_start(&receiver, 0, 14)) {
+      fprintf(stderr, "Local servers can't be started\n");
+      return 1;
+   }
+   shim_server_port = server.port;
+   shim_server_udp_port = receiver.port;
+
+   run_http(false);
+   keep_alive = true;
+   run_http(true);
+   for (unsigned int i = 0; i < sizeof(DROP_PERCENTS) / sizeof(DROP_PERCENTS[0]); i++) {
+      run_udp(&receiver, DROP_PERCENTS[i], &sequence);
+   }
+
+   udp_receiver_stop(&receiver);
+   local_server_stop(&server);
+
+   printf("%-28s %9s %9s %6s %10s %10s %10s %10s\n", "transport", "confirmed", "lost_seen", "bytes", "mean_us",
+         "p50_us", "p99_us", "max_us");
+   for (unsigned int i = 0; i < results_amount_g; i++) {
+      const transport_result_t *result = &results_g[i];
+
+      printf("%-28s %5u/%-3u %9u %6.0f %10.1f %10.1f %10.1f %10.1f\n", result->name, result->confirmed,
+            result->reports, result->lost_detected, result->bytes_per_report, result->latency_mean_us,
+            result->latency_p50_us, result->latency_p99_us, result->latency_max_us);
+   }
+
+   if (argc > 1 && !write_results(argv[1])) {
+      perror(argv[1]);
+      return 1;
+   }
+   return 0;
+}